@@ -517,14 +517,95 @@ static void delete(chunk *c)
 }
 
 # define DSMALL		64
-# define DLIMIT		(DSMALL + MOFFSET)
-# define DCHUNKS	(DSMALL / STRUCT_AL - 1)
+# define DSLAB		1024
+# define DLIMIT		(DSLAB + MOFFSET + STRUCT_AL)
+# define DSPLIT		(DSMALL + MOFFSET + SIZETSIZE)
+# define DCLASSES	(DSMALL / STRUCT_AL + 16)
+# define DINDEX(size)	(((size) - MOFFSET) / STRUCT_AL - 1)
 # define DCHUNKSZ	32768
 
-static char *dlist;		/* list of dynamic memory chunks */
-static chunk *dchunks[DCHUNKS];	/* list of free small chunks */
+typedef struct _dblock_ {
+    struct _dblock_ *next;	/* next in list */
+    size_t size;		/* size of memory block */
+    bool mapped;		/* mapped rather than allocated */
+    bool released;		/* pages returned to the OS */
+} dblock;
+
+# define DBLOCKSIZE	ALGN(sizeof(dblock), STRUCT_AL)
+
+static dblock *dlist;		/* list of dynamic memory chunks */
+static int dmode;		/* 0: malloc, 1: mmap, 2: mmap + huge pages */
+static size_t dreleased;	/* free dynamic memory at last scan, or less */
+static chunk *dchunks[DCLASSES];/* lists of free small chunks, per class */
+static Uint dcsize[DCLASSES];	/* chunk size of each class */
+static unsigned char dclass[DSLAB / STRUCT_AL];	/* chunk size -> class */
+static int ndclasses;		/* # size classes */
 static chunk *dchunk;		/* chunk of small chunks */
 
+/*
+ * NAME:	dclasses()
+ * DESCRIPTION:	initialize the small chunk size classes: exact sizes up to
+ *		DSMALL, four classes per power of two above that
+ */
+static void dclasses()
+{
+    Uint size, step;
+    int i, n;
+
+    i = n = 0;
+    step = STRUCT_AL;
+    for (size = STRUCT_AL; size <= DSLAB; size += step) {
+	if (size >= DSMALL && (size & (size - 1)) == 0) {
+	    step = size / 4;
+	}
+	dcsize[n] = size + MOFFSET;
+	while (i < DSLAB / STRUCT_AL && (i + 1) * STRUCT_AL <= size) {
+	    dclass[i++] = n;
+	}
+	n++;
+    }
+    ndclasses = n;
+}
+
+/*
+ * NAME:	dnewmem()
+ * DESCRIPTION:	allocate a new block of dynamic memory
+ */
+static char *dnewmem(size_t size)
+{
+    dblock *mem;
+
+    size += DBLOCKSIZE;
+    if (dmode != 0) {
+	mem = (dblock *) P_mmap(size, dmode == 2);
+	if (mem == (dblock *) NULL) {
+	    fatal("out of memory");
+	}
+	mem->mapped = TRUE;
+    } else {
+	mem = (dblock *) newmem(size, (char **) NULL);
+	mem->mapped = FALSE;
+    }
+    mem->size = size;
+    mem->released = FALSE;
+    mem->next = dlist;
+    dlist = mem;
+    return (char *) mem + DBLOCKSIZE;
+}
+
+/*
+ * NAME:	dfreemem()
+ * DESCRIPTION:	free a block of dynamic memory
+ */
+static void dfreemem(dblock *mem)
+{
+    if (mem->mapped) {
+	P_munmap((char *) mem, mem->size);
+    } else {
+	free((char *) mem);
+    }
+}
+
 /*
  * NAME:	dalloc()
  * DESCRIPTION:	allocate dynamic memory
@@ -546,14 +627,30 @@ static chunk *dalloc(size_t size)
     dmem = TRUE;
 
     if (size < DLIMIT) {
+	int i;
+
 	/*
 	 * small chunk
 	 */
-	if ((c=dchunks[(size - MOFFSET) / STRUCT_AL - 1]) != (chunk *) NULL) {
+	i = dclass[DINDEX(size)];
+	if ((c=dchunks[i]) != (chunk *) NULL) {
 	    /* small chunk from free list */
-	    dchunks[(size - MOFFSET) / STRUCT_AL - 1] = c->next;
+	    dchunks[i] = c->next;
 	    return c;
 	}
+	size = dcsize[i];
+	if (dchunk != (chunk *) NULL && dchunk->size < size) {
+	    /* put what is left in the free list of the largest class it fits */
+	    sz = dchunk->size;
+	    i = (sz < DLIMIT) ? dclass[DINDEX(sz)] : ndclasses - 1;
+	    if (dcsize[i] > sz) {
+		--i;
+	    }
+	    dchunk->size = dcsize[i];
+	    dchunk->next = dchunks[i];
+	    dchunks[i] = dchunk;
+	    dchunk = (chunk *) NULL;
+	}
 	if (dchunk == (chunk *) NULL) {
 	    /* get new chunks chunk */
 	    dchunk = dalloc(DCHUNKSZ);	/* cannot use alloc() here */
@@ -565,7 +662,7 @@ static chunk *dalloc(size_t size)
 	sz = dchunk->size - size;
 	c = dchunk;
 	c->size = size;
-	if (sz >= DLIMIT - STRUCT_AL) {
+	if (sz >= dcsize[0]) {
 	    /* enough is left for another small chunk */
 	    dchunk = (chunk *) ((char *) c + size);
 	    dchunk->size = sz;
@@ -583,12 +680,16 @@ static chunk *dalloc(size_t size)
 	 * remove from free list
 	 */
 	delete(c);
+	if (*(size_t *) ((char *) c - SIZETSIZE) == 0) {
+	    /* first in its block, which may have been released */
+	    ((dblock *) ((char *) c - SIZETSIZE - DBLOCKSIZE))->released = FALSE;
+	}
     } else {
 	/*
 	 * get new dynamic chunk
 	 */
 	for (sz = dchunksz; sz < size + SIZETSIZE + UINTSIZE; sz += dchunksz) ;
-	p = newmem(sz, &dlist);
+	p = dnewmem(sz);
 	mstat.dmemsize += sz;
 
 	/* no previous chunk */
@@ -603,7 +704,7 @@ static chunk *dalloc(size_t size)
 	((chunk *) p)->size = 0;
     }
 
-    if ((sz=c->size - size) >= DLIMIT + SIZETSIZE) {
+    if ((sz=c->size - size) >= DSPLIT) {
 	/*
 	 * split block, put second part in free list
 	 */
@@ -640,8 +741,8 @@ static void dfree(chunk *c)
 
     if (c->size < DLIMIT) {
 	/* small chunk */
-	c->next = dchunks[(c->size - MOFFSET) / STRUCT_AL - 1];
-	dchunks[(c->size - MOFFSET) / STRUCT_AL - 1] = c;
+	c->next = dchunks[dclass[DINDEX(c->size)]];
+	dchunks[dclass[DINDEX(c->size)]] = c;
 	return;
     }
 
@@ -687,10 +788,14 @@ static void dfree(chunk *c)
  * NAME:	mem->init()
  * DESCRIPTION:	initialize memory manager
  */
-void m_init(size_t ssz, size_t dsz)
+void m_init(size_t ssz, size_t dsz, int mode)
 {
     schunksz = ALGN(ssz, STRUCT_AL);
     dchunksz = ALGN(dsz, STRUCT_AL);
+    dmode = mode;
+    if (ndclasses == 0) {
+	dclasses();
+    }
     if (schunksz != 0) {
 	if (schunk != (chunk *) NULL) {
 	    schunk->next = sflist;
@@ -900,11 +1005,12 @@ bool m_check()
  */
 void m_purge()
 {
-    char *p;
+    dblock *mem;
 
 # ifdef DEBUG
     while (hlist != (header *) NULL) {
 	char buf[160];
+	char *p;
 	size_t n;
 
 	n = (hlist->size & SIZE_MASK) - MOFFSET;
@@ -931,11 +1037,12 @@ void m_purge()
 # endif
 
     /* purge dynamic memory */
-    while (dlist != (char *) NULL) {
-	p = dlist;
-	dlist = *(char **) p;
-	free(p);
+    while (dlist != (dblock *) NULL) {
+	mem = dlist;
+	dlist = mem->next;
+	dfreemem(mem);
     }
+    dreleased = 0;
     memset(dchunks, '\0', sizeof(dchunks));
     dchunk = (chunk *) NULL;
     dtree = (spnode *) NULL;
@@ -955,6 +1062,41 @@ void m_purge()
     }
 }
 
+/*
+ * NAME:	mem->release()
+ * DESCRIPTION:	return the pages of mapped dynamic memory blocks that are
+ *		entirely free to the OS
+ */
+void m_release()
+{
+    dblock *mem;
+    chunk *c;
+    size_t size;
+
+    size = mstat.dmemsize - mstat.dmemused;
+    if (size < dreleased) {
+	/* pages freed from here on have not been looked at */
+	dreleased = size;
+    }
+    if (dmode == 0 || size < dreleased + dchunksz) {
+	/* not worth the trouble */
+	return;
+    }
+    dreleased = size;
+
+    for (mem = dlist; mem != (dblock *) NULL; mem = mem->next) {
+	if (mem->mapped && !mem->released) {
+	    c = (chunk *) ((char *) mem + DBLOCKSIZE + SIZETSIZE);
+	    if (c->size == mem->size - DBLOCKSIZE - SIZETSIZE - UINTSIZE) {
+		/* one free chunk spanning the whole block */
+		P_mrelease((char *) c + sizeof(spnode),
+			   c->size - sizeof(spnode) - SIZETSIZE);
+		mem->released = TRUE;
+	    }
+	}
+    }
+}
+
 /*
  * NAME:	mem->info()
  * DESCRIPTION:	return information about memory usage
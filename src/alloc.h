@@ -45,12 +45,13 @@ extern char *m_realloc	(char*, size_t, size_t);
 
 # define FREE(mem)	m_free((char *) (mem))
 
-extern void  m_init	(size_t, size_t);
+extern void  m_init	(size_t, size_t, int);
 extern void  m_free	(char*);
 extern void  m_dynamic	(void);
 extern void  m_static	(void);
 extern bool  m_check	(void);
 extern void  m_purge	(void);
+extern void  m_release	(void);
 extern void  m_finish	(void);
 
 typedef struct {
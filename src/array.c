@@ -18,6 +18,7 @@
  */
 
 # include "dgd.h"
+# include "hash.h"
 # include "str.h"
 # include "array.h"
 # include "object.h"
@@ -26,6 +27,16 @@
 # include "data.h"
 
 # define ARR_CHUNK	128
+# define SET_HASHMIN	8	/* smallest set searched with a hash table */
+
+# if ASIZET_MAX > USHRT_MAX
+/* temporary copies of large arrays are kept off the stack */
+# define TALLOC(type, size)	ALLOC(type, (size) + 1)
+# define TFREE(ptr)		FREE(ptr)
+# else
+# define TALLOC(type, size)	ALLOCA(type, size)
+# define TFREE(ptr)		AFREE(ptr)
+# endif
 
 typedef struct _arrchunk_ {
     struct _arrchunk_ *next;	/* next in list */
@@ -33,7 +44,7 @@ typedef struct _arrchunk_ {
 } arrchunk;
 
 typedef struct _arrh_ {
-    struct _arrh_ *next;	/* next in hash table chain */
+    hte chain;			/* hash table chain */
     array *arr;			/* array entry */
     Uint index;			/* building index */
     struct _arrh_ *link;	/* next in list */
@@ -47,11 +58,10 @@ typedef struct _arrhchunk_ {
 # define MELT_CHUNK	128
 
 typedef struct _mapelt_ {
-    Uint hashval;		/* hash value of index */
     bool add;			/* new element? */
     value idx;			/* index */
     value val;			/* value */
-    struct _mapelt_ *next;	/* next in hash table */
+    struct _mapelt_ *next;	/* next in free list */
 } mapelt;
 
 typedef struct _meltchunk_ {
@@ -59,21 +69,45 @@ typedef struct _meltchunk_ {
     mapelt e[MELT_CHUNK];	/* chunk of mapelt entries */
 } meltchunk;
 
+typedef struct {
+    Uint hashval;		/* hash value of index */
+    mapelt *elt;		/* element, empty or deleted */
+} mapslot;
+
 typedef struct _maphash_ {
-    unsigned short size;	/* # elements in hash table */
-    unsigned short sizemod;	/* mapping size modification */
-    Uint tablesize;		/* actual hash table size */
-    mapelt *table[1];		/* hash table */
+    asizet size;		/* # elements in hash table */
+    asizet sizemod;		/* mapping size modification */
+    Uint tablesize;		/* actual hash table size, a power of 2 */
+    Uint ndeleted;		/* # deleted slots */
+    mapslot table[1];		/* open addressing hash table */
 } maphash;
 
 # define MTABLE_SIZE	16	/* most mappings are quite small */
+# define MELT_DELETED	((mapelt *) &meltdeleted)
+# define MELT_USED(e)	((e) != (mapelt *) NULL && (e) != MELT_DELETED)
+
+typedef struct {
+    Uint hashval;		/* hash value of element */
+    value *val;			/* element, or NULL */
+} setslot;
+
+typedef struct {
+    value *elts;		/* elements */
+    asizet size;		/* # elements */
+    Uint mask;			/* hash table size - 1 */
+    setslot *table;		/* hash table, or NULL for a linear search */
+} valset;
 
 # define ABCHUNKSZ	32
 
 typedef struct arrbak {
     array *arr;			/* array backed up */
-    unsigned short size;	/* original size (of mapping) */
-    value *original;		/* original elements */
+    asizet size;		/* original size (of mapping), or index */
+    bool single;		/* single element backed up? */
+    union {
+	value *elts;		/* original elements */
+	value elt;		/* original element */
+    } original;
     dataplane *plane;		/* original dataplane */
 } arrbak;
 
@@ -89,12 +123,13 @@ static arrchunk *aclist;	/* linked list of all array chunks */
 static int achunksz;		/* size of current array chunk */
 static array *flist;		/* free array list */
 static mapelt *fmelt;		/* free mapelt list */
+static char meltdeleted;	/* marks a deleted hash table slot */
 static meltchunk *meltlist;	/* linked list of all mapelt chunks */
 static int meltchunksz;		/* size of current mapelt chunk */
 static arrh *alink;		/* linked list of merged arrays */
 static arrhchunk *ahlist;	/* linked list of all arrh chunks */
 static int ahchunksz;		/* size of current arrh chunk */
-static arrh *aht[ARRMERGETABSZ];/* array merge table */
+static hashtab *aht;		/* array merge table */
 
 /*
  * NAME:	array->init()
@@ -139,6 +174,7 @@ array *arr_alloc(unsigned int size)
     a->size = size;
     a->hashmod = FALSE;
     a->elts = (value *) NULL;
+    a->packed = (char *) NULL;
     a->ref = 0;
     a->odcount = 0;			/* if swapped in, check objects */
     a->hashed = (maphash *) NULL;	/* only used for mappings */
@@ -157,7 +193,7 @@ array *arr_new(dataspace *data, long size)
     if (size > max_size) {
 	error("Array too large");
     }
-    a = arr_alloc((unsigned short) size);
+    a = arr_alloc((asizet) size);
     if (size > 0) {
 	a->elts = ALLOC(value, size);
     }
@@ -189,6 +225,90 @@ array *arr_ext_new(dataspace *data, long size)
     return a;
 }
 
+/*
+ * NAME:	array->new_packed()
+ * DESCRIPTION:	create a new packed array of ints or floats, all zero
+ */
+array *arr_new_packed(dataspace *data, long size, int type)
+{
+    array *a;
+
+    a = arr_new(data, 0L);
+    if (size > max_size) {
+	error("Array too large");
+    }
+    if (size > 0) {
+	a->size = size;
+	a->ptype = type;
+	a->packed = ALLOC(char, PKD_SIZE(type, size));
+	memset(a->packed, '\0', PKD_SIZE(type, size));
+    }
+    return a;
+}
+
+/*
+ * NAME:	array->unpack()
+ * DESCRIPTION:	replace the packed elements of an array by values
+ */
+void arr_unpack(array *a)
+{
+    value *v;
+    asizet i;
+
+    v = a->elts = ALLOC(value, a->size);
+    for (i = 0; i < a->size; i++, v++) {
+	arr_get_packed(a, i, v);
+	v->modified = TRUE;
+    }
+    FREE(a->packed);
+    a->packed = (char *) NULL;
+}
+
+/*
+ * NAME:	array->get_packed()
+ * DESCRIPTION:	get an element of a packed array
+ */
+void arr_get_packed(array *a, asizet idx, value *v)
+{
+    if (a->ptype == T_INT) {
+	PUT_INTVAL(v, PKD_INTS(a)[idx]);
+    } else {
+	v->oindex = PKD_HIGHS(a)[idx];
+	v->u.objcnt = PKD_LOWS(a)[idx];
+	v->type = T_FLOAT;
+    }
+}
+
+/*
+ * NAME:	array->put_packed()
+ * DESCRIPTION:	put an int or float in a packed array of the same type
+ */
+void arr_put_packed(array *a, asizet idx, value *v)
+{
+    if (a->ptype == T_INT) {
+	PKD_INTS(a)[idx] = v->u.number;
+    } else {
+	PKD_HIGHS(a)[idx] = v->oindex;
+	PKD_LOWS(a)[idx] = v->u.objcnt;
+    }
+}
+
+/*
+ * NAME:	pkdcopy()
+ * DESCRIPTION:	copy elements from one packed array to another of the same
+ *		type
+ */
+static void pkdcopy(array *a1, asizet idx1, array *a2, asizet idx2, asizet n)
+{
+    if (a1->ptype == T_INT) {
+	memcpy(PKD_INTS(a1) + idx1, PKD_INTS(a2) + idx2, n * sizeof(Int));
+    } else {
+	memcpy(PKD_LOWS(a1) + idx1, PKD_LOWS(a2) + idx2, n * sizeof(Uint));
+	memcpy(PKD_HIGHS(a1) + idx1, PKD_HIGHS(a2) + idx2,
+	       n * sizeof(unsigned short));
+    }
+}
+
 /*
  * NAME:	array->del()
  * DESCRIPTION:	remove a reference from an array or mapping.  If none are
@@ -198,7 +318,7 @@ void arr_del(array *a)
 {
     if (--(a->ref) == 0) {
 	value *v;
-	unsigned short i;
+	asizet i;
 	static array *dlist;
 
 	a->prev->next = a->next;
@@ -217,21 +337,23 @@ void arr_del(array *a)
 		    i_del_value(v++);
 		}
 		FREE(a->elts);
+	    } else if (a->packed != (char *) NULL) {
+		FREE(a->packed);
 	    }
 
 	    if (a->hashed != (maphash *) NULL) {
-		mapelt *e, *n, **t;
+		mapelt *e;
+		mapslot *t;
 
 		/*
 		 * delete the hashtable of a mapping
 		 */
 		for (i = a->hashed->size, t = a->hashed->table; i > 0; t++) {
-		    for (e = *t; e != (mapelt *) NULL; e = n) {
+		    if (MELT_USED(e = t->elt)) {
 			if (e->add) {
 			    i_del_value(&e->idx);
 			    i_del_value(&e->val);
 			}
-			n = e->next;
 			e->next = fmelt;
 			fmelt = e;
 			--i;
@@ -257,8 +379,9 @@ void arr_freelist(array *alist)
 {
     array *a;
     value *v;
-    unsigned short i;
-    mapelt *e, *n, **t;
+    asizet i;
+    mapelt *e;
+    mapslot *t;
 
     a = alist;
     do {
@@ -270,6 +393,8 @@ void arr_freelist(array *alist)
 		v++;
 	    }
 	    FREE(a->elts);
+	} else if (a->packed != (char *) NULL) {
+	    FREE(a->packed);
 	}
 
 	if (a->hashed != (maphash *) NULL) {
@@ -277,7 +402,7 @@ void arr_freelist(array *alist)
 	     * delete the hashtable of a mapping
 	     */
 	    for (i = a->hashed->size, t = a->hashed->table; i > 0; t++) {
-		for (e = *t; e != (mapelt *) NULL; e = n) {
+		if (MELT_USED(e = t->elt)) {
 		    if (e->add) {
 			if (e->idx.type == T_STRING) {
 			    str_del(e->idx.u.string);
@@ -286,7 +411,6 @@ void arr_freelist(array *alist)
 			    str_del(e->val.u.string);
 			}
 		    }
-		    n = e->next;
 		    e->next = fmelt;
 		    fmelt = e;
 		    --i;
@@ -349,7 +473,7 @@ void arr_merge()
     alink = (arrh *) NULL;
     ahlist = (arrhchunk *) NULL;
     ahchunksz = ARR_CHUNK;
-    memset(&aht, '\0', ARRMERGETABSZ * sizeof(arrh *));
+    aht = ht_new(ARRMERGETABSZ, sizeof(array *), TRUE);
 }
 
 /*
@@ -360,11 +484,9 @@ Uint arr_put(array *a, Uint idx)
 {
     arrh **h;
 
-    for (h = &aht[(uintptr_t) a % ARRMERGETABSZ]; *h != (arrh *) NULL;
-	 h = &(*h)->next) {
-	if ((*h)->arr == a) {
-	    return (*h)->index;
-	}
+    h = (arrh **) ht_lookup(aht, (char *) &a, TRUE);
+    if (*h != (arrh *) NULL) {
+	return (*h)->index;
     }
     /*
      * Add a new entry to the hash table.
@@ -377,8 +499,8 @@ Uint arr_put(array *a, Uint idx)
 	ahlist = l;
 	ahchunksz = 0;
     }
-    *h = &ahlist->ah[ahchunksz++];
-    (*h)->next = (arrh *) NULL;
+    ht_insert(aht, (hte **) h, (hte *) &ahlist->ah[ahchunksz++]);
+    (*h)->chain.name = (char *) &(*h)->arr;
     arr_ref((*h)->arr = a);
     (*h)->index = idx;
     (*h)->link = alink;
@@ -410,6 +532,9 @@ void arr_clear()
 	l = l->next;
 	FREE(f);
     }
+
+    ht_del(aht);
+    aht = (hashtab *) NULL;
 }
 
 
@@ -417,7 +542,7 @@ void arr_clear()
  * NAME:	backup()
  * DESCRIPTION:	add an array backup to the backup chunk
  */
-static void backup(abchunk **ac, array *a, value *elts, unsigned int size, 
+static arrbak *backup(abchunk **ac, array *a, unsigned int size,
 	dataplane *plane)
 {
     abchunk *c;
@@ -435,8 +560,9 @@ static void backup(abchunk **ac, array *a, value *elts, unsigned int size,
     ab = &c->ab[c->chunksz++];
     ab->arr = a;
     ab->size = size;
-    ab->original = elts;
+    ab->single = FALSE;
     ab->plane = plane;
+    return ab;
 }
 
 /*
@@ -446,7 +572,7 @@ static void backup(abchunk **ac, array *a, value *elts, unsigned int size,
 void arr_backup(abchunk **ac, array *a)
 {
     value *elts;
-    unsigned short i;
+    asizet i;
 
 # ifdef DEBUG
     if (a->hashmod) {
@@ -473,7 +599,29 @@ void arr_backup(abchunk **ac, array *a)
     } else {
 	elts = (value *) NULL;
     }
-    backup(ac, a, elts, a->size, a->primary->plane);
+    backup(ac, a, a->size, a->primary->plane)->original.elts = elts;
+    arr_ref(a);
+}
+
+/*
+ * NAME:	array->backup_elt()
+ * DESCRIPTION:	make a backup of a single array element
+ */
+void arr_backup_elt(abchunk **ac, array *a, unsigned int idx)
+{
+    arrbak *ab;
+
+    if (*ac != (abchunk *) NULL) {
+	ab = &(*ac)->ab[(*ac)->chunksz - 1];
+	if (ab->single && ab->arr == a && ab->size == idx) {
+	    return;	/* repeated assignment to the same element */
+	}
+    }
+
+    ab = backup(ac, a, idx, a->primary->plane);
+    ab->single = TRUE;
+    i_ref_value(&a->elts[idx]);
+    ab->original.elt = a->elts[idx];
     arr_ref(a);
 }
 
@@ -483,31 +631,57 @@ void arr_backup(abchunk **ac, array *a)
  */
 void arr_commit(abchunk **ac, dataplane *plane, int merge)
 {
-    abchunk *c, *n;
-    arrbak *ab;
+    abchunk *c, *n, *r;
+    arrbak *ab, *b;
     short i;
 
     c = *ac;
     if (merge) {
 	*ac = (abchunk *) NULL;
+
+	/* oldest backups first, to keep their order on the previous plane */
+	for (r = (abchunk *) NULL; c != (abchunk *) NULL; c = n) {
+	    n = c->next;
+	    c->next = r;
+	    r = c;
+	}
+	c = r;
     }
 
     while (c != (abchunk *) NULL) {
 	for (ab = c->ab, i = c->chunksz; --i >= 0; ab++) {
+	    if (ab->single) {
+		ac = d_commit_elt(&ab->arr->elts[ab->size], plane, ab->plane);
+		if (merge) {
+		    if (ac != (abchunk **) NULL) {
+			/* backup on previous plane */
+			b = backup(ac, ab->arr, ab->size, ab->plane);
+			b->single = TRUE;
+			b->original.elt = ab->original.elt;
+		    } else {
+			i_del_value(&ab->original.elt);
+			arr_del(ab->arr);
+		    }
+		}
+		continue;
+	    }
+
 	    ac = d_commit_arr(ab->arr, plane, ab->plane);
 	    if (merge) {
 		if (ac != (abchunk **) NULL) {
 		    /* backup on previous plane */
-		    backup(ac, ab->arr, ab->original, ab->size, ab->plane);
+		    backup(ac, ab->arr, ab->size, ab->plane)->original.elts =
+							    ab->original.elts;
 		} else {
-		    if (ab->original != (value *) NULL) {
+		    if (ab->original.elts != (value *) NULL) {
 			value *v;
-			unsigned short j;
+			asizet j;
 
-			for (v = ab->original, j = ab->size; j != 0; v++, --j) {
+			for (v = ab->original.elts, j = ab->size; j != 0;
+			     v++, --j) {
 			    i_del_value(v);
 			}
-			FREE(ab->original);
+			FREE(ab->original.elts);
 		    }
 		    arr_del(ab->arr);
 		}
@@ -532,11 +706,19 @@ void arr_discard(abchunk **ac)
     arrbak *ab;
     short i;
     array *a;
-    unsigned short j;
+    asizet j;
 
+    /* undo the most recent backups first */
     for (c = *ac, *ac = (abchunk *) NULL; c != (abchunk *) NULL; c = n) {
-	for (ab = c->ab, i = c->chunksz; --i >= 0; ab++) {
-	    a = ab->arr;
+	for (ab = c->ab + c->chunksz, i = c->chunksz; --i >= 0; ) {
+	    a = (--ab)->arr;
+	    if (ab->single) {
+		i_del_value(&a->elts[ab->size]);
+		a->elts[ab->size] = ab->original.elt;
+		arr_del(a);
+		continue;
+	    }
+
 	    d_discard_arr(a, ab->plane);
 
 	    if (a->elts != (value *) NULL) {
@@ -549,15 +731,15 @@ void arr_discard(abchunk **ac)
 	    }
 
 	    if (a->hashed != (maphash *) NULL) {
-		mapelt *e, *n, **t;
+		mapelt *e;
+		mapslot *t;
 
 		for (j = a->hashed->size, t = a->hashed->table; j > 0; t++) {
-		    for (e = *t; e != (mapelt *) NULL; e = n) {
+		    if (MELT_USED(e = t->elt)) {
 			if (e->add) {
 			    i_del_value(&e->idx);
 			    i_del_value(&e->val);
 			}
-			n = e->next;
 			e->next = fmelt;
 			fmelt = e;
 			--j;
@@ -568,7 +750,7 @@ void arr_discard(abchunk **ac)
 		a->hashmod = FALSE;
 	    }
 
-	    a->elts = ab->original;
+	    a->elts = ab->original.elts;
 	    a->size = ab->size;
 	    arr_del(a);
 	}
@@ -586,8 +768,15 @@ void arr_discard(abchunk **ac)
 static void copytmp(dataspace *data, value *v1, array *a)
 {
     value *v2, *o;
-    unsigned short n;
+    asizet n;
 
+    if (d_get_packed(a) != (char *) NULL) {
+	/* no objects to check */
+	for (n = 0; n < a->size; n++) {
+	    arr_get_packed(a, n, v1++);
+	}
+	return;
+    }
     v2 = d_get_elts(a);
     if (a->odcount == odcount) {
 	/*
@@ -628,6 +817,13 @@ array *arr_add(dataspace *data, array *a1, array *a2)
 {
     array *a;
 
+    if (d_get_packed(a1) != (char *) NULL &&
+	d_get_packed(a2) != (char *) NULL && a1->ptype == a2->ptype) {
+	a = arr_new_packed(data, (long) a1->size + a2->size, a1->ptype);
+	pkdcopy(a, 0, a1, 0, a1->size);
+	pkdcopy(a, a1->size, a2, 0, a2->size);
+	return a;
+    }
     a = arr_new(data, (long) a1->size + a2->size);
     i_copy(a->elts, d_get_elts(a1), a1->size);
     i_copy(a->elts + a1->size, d_get_elts(a2), a2->size);
@@ -692,12 +888,12 @@ static int cmp(cvoid *cv1, cvoid *cv2)
  * NAME:	search()
  * DESCRIPTION:	search for a value in an array
  */
-static int search(value *v1, value *v2, unsigned short h, int step, bool place)
+static int search(value *v1, value *v2, asizet h, int step, bool place)
 {
-    unsigned short l, m;
+    asizet l, m;
     Int c;
     value *v3;
-    unsigned short mask;
+    asizet mask;
 
     mask = -step;
     l = 0;
@@ -763,6 +959,108 @@ static int search(value *v1, value *v2, unsigned short h, int step, bool place)
     return (place) ? l : -1;
 }
 
+static Uint map_hash (value*);
+
+/*
+ * NAME:	set->equal()
+ * DESCRIPTION:	check two values for equality, comparing integers and objects
+ *		directly
+ */
+static bool set_equal(value *v1, value *v2)
+{
+    if (v1->type != v2->type) {
+	return FALSE;
+    }
+    switch (v1->type) {
+    case T_INT:
+	return (v1->u.number == v2->u.number);
+
+    case T_OBJECT:
+	return (v1->oindex == v2->oindex);
+
+    case T_ARRAY:
+    case T_MAPPING:
+    case T_LWOBJECT:
+	return (v1->u.array == v2->u.array);
+
+    default:
+	return (cmp(v1, v2) == 0);
+    }
+}
+
+/*
+ * NAME:	set->init()
+ * DESCRIPTION:	prepare a set of values for membership tests.  Small sets
+ *		are searched linearly, larger ones get a hash table
+ */
+static void set_init(valset *set, value *elts, asizet size)
+{
+    Uint hashval, i;
+    setslot *t;
+
+    set->elts = elts;
+    set->size = size;
+    if (size < SET_HASHMIN) {
+	set->table = (setslot *) NULL;
+	return;
+    }
+
+    for (i = 2 * SET_HASHMIN; i < (Uint) size << 1; i <<= 1) ;
+    set->mask = i - 1;
+    t = set->table = ALLOC(setslot, i);
+    memset(t, '\0', i * sizeof(setslot));
+    while (size != 0) {
+	hashval = map_hash(elts);
+	for (i = hashval & set->mask; t[i].val != (value *) NULL;
+	     i = (i + 1) & set->mask) ;
+	t[i].hashval = hashval;
+	t[i].val = elts++;
+	--size;
+    }
+}
+
+/*
+ * NAME:	set->member()
+ * DESCRIPTION:	check whether a value is in a set
+ */
+static bool set_member(valset *set, value *val)
+{
+    Uint hashval, i;
+    asizet n;
+    value *v;
+    setslot *t;
+
+    if (set->table == (setslot *) NULL) {
+	for (n = set->size, v = set->elts; n != 0; --n, v++) {
+	    if (set_equal(val, v)) {
+		return TRUE;
+	    }
+	}
+	return FALSE;
+    }
+
+    hashval = map_hash(val);
+    t = set->table;
+    for (i = hashval & set->mask; (v=t[i].val) != (value *) NULL;
+	 i = (i + 1) & set->mask) {
+	if (t[i].hashval == hashval && set_equal(val, v)) {
+	    return TRUE;
+	}
+    }
+    return FALSE;
+}
+
+/*
+ * NAME:	set->clear()
+ * DESCRIPTION:	remove the hash table of a set
+ */
+static void set_clear(valset *set)
+{
+    if (set->table != (setslot *) NULL) {
+	FREE(set->table);
+    }
+}
+
 /*
  * NAME:	array->sub()
  * DESCRIPTION:	subtract one array from another
@@ -771,7 +1069,8 @@ array *arr_sub(dataspace *data, array *a1, array *a2)
 {
     value *v1, *v2, *v3, *o;
     array *a3;
-    unsigned short n, size;
+    asizet n, size;
+    valset set;
 
     if (a2->size == 0) {
 	/*
@@ -792,15 +1091,15 @@ array *arr_sub(dataspace *data, array *a1, array *a2)
     }
     size = a2->size;
 
-    /* copy and sort values of subtrahend */
-    copytmp(data, v2 = ALLOCA(value, size), a2);
-    qsort(v2, size, sizeof(value), cmp);
+    /* copy values of subtrahend */
+    copytmp(data, v2 = TALLOC(value, size), a2);
+    set_init(&set, v2, size);
 
     v1 = d_get_elts(a1);
     v3 = a3->elts;
     if (a1->odcount == odcount) {
 	for (n = a1->size; n > 0; --n) {
-	    if (search(v1, v2, size, 1, FALSE) < 0) {
+	    if (!set_member(&set, v1)) {
 		/*
 		 * not found in subtrahend: copy to result array
 		 */
@@ -828,7 +1127,7 @@ array *arr_sub(dataspace *data, array *a1, array *a2)
 		}
 		break;
 	    }
-	    if (search(v1, v2, size, 1, FALSE) < 0) {
+	    if (!set_member(&set, v1)) {
 		/*
 		 * not found in subtrahend: copy to result array
 		 */
@@ -838,7 +1137,8 @@ array *arr_sub(dataspace *data, array *a1, array *a2)
 	    v1++;
 	}
     }
-    AFREE(v2);	/* free copy of values of subtrahend */
+    set_clear(&set);
+    TFREE(v2);	/* free copy of values of subtrahend */
 
     a3->size = v3 - a3->elts;
     if (a3->size == 0) {
@@ -858,7 +1158,8 @@ array *arr_intersect(dataspace *data, array *a1, array *a2)
 {
     value *v1, *v2, *v3, *o;
     array *a3;
-    unsigned short n, size;
+    asizet n, size;
+    valset set;
 
     if (a1->size == 0 || a2->size == 0) {
 	/* array & ({ }) */
@@ -869,15 +1170,15 @@ array *arr_intersect(dataspace *data, array *a1, array *a2)
     a3 = arr_new(data, (long) a1->size);
     size = a2->size;
 
-    /* copy and sort values of 2nd array */
-    copytmp(data, v2 = ALLOCA(value, size), a2);
-    qsort(v2, size, sizeof(value), cmp);
+    /* copy values of 2nd array */
+    copytmp(data, v2 = TALLOC(value, size), a2);
+    set_init(&set, v2, size);
 
     v1 = d_get_elts(a1);
     v3 = a3->elts;
     if (a1->odcount == odcount) {
 	for (n = a1->size; n > 0; --n) {
-	    if (search(v1, v2, a2->size, 1, FALSE) >= 0) {
+	    if (set_member(&set, v1)) {
 		/*
 		 * element is in both arrays: copy to result array
 		 */
@@ -905,7 +1206,7 @@ array *arr_intersect(dataspace *data, array *a1, array *a2)
 		}
 		break;
 	    }
-	    if (search(v1, v2, a2->size, 1, FALSE) >= 0) {
+	    if (set_member(&set, v1)) {
 		/*
 		 * element is in both arrays: copy to result array
 		 */
@@ -915,7 +1216,8 @@ array *arr_intersect(dataspace *data, array *a1, array *a2)
 	    v1++;
 	}
     }
-    AFREE(v2);	/* free copy of values of 2nd array */
+    set_clear(&set);
+    TFREE(v2);	/* free copy of values of 2nd array */
 
     a3->size = v3 - a3->elts;
     if (a3->size == 0) {
@@ -936,7 +1238,8 @@ array *arr_setadd(dataspace *data, array *a1, array *a2)
     value *v, *v1, *v2, *o;
     value *v3;
     array *a3;
-    unsigned short n, size;
+    asizet n, size;
+    valset set;
 
     if (a1->size == 0) {
 	/* ({ }) | array */
@@ -954,17 +1257,17 @@ array *arr_setadd(dataspace *data, array *a1, array *a2)
     }
 
     /* make room for elements to add */
-    v3 = ALLOCA(value, a2->size);
+    v3 = TALLOC(value, a2->size);
 
-    /* copy and sort values of 1st array */
-    copytmp(data, v1 = ALLOCA(value, size = a1->size), a1);
-    qsort(v1, size, sizeof(value), cmp);
+    /* copy values of 1st array */
+    copytmp(data, v1 = TALLOC(value, size = a1->size), a1);
+    set_init(&set, v1, size);
 
     v = v3;
     v2 = d_get_elts(a2);
     if (a2->odcount == odcount) {
 	for (n = a2->size; n > 0; --n) {
-	    if (search(v2, v1, size, 1, FALSE) < 0) {
+	    if (!set_member(&set, v2)) {
 		/*
 		 * element is only in second array: copy to result array
 		 */
@@ -991,7 +1294,7 @@ array *arr_setadd(dataspace *data, array *a1, array *a2)
 		}
 		break;
 	    }
-	    if (search(v2, v1, size, 1, FALSE) < 0) {
+	    if (!set_member(&set, v2)) {
 		/*
 		 * element is only in second array: copy to result array
 		 */
@@ -1000,18 +1303,19 @@ array *arr_setadd(dataspace *data, array *a1, array *a2)
 	    v2++;
 	}
     }
-    AFREE(v1);	/* free copy of values of 1st array */
+    set_clear(&set);
+    TFREE(v1);	/* free copy of values of 1st array */
 
     n = v - v3;
     if ((long) size + n > max_size) {
-	AFREE(v3);
+	TFREE(v3);
 	error("Array too large");
     }
 
     a3 = arr_new(data, (long) size + n);
     i_copy(a3->elts, a1->elts, size);
     i_copy(a3->elts + size, v3, n);
-    AFREE(v3);
+    TFREE(v3);
 
     d_ref_imports(a3);
     return a3;
@@ -1027,8 +1331,9 @@ array *arr_setxadd(dataspace *data, array *a1, array *a2)
     value *v, *w, *v1, *v2;
     value *v3;
     array *a3;
-    unsigned short n, size;
-    unsigned short num;
+    asizet n, size;
+    asizet num;
+    valset set;
 
     if (a1->size == 0) {
 	/* ({ }) ^ array */
@@ -1046,19 +1351,19 @@ array *arr_setxadd(dataspace *data, array *a1, array *a2)
     }
 
     /* copy values of 1st array */
-    copytmp(data, v1 = ALLOCA(value, size = a1->size), a1);
+    copytmp(data, v1 = TALLOC(value, size = a1->size), a1);
 
-    /* copy and sort values of 2nd array */
-    copytmp(data, v2 = ALLOCA(value, size = a2->size), a2);
-    qsort(v2, size, sizeof(value), cmp);
+    /* copy values of 2nd array */
+    copytmp(data, v2 = TALLOC(value, size = a2->size), a2);
+    set_init(&set, v2, size);
 
     /* room for first half of result */
-    v3 = ALLOCA(value, a1->size);
+    v3 = TALLOC(value, a1->size);
 
     v = v3;
     w = v1;
     for (n = a1->size; n > 0; --n) {
-	if (search(v1, v2, size, 1, FALSE) < 0) {
+	if (!set_member(&set, v1)) {
 	    /*
 	     * element is only in first array: copy to result array
 	     */
@@ -1072,15 +1377,16 @@ array *arr_setxadd(dataspace *data, array *a1, array *a2)
 	v1++;
     }
     num = v - v3;
+    set_clear(&set);
 
-    /* sort copy of 1st array */
+    /* elements of 1st array that are also in the 2nd */
     v1 -= a1->size;
-    qsort(v1, size = w - v1, sizeof(value), cmp);
+    set_init(&set, v1, w - v1);
 
     v = v2;
     w = a2->elts;
     for (n = a2->size; n > 0; --n) {
-	if (search(w, v1, size, 1, FALSE) < 0) {
+	if (!set_member(&set, w)) {
 	    /*
 	     * element is only in second array: copy to 2nd result array
 	     */
@@ -1088,21 +1394,22 @@ array *arr_setxadd(dataspace *data, array *a1, array *a2)
 	}
 	w++;
     }
+    set_clear(&set);
 
     n = v - v2;
     if ((long) num + n > max_size) {
-	AFREE(v3);
-	AFREE(v2);
-	AFREE(v1);
+	TFREE(v3);
+	TFREE(v2);
+	TFREE(v1);
 	error("Array too large");
     }
 
     a3 = arr_new(data, (long) num + n);
     i_copy(a3->elts, v3, num);
     i_copy(a3->elts + num, v2, n);
-    AFREE(v3);
-    AFREE(v2);
-    AFREE(v1);
+    TFREE(v3);
+    TFREE(v2);
+    TFREE(v1);
 
     d_ref_imports(a3);
     return a3;
@@ -1112,7 +1419,7 @@ array *arr_setxadd(dataspace *data, array *a1, array *a2)
  * NAME:	array->index()
  * DESCRIPTION:	index an array
  */
-unsigned short arr_index(array *a, long l)
+asizet arr_index(array *a, long l)
 {
     if (l < 0 || l >= (long) a->size) {
 	error("Array index out of range");
@@ -1143,12 +1450,120 @@ array *arr_range(dataspace *data, array *a, long l1, long l2)
 	error("Invalid array range");
     }
 
+    if (d_get_packed(a) != (char *) NULL && l1 <= l2) {
+	range = arr_new_packed(data, l2 - l1 + 1, a->ptype);
+	pkdcopy(range, 0, a, (asizet) l1, (asizet) (l2 - l1 + 1));
+	return range;
+    }
     range = arr_new(data, l2 - l1 + 1);
-    i_copy(range->elts, d_get_elts(a) + l1, (unsigned short) (l2 - l1 + 1));
+    i_copy(range->elts, d_get_elts(a) + l1, (asizet) (l2 - l1 + 1));
     d_ref_imports(range);
     return range;
 }
 
+/*
+ * NAME:	cmp_int()
+ * DESCRIPTION:	compare two integer values
+ */
+static int cmp_int(cvoid *cv1, cvoid *cv2)
+{
+    Int n1, n2;
+
+    n1 = ((value *) cv1)->u.number;
+    n2 = ((value *) cv2)->u.number;
+    return (n1 <= n2) ? (n1 < n2) ? -1 : 0 : 1;
+}
+
+/*
+ * NAME:	cmp_float()
+ * DESCRIPTION:	compare two float values
+ */
+static int cmp_float(cvoid *cv1, cvoid *cv2)
+{
+    xfloat f1, f2;
+
+    GET_FLT((value *) cv1, f1);
+    GET_FLT((value *) cv2, f2);
+    return flt_cmp(&f1, &f2);
+}
+
+/*
+ * NAME:	cmp_string()
+ * DESCRIPTION:	compare two string values
+ */
+static int cmp_string(cvoid *cv1, cvoid *cv2)
+{
+    return str_cmp(((value *) cv1)->u.string, ((value *) cv2)->u.string);
+}
+
+/*
+ * NAME:	cmp_object()
+ * DESCRIPTION:	compare two object values
+ */
+static int cmp_object(cvoid *cv1, cvoid *cv2)
+{
+    uindex o1, o2;
+
+    o1 = ((value *) cv1)->oindex;
+    o2 = ((value *) cv2)->oindex;
+    return (o1 <= o2) ? (o1 < o2) ? -1 : 0 : 1;
+}
+
+/*
+ * NAME:	array->sort()
+ * DESCRIPTION:	return a sorted copy of an array
+ */
+array *arr_sort(dataspace *data, array *a)
+{
+    array *sorted;
+    value *v;
+    asizet n;
+    int type;
+    int (*compare) (cvoid*, cvoid*);
+
+    sorted = arr_new(data, (long) a->size);
+    i_copy(sorted->elts, d_get_elts(a), a->size);
+
+    if (a->size > 1) {
+	/*
+	 * use a specialized comparison if all elements have the same type
+	 */
+	v = sorted->elts;
+	type = v->type;
+	for (n = a->size; --n != 0; ) {
+	    if ((++v)->type != type) {
+		type = T_MIXED;
+		break;
+	    }
+	}
+	switch (type) {
+	case T_INT:
+	    compare = cmp_int;
+	    break;
+
+	case T_FLOAT:
+	    compare = cmp_float;
+	    break;
+
+	case T_STRING:
+	    compare = cmp_string;
+	    break;
+
+	case T_OBJECT:
+	    compare = cmp_object;
+	    break;
+
+	default:
+	    compare = cmp;
+	    break;
+	}
+	qsort(sorted->elts, a->size, sizeof(value), compare);
+    }
+
+    d_ref_imports(sorted);
+    return sorted;
+}
+
 
 /*
  * NAME:	mapping->new()
@@ -1161,7 +1576,7 @@ array *map_new(dataspace *data, long size)
     if (size > max_size << 1) {
 	error("Mapping too large");
     }
-    m = arr_alloc((unsigned short) size);
+    m = arr_alloc((asizet) size);
     if (size > 0) {
 	m->elts = ALLOC(value, size);
     }
@@ -1181,7 +1596,7 @@ array *map_new(dataspace *data, long size)
  */
 void map_sort(array *m)
 {
-    unsigned short i, sz;
+    asizet i, sz;
     value *v, *w;
 
     for (i = m->size, sz = 0, v = w = m->elts; i > 0; i -= 2) {
@@ -1218,9 +1633,10 @@ void map_sort(array *m)
  */
 static void map_dehash(dataspace *data, array *m, bool clean)
 {
-    unsigned short size, i, j;
+    asizet size, i, j;
     value *v1, *v2, *v3;
-    mapelt *e, **t, **p;
+    mapelt *e;
+    mapslot *t;
 
     if (clean && m->size != 0) {
 	/*
@@ -1299,88 +1715,93 @@ static void map_dehash(dataspace *data, array *m, bool clean)
 	 * merge copy of hashtable with sorted array
 	 */
 	size = m->hashed->size;
-	v2 = ALLOCA(value, size << 1);
+	v2 = TALLOC(value, size << 1);
 	t = m->hashed->table;
 	if (clean) {
-	    for (i = size, size = j = 0; i > 0; ) {
-		for (p = t++; (e=*p) != (mapelt *) NULL; --i) {
-		    switch (e->idx.type) {
-		    case T_OBJECT:
-			if (DESTRUCTED(&e->idx)) {
-			    /*
-			     * index is destructed object
-			     */
-			    if (e->add) {
-				d_assign_elt(data, m, &e->val, &nil_value);
-			    }
-			    *p = e->next;
-			    e->next = fmelt;
-			    fmelt = e;
-			    continue;
-			}
-			break;
+	    for (i = size, size = j = 0; i > 0; t++) {
+		if (!MELT_USED(e = t->elt)) {
+		    continue;
+		}
+		--i;
 
-		    case T_LWOBJECT:
-			v3 = d_get_elts(e->idx.u.array);
-			if (v3->type == T_OBJECT && DESTRUCTED(v3)) {
-			    /*
-			     * index is destructed object
-			     */
-			    if (e->add) {
-				d_assign_elt(data, m, &e->idx, &nil_value);
-				d_assign_elt(data, m, &e->val, &nil_value);
-			    }
-			    *p = e->next;
-			    e->next = fmelt;
-			    fmelt = e;
-			    continue;
+		switch (e->idx.type) {
+		case T_OBJECT:
+		    if (DESTRUCTED(&e->idx)) {
+			/*
+			 * index is destructed object
+			 */
+			if (e->add) {
+			    d_assign_elt(data, m, &e->val, &nil_value);
 			}
-			break;
+			t->elt = MELT_DELETED;
+			m->hashed->ndeleted++;
+			e->next = fmelt;
+			fmelt = e;
+			continue;
 		    }
-		    switch (e->val.type) {
-		    case T_OBJECT:
-			if (DESTRUCTED(&e->val)) {
-			    /*
-			     * value is destructed object
-			     */
-			    if (e->add) {
-				d_assign_elt(data, m, &e->idx, &nil_value);
-			    }
-			    *p = e->next;
-			    e->next = fmelt;
-			    fmelt = e;
-			    continue;
+		    break;
+
+		case T_LWOBJECT:
+		    v3 = d_get_elts(e->idx.u.array);
+		    if (v3->type == T_OBJECT && DESTRUCTED(v3)) {
+			/*
+			 * index is destructed object
+			 */
+			if (e->add) {
+			    d_assign_elt(data, m, &e->idx, &nil_value);
+			    d_assign_elt(data, m, &e->val, &nil_value);
 			}
-			break;
-
-		    case T_LWOBJECT:
-			v3 = d_get_elts(e->val.u.array);
-			if (v3->type == T_OBJECT && DESTRUCTED(v3)) {
-			    /*
-			     * value is destructed object
-			     */
-			    if (e->add) {
-				d_assign_elt(data, m, &e->idx, &nil_value);
-				d_assign_elt(data, m, &e->val, &nil_value);
-			    }
-			    *p = e->next;
-			    e->next = fmelt;
-			    fmelt = e;
-			    continue;
+			t->elt = MELT_DELETED;
+			m->hashed->ndeleted++;
+			e->next = fmelt;
+			fmelt = e;
+			continue;
+		    }
+		    break;
+		}
+		switch (e->val.type) {
+		case T_OBJECT:
+		    if (DESTRUCTED(&e->val)) {
+			/*
+			 * value is destructed object
+			 */
+			if (e->add) {
+			    d_assign_elt(data, m, &e->idx, &nil_value);
 			}
-			break;
+			t->elt = MELT_DELETED;
+			m->hashed->ndeleted++;
+			e->next = fmelt;
+			fmelt = e;
+			continue;
 		    }
-
-		    if (e->add) {
-			e->add = FALSE;
-			*v2++ = e->idx;
-			*v2++ = e->val;
-			size++;
+		    break;
+
+		case T_LWOBJECT:
+		    v3 = d_get_elts(e->val.u.array);
+		    if (v3->type == T_OBJECT && DESTRUCTED(v3)) {
+			/*
+			 * value is destructed object
+			 */
+			if (e->add) {
+			    d_assign_elt(data, m, &e->idx, &nil_value);
+			    d_assign_elt(data, m, &e->val, &nil_value);
+			}
+			t->elt = MELT_DELETED;
+			m->hashed->ndeleted++;
+			e->next = fmelt;
+			fmelt = e;
+			continue;
 		    }
-		    j++;
+		    break;
+		}
 
-		    p = &e->next;
+		if (e->add) {
+		    e->add = FALSE;
+		    *v2++ = e->idx;
+		    *v2++ = e->val;
+		    size++;
 		}
+		j++;
 	    }
 
 	    if (j != m->hashed->size) {
@@ -1389,16 +1810,12 @@ static void map_dehash(dataspace *data, array *m, bool clean)
 	    }
 	} else {
 	    size = m->hashed->sizemod;
-	    for (i = size; i > 0; ) {
-		for (e = *t++; e != (mapelt *) NULL; e = e->next) {
-		    if (e->add) {
-			e->add = FALSE;
-			*v2++ = e->idx;
-			*v2++ = e->val;
-			if (--i == 0) {
-			    break;
-			}
-		    }
+	    for (i = size; i > 0; t++) {
+		if (MELT_USED(e = t->elt) && e->add) {
+		    e->add = FALSE;
+		    *v2++ = e->idx;
+		    *v2++ = e->val;
+		    --i;
 		}
 	    }
 	}
@@ -1442,7 +1859,7 @@ static void map_dehash(dataspace *data, array *m, bool clean)
 	    m->elts = v3 - m->size;
 	}
 
-	AFREE(v2);
+	TFREE(v2);
     }
 }
 
@@ -1453,15 +1870,15 @@ static void map_dehash(dataspace *data, array *m, bool clean)
 void map_rmhash(array *m)
 {
     if (m->hashed != (maphash *) NULL) {
-	unsigned short i;
-	mapelt *e, *n, **t;
+	asizet i;
+	mapelt *e;
+	mapslot *t;
 
 	if (m->hashmod) {
 	    map_dehash(m->primary->data, m, FALSE);
 	}
 	for (i = m->hashed->size, t = m->hashed->table; i > 0; t++) {
-	    for (e = *t; e != (mapelt *) NULL; e = n) {
-		n = e->next;
+	    if (MELT_USED(e = t->elt)) {
 		e->next = fmelt;
 		fmelt = e;
 		--i;
@@ -1472,6 +1889,19 @@ void map_rmhash(array *m)
     }
 }
 
+/*
+ * NAME:	map->hashmem()
+ * DESCRIPTION:	return the memory used by the hash table of a mapping
+ */
+Uint map_hashmem(array *m)
+{
+    if (m->hashed == (maphash *) NULL) {
+	return 0;
+    }
+    return sizeof(maphash) + (m->hashed->tablesize - 1) * sizeof(mapslot) +
+	   m->hashed->size * sizeof(mapelt);
+}
+
 /*
  * NAME:	mapping->compact()
  * DESCRIPTION:	compact a mapping: copy new elements from the hash table into
@@ -1494,8 +1924,13 @@ void map_compact(dataspace *data, array *m)
  * NAME:	mapping->size()
  * DESCRIPTION:	return the size of a mapping
  */
-unsigned short map_size(dataspace *data, array *m)
+asizet map_size(dataspace *data, array *m)
 {
+    if (m->odcount == odcount) {
+	/* nothing to remove: count without merging the hash table */
+	return (m->size >> 1) +
+	       ((m->hashed != (maphash *) NULL) ? m->hashed->sizemod : 0);
+    }
     map_compact(data, m);
     return m->size >> 1;
 }
@@ -1507,7 +1942,7 @@ unsigned short map_size(dataspace *data, array *m)
 array *map_add(dataspace *data, array *m1, array *m2)
 {
     value *v1, *v2, *v3;
-    unsigned short n1, n2;
+    asizet n1, n2;
     Int c;
     array *m3;
 
@@ -1536,7 +1971,7 @@ array *map_add(dataspace *data, array *m1, array *m2)
 		/* equal elements? */
 		if (T_INDEXED(v1->type) && v1->u.array != v2->u.array) {
 		    value *v;
-		    unsigned short n;
+		    asizet n;
 
 		    /*
 		     * The array tags are the same, but the arrays are not.
@@ -1590,7 +2025,7 @@ array *map_add(dataspace *data, array *m1, array *m2)
 array *map_sub(dataspace *data, array *m1, array *a2)
 {
     value *v1, *v2, *v3;
-    unsigned short n1, n2, size;
+    asizet n1, n2, size;
     Int c;
     array *m3;
 
@@ -1608,7 +2043,7 @@ array *map_sub(dataspace *data, array *m1, array *a2)
     }
 
     /* copy and sort values of array */
-    copytmp(data, v2 = ALLOCA(value, size), a2);
+    copytmp(data, v2 = TALLOC(value, size), a2);
     qsort(v2, size, sizeof(value), cmp);
 
     v1 = m1->elts;
@@ -1626,7 +2061,7 @@ array *map_sub(dataspace *data, array *m1, array *a2)
 	    /* equal elements? */
 	    if (T_INDEXED(v1->type) && v1->u.array != v2->u.array) {
 		value *v;
-		unsigned short n;
+		asizet n;
 
 		/*
 		 * The array tags are the same, but the arrays are not.
@@ -1653,7 +2088,7 @@ array *map_sub(dataspace *data, array *m1, array *a2)
 	    v1 += 2; n1 -= 2;
 	}
     }
-    AFREE(v2 - (size - n2));
+    TFREE(v2 - (size - n2));
 
     /* copy tail part of m1 */
     i_copy(v3, v1, n1);
@@ -1676,7 +2111,7 @@ array *map_sub(dataspace *data, array *m1, array *a2)
 array *map_intersect(dataspace *data, array *m1, array *a2)
 {
     value *v1, *v2, *v3;
-    unsigned short n1, n2, size;
+    asizet n1, n2, size;
     Int c;
     array *m3;
 
@@ -1692,7 +2127,7 @@ array *map_intersect(dataspace *data, array *m1, array *a2)
     }
 
     /* copy and sort values of array */
-    copytmp(data, v2 = ALLOCA(value, size), a2);
+    copytmp(data, v2 = TALLOC(value, size), a2);
     qsort(v2, size, sizeof(value), cmp);
 
     v1 = m1->elts;
@@ -1709,7 +2144,7 @@ array *map_intersect(dataspace *data, array *m1, array *a2)
 	    /* equal elements? */
 	    if (T_INDEXED(v1->type) && v1->u.array != v2->u.array) {
 		value *v;
-		unsigned short n;
+		asizet n;
 
 		/*
 		 * The array tags are the same, but the arrays are not.
@@ -1739,7 +2174,7 @@ array *map_intersect(dataspace *data, array *m1, array *a2)
 	    v2++; --n2;
 	}
     }
-    AFREE(v2 - (size - n2));
+    TFREE(v2 - (size - n2));
 
     m3->size = v3 - m3->elts;
     if (m3->size == 0) {
@@ -1751,6 +2186,75 @@ array *map_intersect(dataspace *data, array *m1, array *a2)
     return m3;
 }
 
+/*
+ * NAME:	mapping->hash()
+ * DESCRIPTION:	compute the hash value of a mapping index
+ */
+static Uint map_hash(value *val)
+{
+    Uint h;
+    char *p;
+    ssizet len;
+
+    h = 0;
+    switch (val->type) {
+    case T_NIL:
+	h = 4747;
+	break;
+
+    case T_INT:
+	h = val->u.number;
+	break;
+
+    case T_FLOAT:
+	h = VFLT_HASH(val);
+	break;
+
+    case T_STRING:
+	/* FNV-1a over the whole string */
+	h = 0x811c9dc5L;
+	for (p = val->u.string->text, len = val->u.string->len; len != 0; --len) {
+	    h = (h ^ UCHAR(*p++)) * 0x01000193L;
+	}
+	break;
+
+    case T_OBJECT:
+	h = val->oindex;
+	break;
+
+    case T_ARRAY:
+    case T_MAPPING:
+    case T_LWOBJECT:
+	h = (Uint) ((uintptr_t) val->u.array >> 3);
+	break;
+    }
+
+    /* mix all bits into the low ones, which select the slot */
+    h ^= h >> 16;
+    h *= 0x45d9f3bL;
+    h ^= h >> 16;
+    return h;
+}
+
+/*
+ * NAME:	mapping->slot()
+ * DESCRIPTION:	put an element in the first free slot for its hash value
+ */
+static void map_slot(maphash *h, Uint hashval, mapelt *e)
+{
+    Uint i;
+    mapslot *t;
+
+    for (i = hashval & (h->tablesize - 1); MELT_USED(h->table[i].elt);
+	 i = (i + 1) & (h->tablesize - 1)) ;
+    t = &h->table[i];
+    if (t->elt == MELT_DELETED) {
+	h->ndeleted--;
+    }
+    t->hashval = hashval;
+    t->elt = e;
+}
+
 /*
  * NAME:	mapping->grow()
  * DESCRIPTION:	add an element to a mapping
@@ -1759,7 +2263,6 @@ static mapelt *map_grow(dataspace *data, array *m, Uint hashval, bool add)
 {
     maphash *h;
     mapelt *e;
-    Uint i;
 
     h = m->hashed;
     if (add &&
@@ -1776,34 +2279,36 @@ static mapelt *map_grow(dataspace *data, array *m, Uint hashval, bool add)
 	 * add hash table to this mapping
 	 */
 	m->hashed = h = (maphash *)
-	    ALLOC(char, sizeof(maphash) + (MTABLE_SIZE - 1) * sizeof(mapelt*));
+	    ALLOC(char, sizeof(maphash) + (MTABLE_SIZE - 1) * sizeof(mapslot));
 	h->size = 0;
 	h->sizemod = 0;
 	h->tablesize = MTABLE_SIZE;
-	memset(h->table, '\0', MTABLE_SIZE * sizeof(mapelt*));
-    } else if (h->size << 2 >= h->tablesize * 3) {
-	mapelt *n, **t;
-	unsigned short j;
+	h->ndeleted = 0;
+	memset(h->table, '\0', MTABLE_SIZE * sizeof(mapslot));
+    } else if ((h->size + h->ndeleted + 1) << 2 > h->tablesize * 3) {
+	mapslot *t;
+	asizet j;
+	Uint i;
 
 	/*
-	 * extend hash table for this mapping
+	 * rebuild the hash table without deleted slots, and extend it unless
+	 * that alone frees enough room
 	 */
-	i = h->tablesize << 1;
+	i = ((h->size + 1) << 3 > h->tablesize * 3) ?
+	     h->tablesize << 1 : h->tablesize;
 	h = (maphash *) ALLOC(char,
-			      sizeof(maphash) + (i - 1) * sizeof(mapelt*));
+			      sizeof(maphash) + (i - 1) * sizeof(mapslot));
 	h->size = m->hashed->size;
 	h->sizemod = m->hashed->sizemod;
 	h->tablesize = i;
-	memset(h->table, '\0', i * sizeof(mapelt*));
+	h->ndeleted = 0;
+	memset(h->table, '\0', i * sizeof(mapslot));
 	/*
 	 * copy entries from old hashtable to new hashtable
 	 */
 	for (j = h->size, t = m->hashed->table; j > 0; t++) {
-	    for (e = *t; e != (mapelt *) NULL; e = n) {
-		n = e->next;
-		i = e->hashval % h->tablesize;
-		e->next = h->table[i];
-		h->table[i] = e;
+	    if (MELT_USED(t->elt)) {
+		map_slot(h, t->hashval, t->elt);
 		--j;
 	    }
 	}
@@ -1828,13 +2333,10 @@ static mapelt *map_grow(dataspace *data, array *m, Uint hashval, bool add)
 	}
 	e = &meltlist->e[meltchunksz++];
     }
-    e->hashval = hashval;
     e->add = FALSE;
     e->idx = nil_value;
     e->val = nil_value;
-    i = hashval % h->tablesize;
-    e->next = h->table[i];
-    h->table[i] = e;
+    map_slot(h, hashval, e);
 
     return e;
 }
@@ -1847,12 +2349,11 @@ static mapelt *map_grow(dataspace *data, array *m, Uint hashval, bool add)
 value *map_index(dataspace *data, array *m, value *val, value *elt,
 		 value *verify)
 {
-    Uint i;
-    mapelt *e, **p;
+    Uint i, j;
+    maphash *h;
+    mapelt *e;
     bool del, add, hash;
 
-    i = 0;
-
     if (elt != (value *) NULL && VAL_NIL(elt)) {
 	elt = (value *) NULL;
 	del = TRUE;
@@ -1865,39 +2366,14 @@ value *map_index(dataspace *data, array *m, value *val, value *elt,
 	map_dehash(data, m, FALSE);
     }
 
-    switch (val->type) {
-    case T_NIL:
-	i = 4747;
-	break;
-
-    case T_INT:
-	i = val->u.number;
-	break;
-
-    case T_FLOAT:
-	i = VFLT_HASH(val);
-	break;
-
-    case T_STRING:
-	i = hashstr(val->u.string->text, STRMAPHASHSZ) ^ val->u.string->len;
-	break;
-
-    case T_OBJECT:
-	i = val->oindex;
-	break;
-
-    case T_ARRAY:
-    case T_MAPPING:
-    case T_LWOBJECT:
-	i = (unsigned short) ((uintptr_t) val->u.array >> 3);
-	break;
-    }
+    i = map_hash(val);
 
     hash = FALSE;
-    if (m->hashed != (maphash *) NULL) {
-	for (p = &m->hashed->table[i % m->hashed->tablesize];
-	     (e=*p) != (mapelt *) NULL; p = &e->next) {
-	    if (cmp(val, &e->idx) == 0 &&
+    if ((h=m->hashed) != (maphash *) NULL) {
+	for (j = i & (h->tablesize - 1); (e=h->table[j].elt) != (mapelt *) NULL;
+	     j = (j + 1) & (h->tablesize - 1)) {
+	    if (e != MELT_DELETED && h->table[j].hashval == i &&
+		cmp(val, &e->idx) == 0 &&
 		(!T_INDEXED(val->type) || val->u.array == e->idx.u.array)) {
 		/*
 		 * found in the hashtable
@@ -1930,15 +2406,16 @@ value *map_index(dataspace *data, array *m, value *val, value *elt,
 		    if (add) {
 			d_assign_elt(data, m, &e->idx, &nil_value);
 			d_assign_elt(data, m, &e->val, &nil_value);
-			if (--m->hashed->sizemod == 0) {
+			if (--h->sizemod == 0) {
 			    m->hashmod = FALSE;
 			}
 		    }
 
-		    *p = e->next;
+		    h->table[j].elt = MELT_DELETED;
+		    h->ndeleted++;
 		    e->next = fmelt;
 		    fmelt = e;
-		    m->hashed->size--;
+		    h->size--;
 
 		    if (!add) {
 			break;		/* change array part also */
@@ -2031,7 +2508,7 @@ value *map_index(dataspace *data, array *m, value *val, value *elt,
  */
 array *map_range(dataspace *data, array *m, value *v1, value *v2)
 {
-    unsigned short from, to;
+    asizet from, to;
     array *range;
 
     map_compact(data, m);
@@ -2070,7 +2547,7 @@ array *map_indices(dataspace *data, array *m)
 {
     array *indices;
     value *v1, *v2;
-    unsigned short n;
+    asizet n;
 
     map_compact(data, m);
     indices = arr_new(data, (long) (n = m->size >> 1));
@@ -2092,7 +2569,7 @@ array *map_values(dataspace *data, array *m)
 {
     array *values;
     value *v1, *v2;
-    unsigned short n;
+    asizet n;
 
     map_compact(data, m);
     values = arr_new(data, (long) (n = m->size >> 1));
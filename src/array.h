@@ -18,17 +18,31 @@
  */
 
 struct _array_ {
-    unsigned short size;		/* number of elements */
+    asizet size;			/* number of elements */
     bool hashmod;			/* hashed part contains new elements */
+    char ptype;				/* type of packed elements */
     Uint ref;				/* number of references */
     Uint tag;				/* used in sorting */
     Uint odcount;			/* last destructed object count */
     value *elts;			/* elements */
+    char *packed;			/* packed int or float elements */
     struct _maphash_ *hashed;		/* hashed mapping elements */
     struct _arrref_ *primary;		/* primary reference */
     array *prev, *next;			/* per-object linked list */
 };
 
+/*
+ * Packed arrays hold either Ints, or floats stored as the low longwords
+ * of all elements followed by the high words.
+ */
+# define PKD_SIZE(type, n)	((Uint) (n) * (((type) == T_INT) ?	\
+				 sizeof(Int) :				\
+				 sizeof(Uint) + sizeof(unsigned short)))
+# define PKD_INTS(a)		((Int *) (a)->packed)
+# define PKD_LOWS(a)		((Uint *) (a)->packed)
+# define PKD_HIGHS(a)		((unsigned short *) ((a)->packed +	\
+						     (a)->size * sizeof(Uint)))
+
 typedef struct _arrmerge_ arrmerge;	/* array merge table */
 typedef struct _abchunk_ abchunk;	/* array backup chunk */
 
@@ -36,6 +50,10 @@ extern void		arr_init	(unsigned int);
 extern array	       *arr_alloc	(unsigned int);
 extern array	       *arr_new		(dataspace*, long);
 extern array	       *arr_ext_new	(dataspace*, long);
+extern array	       *arr_new_packed	(dataspace*, long, int);
+extern void		arr_unpack	(array*);
+extern void		arr_get_packed	(array*, asizet, value*);
+extern void		arr_put_packed	(array*, asizet, value*);
 # define arr_ref(a)	((a)->ref++)
 extern void		arr_del		(array*);
 extern void		arr_freelist	(array*);
@@ -46,6 +64,7 @@ extern Uint		arr_put		(array*, Uint);
 extern void		arr_clear	(void);
 
 extern void		arr_backup	(abchunk**, array*);
+extern void		arr_backup_elt	(abchunk**, array*, unsigned int);
 extern void		arr_commit	(abchunk**, dataplane*, int);
 extern void		arr_discard	(abchunk**);
 
@@ -54,15 +73,17 @@ extern array	       *arr_sub		(dataspace*, array*, array*);
 extern array	       *arr_intersect	(dataspace*, array*, array*);
 extern array	       *arr_setadd	(dataspace*, array*, array*);
 extern array	       *arr_setxadd	(dataspace*, array*, array*);
-extern unsigned short	arr_index	(array*, long);
+extern asizet		arr_index	(array*, long);
 extern void		arr_ckrange	(array*, long, long);
 extern array	       *arr_range	(dataspace*, array*, long, long);
+extern array	       *arr_sort	(dataspace*, array*);
 
 extern array	       *map_new		(dataspace*, long);
 extern void		map_sort	(array*);
 extern void		map_rmhash	(array*);
+extern Uint		map_hashmem	(array*);
 extern void		map_compact	(dataspace*, array*);
-extern unsigned short	map_size	(dataspace*, array*);
+extern asizet		map_size	(dataspace*, array*);
 extern array	       *map_add		(dataspace*, array*, array*);
 extern array	       *map_sub		(dataspace*, array*, array*);
 extern array	       *map_intersect	(dataspace*, array*, array*);
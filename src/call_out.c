@@ -558,7 +558,7 @@ void co_del(unsigned int oindex, unsigned int handle, Uint t, unsigned int m)
 void co_list(array *a)
 {
     value *v, *w;
-    unsigned short i;
+    asizet i;
     Uint t;
     unsigned short m;
     xfloat flt1, flt2;
@@ -586,6 +586,33 @@ void co_list(array *a)
     }
 }
 
+/*
+ * NAME:	call_out->objects()
+ * DESCRIPTION:	return a list of the objects that have callouts, which may
+ *		contain the same object more than once
+ */
+uindex co_objects(uindex **list)
+{
+    call_out *co;
+    uindex i, n, *l;
+
+    n = queuebrk + cotabsz - cycbrk;
+    if (n == 0) {
+	*list = (uindex *) NULL;
+	return 0;
+    }
+    *list = l = ALLOC(uindex, n);
+    for (co = cotab, i = queuebrk; i != 0; co++, --i) {
+	*l++ = co->oindex;
+    }
+    for (co = cotab + cycbrk, i = cotabsz - cycbrk; i != 0; co++, --i) {
+	if (co->handle != 0) {
+	    *l++ = co->oindex;
+	}
+    }
+    return l - *list;
+}
+
 /*
  * NAME:	call_out->expire()
  * DESCRIPTION:	collect callouts to run next
@@ -26,6 +26,7 @@ extern Int	co_remaining	(Uint, unsigned short*);
 extern void	co_del		(unsigned int, unsigned int, Uint,
 				   unsigned int);
 extern void	co_list		(array*);
+extern uindex	co_objects	(uindex**);
 extern void	co_call		(frame*);
 extern void	co_info    	(uindex*, uindex*);
 extern Uint	co_decode	(Uint, unsigned short*);
@@ -560,20 +560,20 @@ int comm_send(object *obj, string *str)
 
     usr = &users[EINDEX(obj->etabi)];
     if (usr->flags & CF_TELNET) {
-	char outbuf[OUTBUF_SIZE];
-	char *p, *q;
-	unsigned int len, size, n, length;
+	char buffer[OUTBUF_SIZE];
+	char *outbuf, *p, *q;
+	unsigned int len, size, n;
 
 	/*
 	 * telnet connection
 	 */
 	p = str->text;
 	len = str->len;
+	outbuf = (len <= OUTBUF_SIZE / 2) ? buffer : ALLOC(char, 2 * len);
 	q = outbuf;
 	size = 0;
-	length = 0;
 	for (;;) {
-	    if (len == 0 || size >= OUTBUF_SIZE - 1 || UCHAR(*p) == IAC) {
+	    if (len == 0 || UCHAR(*p) == IAC) {
 		n = comm_write(usr, obj, (string *) NULL, outbuf, size);
 		if (n != size) {
 		    /*
@@ -594,9 +594,15 @@ int comm_send(object *obj, string *str)
 			    len++;
 			}
 		    }
+		    if (outbuf != buffer) {
+			FREE(outbuf);
+		    }
 		    return str->len - len;
 		}
 		if (len == 0) {
+		    if (outbuf != buffer) {
+			FREE(outbuf);
+		    }
 		    return str->len;
 		}
 		size = 0;
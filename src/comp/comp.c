@@ -464,7 +464,7 @@ void pc_restore(int fd, int conv)
  * NAME:	swap->init()
  * DESCRIPTION:	pretend to initialize the swap device
  */
-bool sw_init(char *file, unsigned int total, unsigned int cache, unsigned int secsize)
+bool sw_init(char *file, unsigned int total, unsigned int cache, unsigned int secsize, int policy, bool mapped, unsigned int chain)
 {
     return TRUE;
 }
@@ -559,6 +559,31 @@ sector sw_count()
     return 0;
 }
 
+/*
+ * NAME:	swap->prefetch()
+ * DESCRIPTION:	pretend to read ahead a vector of sectors
+ */
+void sw_prefetch(sector sec)
+{
+}
+
+/*
+ * NAME:	swap->peek()
+ * DESCRIPTION:	pretend to read the start of a sector
+ */
+void sw_peek(char *m, sector sec, Uint size)
+{
+}
+
+/*
+ * NAME:	swap->cachestat()
+ * DESCRIPTION:	pretend to return swap cache statistics
+ */
+void sw_cachestat(Uint *stat)
+{
+    stat[0] = stat[1] = stat[2] = 0;
+}
+
 /*
  * NAME:	swap->copy()
  * DESCRIPTION:	pretend to copy a vector of sectors to a dump file
@@ -572,16 +597,33 @@ bool sw_copy(Uint time)
  * NAME:	swap->dump()
  * DESCRIPTION:	pretend to dump swap file
  */
-int sw_dump(char *dumpfile)
+int sw_dump(char *dumpfile, bool bg)
+{
+    return 0;
+}
+
+/*
+ * NAME:	swap->dumpfd()
+ * DESCRIPTION:	pretend to reopen the dump file
+ */
+int sw_dumpfd()
 {
     return 0;
 }
 
+/*
+ * NAME:	swap->dumped()
+ * DESCRIPTION:	pretend that the snapshot has been written
+ */
+void sw_dumped(bool ok)
+{
+}
+
 /*
  * NAME:	swap->restore()
  * DESCRIPTION:	pretend to restore swap file
  */
-void sw_restore(int fd, unsigned int secsize)
+void sw_restore(int fd, unsigned int secsize, int conv)
 {
 }
 
@@ -866,6 +908,16 @@ void co_info(uindex *n1, uindex *n2)
 {
 }
 
+/*
+ * NAME:	call_out->objects()
+ * DESCRIPTION:	pretend to list the objects that have callouts
+ */
+uindex co_objects(uindex **list)
+{
+    *list = (uindex *) NULL;
+    return 0;
+}
+
 /*
  * NAME:	call_out->decode()
  * DESCRIPTION:	pretend to decode a callout time
@@ -35,11 +35,11 @@ typedef struct _oh_ {		/* object hash table */
     object *obj;		/* object */
     short index;		/* -1: new */
     short priv;			/* 1: direct private, 2: indirect private */
-    struct _oh_ **next;		/* next in linked list */
+    struct _oh_ *next;		/* next in linked list */
 } oh;
 
 static hashtab *otab;		/* object hash table */
-static oh **olist;		/* list of all object hash table entries */
+static oh *olist;		/* list of all object hash table entries */
 
 /*
  * NAME:	oh->init()
@@ -63,13 +63,12 @@ static oh *oh_new(char *name)
 	/*
 	 * new object
 	 */
-	*h = ALLOC(oh, 1);
-	(*h)->chain.next = (hte *) NULL;
+	ht_insert(otab, (hte **) h, (hte *) ALLOC(oh, 1));
 	(*h)->chain.name = name;
 	(*h)->index = -1;		/* new object */
 	(*h)->priv = 0;
 	(*h)->next = olist;
-	olist = h;
+	olist = *h;
     }
 
     return *h;
@@ -81,14 +80,14 @@ static oh *oh_new(char *name)
  */
 static void oh_clear()
 {
-    oh **h, *f;
+    oh *h, *f;
 
-    for (h = olist; h != (oh **) NULL; ) {
-	f = *h;
+    for (h = olist; h != (oh *) NULL; ) {
+	f = h;
 	h = f->next;
 	FREE(f);
     }
-    olist = (oh **) NULL;
+    olist = (oh *) NULL;
 
     if (otab != (hashtab *) NULL) {
 	ht_del(otab);
@@ -121,7 +120,7 @@ static int vfhchunksz = VFH_CHUNK; /* size of current vfh chunk */
  * DESCRIPTION:	create a new vfh table element
  */
 static void vfh_new(string *str, oh *ohash, unsigned short ct, 
-	string *cvstr, short idx, vfh **addr)
+	string *cvstr, short idx, hashtab *ht, vfh **addr)
 {
     vfh *h;
 
@@ -134,8 +133,7 @@ static void vfh_new(string *str, oh *ohash, unsigned short ct,
 	vfhchunksz = 0;
     }
     h = &vfhclist->vf[vfhchunksz++];
-    h->chain.next = (hte *) *addr;
-    *addr = h;
+    ht_insert(ht, (hte **) addr, (hte *) h);
     h->chain.name = str->text;
     str_ref(h->str = str);
     h->ohash = ohash;
@@ -282,7 +280,7 @@ static void ctrl_vardefs(oh *ohash, control *ctrl)
 		} else {
 		    cvstr = (string *) NULL;
 		}
-		vfh_new(str, ohash, v->type, cvstr, n, h);
+		vfh_new(str, ohash, v->type, cvstr, n, vtab, h);
 	    } else {
 	       /* duplicate variable */
 	       c_error("multiple inheritance of variable %s (/%s, /%s)",
@@ -404,7 +402,7 @@ static void ctrl_funcdef(control *ctrl, int idx, oh *ohash)
 	/*
 	 * New function (-1: no calls to it yet)
 	 */
-	vfh_new(str, ohash, -1, (string *) NULL, idx, h);
+	vfh_new(str, ohash, -1, (string *) NULL, idx, ftab, h);
 	if (ohash->priv == 0 &&
 	    (ctrl->ninherits != 1 ||
 	     (f->class & (C_STATIC | C_UNDEFINED)) != C_STATIC)) {
@@ -563,7 +561,7 @@ static void ctrl_funcdef(control *ctrl, int idx, oh *ohash)
 
 	if (inhflag) {
 	    /* insert new prototype at the beginning */
-	    vfh_new(str, ohash, -1, (string *) NULL, idx, h);
+	    vfh_new(str, ohash, -1, (string *) NULL, idx, ftab, h);
 	    h = (vfh **) &(*h)->chain.next;
 	} else if (!(PROTO_CLASS(prot1) & C_UNDEFINED)) {
 	    /* add the new prototype to the count */
@@ -598,7 +596,7 @@ static void ctrl_funcdef(control *ctrl, int idx, oh *ohash)
 		}
 	    } else if (nfunc + npriv > 1) {
 		/* add new clash marker as first entry */
-		vfh_new(str, (oh *) NULL, 0, (string *) NULL, nfunc, h);
+		vfh_new(str, (oh *) NULL, 0, (string *) NULL, nfunc, ftab, h);
 		nfclash++;
 		h = (vfh **) &(*h)->chain.next;
 	    }
@@ -607,9 +605,9 @@ static void ctrl_funcdef(control *ctrl, int idx, oh *ohash)
 	/* add new prototype, undefined at the end */
 	if (!inhflag) {
 	    if (PROTO_CLASS(prot1) & C_UNDEFINED) {
-		vfh_new(str, ohash, -1, (string *) NULL, idx, l);
+		vfh_new(str, ohash, -1, (string *) NULL, idx, ftab, l);
 	    } else {
-		vfh_new(str, ohash, -1, (string *) NULL, idx, h);
+		vfh_new(str, ohash, -1, (string *) NULL, idx, ftab, h);
 	    }
 	}
     }
@@ -885,12 +883,12 @@ void ctrl_convert(control *ctrl)
     dinherit *inh;
     object *obj;
     hashtab *xotab;
-    oh **xolist;
+    oh *xolist;
 
     xotab = otab;
     xolist = olist;
     oh_init();
-    olist = (oh **) NULL;
+    olist = (oh *) NULL;
 
     imapsz = 0;
     for (n = 0, inh = ctrl->inherits; n < ctrl->ninherits; n++, inh++) {
@@ -1171,7 +1169,7 @@ void ctrl_dproto(string *str, char *proto, string *class)
     /*
      * Actual definition.
      */
-    vfh_new(str, newohash, -1, (string *) NULL, nfdefs, h);
+    vfh_new(str, newohash, -1, (string *) NULL, nfdefs, ftab, h);
     s = ctrl_dstring(str);
     i = PROTO_SIZE(proto);
     functions[nfdefs].name = str->text;
@@ -1239,7 +1237,7 @@ void ctrl_dvar(string *str, unsigned int class, unsigned int type, string *cvstr
     }
 
     /* actually define the variable */
-    vfh_new(str, newohash, type, cvstr, nvars, h);
+    vfh_new(str, newohash, type, cvstr, nvars, vtab, h);
     s = ctrl_dstring(str);
     var = &variables[nvars];
     var->class = class;
@@ -0,0 +1,4179 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison implementation for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* C LALR(1) parser skeleton written by Richard Stallman, by
+   simplifying the original so-called "semantic" parser.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+/* All symbols defined below should begin with yy or YY, to avoid
+   infringing on user name space.  This should be done even for local
+   variables, as they might otherwise be expanded by user macros.
+   There are some unavoidable exceptions within include files to
+   define necessary library symbols; they are noted "INFRINGES ON
+   USER NAME SPACE" below.  */
+
+/* Identify Bison output, and Bison version.  */
+#define YYBISON 30802
+
+/* Bison version string.  */
+#define YYBISON_VERSION "3.8.2"
+
+/* Skeleton name.  */
+#define YYSKELETON_NAME "yacc.c"
+
+/* Pure parsers.  */
+#define YYPURE 0
+
+/* Push parsers.  */
+#define YYPUSH 0
+
+/* Pull parsers.  */
+#define YYPULL 1
+
+
+
+
+/* First part of user prologue.  */
+#line 26 "parser.y"
+
+
+# define INCLUDE_CTYPE
+# include "comp.h"
+# include "str.h"
+# include "array.h"
+# include "object.h"
+# include "xfloat.h"
+# include "interpret.h"
+# include "macro.h"
+# include "token.h"
+# include "ppcontrol.h"
+# include "node.h"
+# include "compile.h"
+
+# define yylex		pp_gettok
+# define yyerror	c_error
+
+int nerrors;			/* number of errors encountered so far */
+static int ndeclarations;	/* number of declarations */
+static int nstatements;		/* number of statements in current function */
+static bool typechecking;	/* does the current function have it? */
+
+static void  t_void	(node*);
+static bool  t_unary	(node*, char*);
+static node *uassign	(int, node*, char*);
+static node *cast	(node*, node*);
+static node *idx	(node*, node*);
+static node *range	(node*, node*, node*);
+static node *bini	(int, node*, node*, char*);
+static node *bina	(int, node*, node*, char*);
+static node *mult	(int, node*, node*, char*);
+static node *mdiv	(int, node*, node*, char*);
+static node *mod	(int, node*, node*, char*);
+static node *add	(int, node*, node*, char*);
+static node *sub	(int, node*, node*, char*);
+static node *umin	(node*);
+static node *lshift	(int, node*, node*, char*);
+static node *rshift	(int, node*, node*, char*);
+static node *rel	(int, node*, node*, char*);
+static node *eq		(node*, node*);
+static node *and	(int, node*, node*, char*);
+static node *xor	(int, node*, node*, char*);
+static node *or		(int, node*, node*, char*);
+static node *land	(node*, node*);
+static node *lor	(node*, node*);
+static node *quest	(node*, node*, node*);
+static node *assign	(node*, node*);
+static node *comma	(node*, node*);
+
+
+#line 123 "y.tab.c"
+
+# ifndef YY_CAST
+#  ifdef __cplusplus
+#   define YY_CAST(Type, Val) static_cast<Type> (Val)
+#   define YY_REINTERPRET_CAST(Type, Val) reinterpret_cast<Type> (Val)
+#  else
+#   define YY_CAST(Type, Val) ((Type) (Val))
+#   define YY_REINTERPRET_CAST(Type, Val) ((Type) (Val))
+#  endif
+# endif
+# ifndef YY_NULLPTR
+#  if defined __cplusplus
+#   if 201103L <= __cplusplus
+#    define YY_NULLPTR nullptr
+#   else
+#    define YY_NULLPTR 0
+#   endif
+#  else
+#   define YY_NULLPTR ((void*)0)
+#  endif
+# endif
+
+/* Use api.header.include to #include this header
+   instead of duplicating it here.  */
+#ifndef YY_YY_Y_TAB_H_INCLUDED
+# define YY_YY_Y_TAB_H_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
+
+/* Token kinds.  */
+#ifndef YYTOKENTYPE
+# define YYTOKENTYPE
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    NIL = 258,                     /* NIL  */
+    BREAK = 259,                   /* BREAK  */
+    DO = 260,                      /* DO  */
+    MAPPING = 261,                 /* MAPPING  */
+    ELSE = 262,                    /* ELSE  */
+    CASE = 263,                    /* CASE  */
+    OBJECT = 264,                  /* OBJECT  */
+    DEFAULT = 265,                 /* DEFAULT  */
+    STATIC = 266,                  /* STATIC  */
+    CONTINUE = 267,                /* CONTINUE  */
+    INT = 268,                     /* INT  */
+    FLOAT = 269,                   /* FLOAT  */
+    RLIMITS = 270,                 /* RLIMITS  */
+    FOR = 271,                     /* FOR  */
+    INHERIT = 272,                 /* INHERIT  */
+    IF = 273,                      /* IF  */
+    GOTO = 274,                    /* GOTO  */
+    RETURN = 275,                  /* RETURN  */
+    MIXED = 276,                   /* MIXED  */
+    STRING = 277,                  /* STRING  */
+    WHILE = 278,                   /* WHILE  */
+    FUNCTION = 279,                /* FUNCTION  */
+    CATCH = 280,                   /* CATCH  */
+    SWITCH = 281,                  /* SWITCH  */
+    VOID = 282,                    /* VOID  */
+    PRIVATE = 283,                 /* PRIVATE  */
+    ATOMIC = 284,                  /* ATOMIC  */
+    NOMASK = 285,                  /* NOMASK  */
+    VARARGS = 286,                 /* VARARGS  */
+    LARROW = 287,                  /* LARROW  */
+    RARROW = 288,                  /* RARROW  */
+    PLUS_PLUS = 289,               /* PLUS_PLUS  */
+    MIN_MIN = 290,                 /* MIN_MIN  */
+    LSHIFT = 291,                  /* LSHIFT  */
+    RSHIFT = 292,                  /* RSHIFT  */
+    LE = 293,                      /* LE  */
+    GE = 294,                      /* GE  */
+    EQ = 295,                      /* EQ  */
+    NE = 296,                      /* NE  */
+    LAND = 297,                    /* LAND  */
+    LOR = 298,                     /* LOR  */
+    PLUS_EQ = 299,                 /* PLUS_EQ  */
+    MIN_EQ = 300,                  /* MIN_EQ  */
+    MULT_EQ = 301,                 /* MULT_EQ  */
+    DIV_EQ = 302,                  /* DIV_EQ  */
+    MOD_EQ = 303,                  /* MOD_EQ  */
+    LSHIFT_EQ = 304,               /* LSHIFT_EQ  */
+    RSHIFT_EQ = 305,               /* RSHIFT_EQ  */
+    AND_EQ = 306,                  /* AND_EQ  */
+    XOR_EQ = 307,                  /* XOR_EQ  */
+    OR_EQ = 308,                   /* OR_EQ  */
+    COLON_COLON = 309,             /* COLON_COLON  */
+    DOT_DOT = 310,                 /* DOT_DOT  */
+    ELLIPSIS = 311,                /* ELLIPSIS  */
+    STRING_CONST = 312,            /* STRING_CONST  */
+    IDENTIFIER = 313,              /* IDENTIFIER  */
+    INT_CONST = 314,               /* INT_CONST  */
+    FLOAT_CONST = 315,             /* FLOAT_CONST  */
+    MARK = 316,                    /* MARK  */
+    HASH = 317,                    /* HASH  */
+    HASH_HASH = 318,               /* HASH_HASH  */
+    INCL_CONST = 319,              /* INCL_CONST  */
+    NR_TOKENS = 320                /* NR_TOKENS  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
+#endif
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
+#define NIL 258
+#define BREAK 259
+#define DO 260
+#define MAPPING 261
+#define ELSE 262
+#define CASE 263
+#define OBJECT 264
+#define DEFAULT 265
+#define STATIC 266
+#define CONTINUE 267
+#define INT 268
+#define FLOAT 269
+#define RLIMITS 270
+#define FOR 271
+#define INHERIT 272
+#define IF 273
+#define GOTO 274
+#define RETURN 275
+#define MIXED 276
+#define STRING 277
+#define WHILE 278
+#define FUNCTION 279
+#define CATCH 280
+#define SWITCH 281
+#define VOID 282
+#define PRIVATE 283
+#define ATOMIC 284
+#define NOMASK 285
+#define VARARGS 286
+#define LARROW 287
+#define RARROW 288
+#define PLUS_PLUS 289
+#define MIN_MIN 290
+#define LSHIFT 291
+#define RSHIFT 292
+#define LE 293
+#define GE 294
+#define EQ 295
+#define NE 296
+#define LAND 297
+#define LOR 298
+#define PLUS_EQ 299
+#define MIN_EQ 300
+#define MULT_EQ 301
+#define DIV_EQ 302
+#define MOD_EQ 303
+#define LSHIFT_EQ 304
+#define RSHIFT_EQ 305
+#define AND_EQ 306
+#define XOR_EQ 307
+#define OR_EQ 308
+#define COLON_COLON 309
+#define DOT_DOT 310
+#define ELLIPSIS 311
+#define STRING_CONST 312
+#define IDENTIFIER 313
+#define INT_CONST 314
+#define FLOAT_CONST 315
+#define MARK 316
+#define HASH 317
+#define HASH_HASH 318
+#define INCL_CONST 319
+#define NR_TOKENS 320
+
+/* Value type.  */
+#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
+union YYSTYPE
+{
+#line 93 "parser.y"
+
+    Int number;			/* lex input */
+    xfloat real;		/* lex input */
+    unsigned short type;	/* internal */
+    struct _node_ *node;	/* internal */
+
+#line 313 "y.tab.c"
+
+};
+typedef union YYSTYPE YYSTYPE;
+# define YYSTYPE_IS_TRIVIAL 1
+# define YYSTYPE_IS_DECLARED 1
+#endif
+
+
+extern YYSTYPE yylval;
+
+
+int yyparse (void);
+
+
+#endif /* !YY_YY_Y_TAB_H_INCLUDED  */
+/* Symbol kind.  */
+enum yysymbol_kind_t
+{
+  YYSYMBOL_YYEMPTY = -2,
+  YYSYMBOL_YYEOF = 0,                      /* "end of file"  */
+  YYSYMBOL_YYerror = 1,                    /* error  */
+  YYSYMBOL_YYUNDEF = 2,                    /* "invalid token"  */
+  YYSYMBOL_NIL = 3,                        /* NIL  */
+  YYSYMBOL_BREAK = 4,                      /* BREAK  */
+  YYSYMBOL_DO = 5,                         /* DO  */
+  YYSYMBOL_MAPPING = 6,                    /* MAPPING  */
+  YYSYMBOL_ELSE = 7,                       /* ELSE  */
+  YYSYMBOL_CASE = 8,                       /* CASE  */
+  YYSYMBOL_OBJECT = 9,                     /* OBJECT  */
+  YYSYMBOL_DEFAULT = 10,                   /* DEFAULT  */
+  YYSYMBOL_STATIC = 11,                    /* STATIC  */
+  YYSYMBOL_CONTINUE = 12,                  /* CONTINUE  */
+  YYSYMBOL_INT = 13,                       /* INT  */
+  YYSYMBOL_FLOAT = 14,                     /* FLOAT  */
+  YYSYMBOL_RLIMITS = 15,                   /* RLIMITS  */
+  YYSYMBOL_FOR = 16,                       /* FOR  */
+  YYSYMBOL_INHERIT = 17,                   /* INHERIT  */
+  YYSYMBOL_IF = 18,                        /* IF  */
+  YYSYMBOL_GOTO = 19,                      /* GOTO  */
+  YYSYMBOL_RETURN = 20,                    /* RETURN  */
+  YYSYMBOL_MIXED = 21,                     /* MIXED  */
+  YYSYMBOL_STRING = 22,                    /* STRING  */
+  YYSYMBOL_WHILE = 23,                     /* WHILE  */
+  YYSYMBOL_FUNCTION = 24,                  /* FUNCTION  */
+  YYSYMBOL_CATCH = 25,                     /* CATCH  */
+  YYSYMBOL_SWITCH = 26,                    /* SWITCH  */
+  YYSYMBOL_VOID = 27,                      /* VOID  */
+  YYSYMBOL_PRIVATE = 28,                   /* PRIVATE  */
+  YYSYMBOL_ATOMIC = 29,                    /* ATOMIC  */
+  YYSYMBOL_NOMASK = 30,                    /* NOMASK  */
+  YYSYMBOL_VARARGS = 31,                   /* VARARGS  */
+  YYSYMBOL_LARROW = 32,                    /* LARROW  */
+  YYSYMBOL_RARROW = 33,                    /* RARROW  */
+  YYSYMBOL_PLUS_PLUS = 34,                 /* PLUS_PLUS  */
+  YYSYMBOL_MIN_MIN = 35,                   /* MIN_MIN  */
+  YYSYMBOL_LSHIFT = 36,                    /* LSHIFT  */
+  YYSYMBOL_RSHIFT = 37,                    /* RSHIFT  */
+  YYSYMBOL_LE = 38,                        /* LE  */
+  YYSYMBOL_GE = 39,                        /* GE  */
+  YYSYMBOL_EQ = 40,                        /* EQ  */
+  YYSYMBOL_NE = 41,                        /* NE  */
+  YYSYMBOL_LAND = 42,                      /* LAND  */
+  YYSYMBOL_LOR = 43,                       /* LOR  */
+  YYSYMBOL_PLUS_EQ = 44,                   /* PLUS_EQ  */
+  YYSYMBOL_MIN_EQ = 45,                    /* MIN_EQ  */
+  YYSYMBOL_MULT_EQ = 46,                   /* MULT_EQ  */
+  YYSYMBOL_DIV_EQ = 47,                    /* DIV_EQ  */
+  YYSYMBOL_MOD_EQ = 48,                    /* MOD_EQ  */
+  YYSYMBOL_LSHIFT_EQ = 49,                 /* LSHIFT_EQ  */
+  YYSYMBOL_RSHIFT_EQ = 50,                 /* RSHIFT_EQ  */
+  YYSYMBOL_AND_EQ = 51,                    /* AND_EQ  */
+  YYSYMBOL_XOR_EQ = 52,                    /* XOR_EQ  */
+  YYSYMBOL_OR_EQ = 53,                     /* OR_EQ  */
+  YYSYMBOL_COLON_COLON = 54,               /* COLON_COLON  */
+  YYSYMBOL_DOT_DOT = 55,                   /* DOT_DOT  */
+  YYSYMBOL_ELLIPSIS = 56,                  /* ELLIPSIS  */
+  YYSYMBOL_STRING_CONST = 57,              /* STRING_CONST  */
+  YYSYMBOL_IDENTIFIER = 58,                /* IDENTIFIER  */
+  YYSYMBOL_INT_CONST = 59,                 /* INT_CONST  */
+  YYSYMBOL_FLOAT_CONST = 60,               /* FLOAT_CONST  */
+  YYSYMBOL_MARK = 61,                      /* MARK  */
+  YYSYMBOL_HASH = 62,                      /* HASH  */
+  YYSYMBOL_HASH_HASH = 63,                 /* HASH_HASH  */
+  YYSYMBOL_INCL_CONST = 64,                /* INCL_CONST  */
+  YYSYMBOL_NR_TOKENS = 65,                 /* NR_TOKENS  */
+  YYSYMBOL_66_ = 66,                       /* ';'  */
+  YYSYMBOL_67_ = 67,                       /* '+'  */
+  YYSYMBOL_68_ = 68,                       /* '('  */
+  YYSYMBOL_69_ = 69,                       /* ')'  */
+  YYSYMBOL_70_ = 70,                       /* ','  */
+  YYSYMBOL_71_ = 71,                       /* '*'  */
+  YYSYMBOL_72_ = 72,                       /* ':'  */
+  YYSYMBOL_73_ = 73,                       /* '{'  */
+  YYSYMBOL_74_ = 74,                       /* '}'  */
+  YYSYMBOL_75_ = 75,                       /* '['  */
+  YYSYMBOL_76_ = 76,                       /* ']'  */
+  YYSYMBOL_77_ = 77,                       /* '&'  */
+  YYSYMBOL_78_ = 78,                       /* '-'  */
+  YYSYMBOL_79_ = 79,                       /* '!'  */
+  YYSYMBOL_80_ = 80,                       /* '~'  */
+  YYSYMBOL_81_ = 81,                       /* '/'  */
+  YYSYMBOL_82_ = 82,                       /* '%'  */
+  YYSYMBOL_83_ = 83,                       /* '<'  */
+  YYSYMBOL_84_ = 84,                       /* '>'  */
+  YYSYMBOL_85_ = 85,                       /* '^'  */
+  YYSYMBOL_86_ = 86,                       /* '|'  */
+  YYSYMBOL_87_ = 87,                       /* '?'  */
+  YYSYMBOL_88_ = 88,                       /* '='  */
+  YYSYMBOL_YYACCEPT = 89,                  /* $accept  */
+  YYSYMBOL_program = 90,                   /* program  */
+  YYSYMBOL_91_1 = 91,                      /* $@1  */
+  YYSYMBOL_top_level_declarations = 92,    /* top_level_declarations  */
+  YYSYMBOL_top_level_declaration = 93,     /* top_level_declaration  */
+  YYSYMBOL_opt_inherit_label = 94,         /* opt_inherit_label  */
+  YYSYMBOL_ident = 95,                     /* ident  */
+  YYSYMBOL_composite_string = 96,          /* composite_string  */
+  YYSYMBOL_string = 97,                    /* string  */
+  YYSYMBOL_data_declaration = 98,          /* data_declaration  */
+  YYSYMBOL_function_declaration = 99,      /* function_declaration  */
+  YYSYMBOL_100_2 = 100,                    /* $@2  */
+  YYSYMBOL_101_3 = 101,                    /* $@3  */
+  YYSYMBOL_local_data_declaration = 102,   /* local_data_declaration  */
+  YYSYMBOL_formals_declaration = 103,      /* formals_declaration  */
+  YYSYMBOL_formal_declaration_list = 104,  /* formal_declaration_list  */
+  YYSYMBOL_varargs_formal_declaration = 105, /* varargs_formal_declaration  */
+  YYSYMBOL_formal_declaration = 106,       /* formal_declaration  */
+  YYSYMBOL_class_specifier_list = 107,     /* class_specifier_list  */
+  YYSYMBOL_class_specifier_list2 = 108,    /* class_specifier_list2  */
+  YYSYMBOL_class_specifier = 109,          /* class_specifier  */
+  YYSYMBOL_opt_private = 110,              /* opt_private  */
+  YYSYMBOL_non_private = 111,              /* non_private  */
+  YYSYMBOL_type_specifier = 112,           /* type_specifier  */
+  YYSYMBOL_star_list = 113,                /* star_list  */
+  YYSYMBOL_data_dcltr = 114,               /* data_dcltr  */
+  YYSYMBOL_function_dcltr = 115,           /* function_dcltr  */
+  YYSYMBOL_dcltr = 116,                    /* dcltr  */
+  YYSYMBOL_list_dcltr = 117,               /* list_dcltr  */
+  YYSYMBOL_dcltr_or_stmt_list = 118,       /* dcltr_or_stmt_list  */
+  YYSYMBOL_dcltr_or_stmt = 119,            /* dcltr_or_stmt  */
+  YYSYMBOL_if_stmt = 120,                  /* if_stmt  */
+  YYSYMBOL_121_4 = 121,                    /* $@4  */
+  YYSYMBOL_stmt = 122,                     /* stmt  */
+  YYSYMBOL_123_5 = 123,                    /* $@5  */
+  YYSYMBOL_124_6 = 124,                    /* $@6  */
+  YYSYMBOL_125_7 = 125,                    /* $@7  */
+  YYSYMBOL_126_8 = 126,                    /* $@8  */
+  YYSYMBOL_127_9 = 127,                    /* $@9  */
+  YYSYMBOL_128_10 = 128,                   /* $@10  */
+  YYSYMBOL_129_11 = 129,                   /* $@11  */
+  YYSYMBOL_130_12 = 130,                   /* $@12  */
+  YYSYMBOL_131_13 = 131,                   /* $@13  */
+  YYSYMBOL_132_14 = 132,                   /* $@14  */
+  YYSYMBOL_133_15 = 133,                   /* $@15  */
+  YYSYMBOL_compound_stmt = 134,            /* compound_stmt  */
+  YYSYMBOL_135_16 = 135,                   /* $@16  */
+  YYSYMBOL_opt_caught_stmt = 136,          /* opt_caught_stmt  */
+  YYSYMBOL_function_name = 137,            /* function_name  */
+  YYSYMBOL_primary_p1_exp = 138,           /* primary_p1_exp  */
+  YYSYMBOL_139_17 = 139,                   /* $@17  */
+  YYSYMBOL_primary_p2_exp = 140,           /* primary_p2_exp  */
+  YYSYMBOL_postfix_exp = 141,              /* postfix_exp  */
+  YYSYMBOL_prefix_exp = 142,               /* prefix_exp  */
+  YYSYMBOL_cast_exp = 143,                 /* cast_exp  */
+  YYSYMBOL_mult_oper_exp = 144,            /* mult_oper_exp  */
+  YYSYMBOL_add_oper_exp = 145,             /* add_oper_exp  */
+  YYSYMBOL_shift_oper_exp = 146,           /* shift_oper_exp  */
+  YYSYMBOL_rel_oper_exp = 147,             /* rel_oper_exp  */
+  YYSYMBOL_equ_oper_exp = 148,             /* equ_oper_exp  */
+  YYSYMBOL_bitand_oper_exp = 149,          /* bitand_oper_exp  */
+  YYSYMBOL_bitxor_oper_exp = 150,          /* bitxor_oper_exp  */
+  YYSYMBOL_bitor_oper_exp = 151,           /* bitor_oper_exp  */
+  YYSYMBOL_and_oper_exp = 152,             /* and_oper_exp  */
+  YYSYMBOL_or_oper_exp = 153,              /* or_oper_exp  */
+  YYSYMBOL_cond_exp = 154,                 /* cond_exp  */
+  YYSYMBOL_155_18 = 155,                   /* $@18  */
+  YYSYMBOL_156_19 = 156,                   /* $@19  */
+  YYSYMBOL_exp = 157,                      /* exp  */
+  YYSYMBOL_list_exp = 158,                 /* list_exp  */
+  YYSYMBOL_opt_list_exp = 159,             /* opt_list_exp  */
+  YYSYMBOL_f_list_exp = 160,               /* f_list_exp  */
+  YYSYMBOL_f_opt_list_exp = 161,           /* f_opt_list_exp  */
+  YYSYMBOL_arg_list = 162,                 /* arg_list  */
+  YYSYMBOL_opt_arg_list = 163,             /* opt_arg_list  */
+  YYSYMBOL_opt_arg_list_comma = 164,       /* opt_arg_list_comma  */
+  YYSYMBOL_assoc_exp = 165,                /* assoc_exp  */
+  YYSYMBOL_assoc_arg_list = 166,           /* assoc_arg_list  */
+  YYSYMBOL_opt_assoc_arg_list_comma = 167  /* opt_assoc_arg_list_comma  */
+};
+typedef enum yysymbol_kind_t yysymbol_kind_t;
+
+
+
+
+#ifdef short
+# undef short
+#endif
+
+/* On compilers that do not define __PTRDIFF_MAX__ etc., make sure
+   <limits.h> and (if available) <stdint.h> are included
+   so that the code can choose integer types of a good width.  */
+
+#ifndef __PTRDIFF_MAX__
+# include <limits.h> /* INFRINGES ON USER NAME SPACE */
+# if defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stdint.h> /* INFRINGES ON USER NAME SPACE */
+#  define YY_STDINT_H
+# endif
+#endif
+
+/* Narrow types that promote to a signed type and that can represent a
+   signed or unsigned integer of at least N bits.  In tables they can
+   save space and decrease cache pressure.  Promoting to a signed type
+   helps avoid bugs in integer arithmetic.  */
+
+#ifdef __INT_LEAST8_MAX__
+typedef __INT_LEAST8_TYPE__ yytype_int8;
+#elif defined YY_STDINT_H
+typedef int_least8_t yytype_int8;
+#else
+typedef signed char yytype_int8;
+#endif
+
+#ifdef __INT_LEAST16_MAX__
+typedef __INT_LEAST16_TYPE__ yytype_int16;
+#elif defined YY_STDINT_H
+typedef int_least16_t yytype_int16;
+#else
+typedef short yytype_int16;
+#endif
+
+/* Work around bug in HP-UX 11.23, which defines these macros
+   incorrectly for preprocessor constants.  This workaround can likely
+   be removed in 2023, as HPE has promised support for HP-UX 11.23
+   (aka HP-UX 11i v2) only through the end of 2022; see Table 2 of
+   <https://h20195.www2.hpe.com/V2/getpdf.aspx/4AA4-7673ENW.pdf>.  */
+#ifdef __hpux
+# undef UINT_LEAST8_MAX
+# undef UINT_LEAST16_MAX
+# define UINT_LEAST8_MAX 255
+# define UINT_LEAST16_MAX 65535
+#endif
+
+#if defined __UINT_LEAST8_MAX__ && __UINT_LEAST8_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST8_TYPE__ yytype_uint8;
+#elif (!defined __UINT_LEAST8_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST8_MAX <= INT_MAX)
+typedef uint_least8_t yytype_uint8;
+#elif !defined __UINT_LEAST8_MAX__ && UCHAR_MAX <= INT_MAX
+typedef unsigned char yytype_uint8;
+#else
+typedef short yytype_uint8;
+#endif
+
+#if defined __UINT_LEAST16_MAX__ && __UINT_LEAST16_MAX__ <= __INT_MAX__
+typedef __UINT_LEAST16_TYPE__ yytype_uint16;
+#elif (!defined __UINT_LEAST16_MAX__ && defined YY_STDINT_H \
+       && UINT_LEAST16_MAX <= INT_MAX)
+typedef uint_least16_t yytype_uint16;
+#elif !defined __UINT_LEAST16_MAX__ && USHRT_MAX <= INT_MAX
+typedef unsigned short yytype_uint16;
+#else
+typedef int yytype_uint16;
+#endif
+
+#ifndef YYPTRDIFF_T
+# if defined __PTRDIFF_TYPE__ && defined __PTRDIFF_MAX__
+#  define YYPTRDIFF_T __PTRDIFF_TYPE__
+#  define YYPTRDIFF_MAXIMUM __PTRDIFF_MAX__
+# elif defined PTRDIFF_MAX
+#  ifndef ptrdiff_t
+#   include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  endif
+#  define YYPTRDIFF_T ptrdiff_t
+#  define YYPTRDIFF_MAXIMUM PTRDIFF_MAX
+# else
+#  define YYPTRDIFF_T long
+#  define YYPTRDIFF_MAXIMUM LONG_MAX
+# endif
+#endif
+
+#ifndef YYSIZE_T
+# ifdef __SIZE_TYPE__
+#  define YYSIZE_T __SIZE_TYPE__
+# elif defined size_t
+#  define YYSIZE_T size_t
+# elif defined __STDC_VERSION__ && 199901 <= __STDC_VERSION__
+#  include <stddef.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYSIZE_T size_t
+# else
+#  define YYSIZE_T unsigned
+# endif
+#endif
+
+#define YYSIZE_MAXIMUM                                  \
+  YY_CAST (YYPTRDIFF_T,                                 \
+           (YYPTRDIFF_MAXIMUM < YY_CAST (YYSIZE_T, -1)  \
+            ? YYPTRDIFF_MAXIMUM                         \
+            : YY_CAST (YYSIZE_T, -1)))
+
+#define YYSIZEOF(X) YY_CAST (YYPTRDIFF_T, sizeof (X))
+
+
+/* Stored state numbers (used for stacks). */
+typedef yytype_int16 yy_state_t;
+
+/* State numbers in computations.  */
+typedef int yy_state_fast_t;
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> /* INFRINGES ON USER NAME SPACE */
+#   define YY_(Msgid) dgettext ("bison-runtime", Msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(Msgid) Msgid
+# endif
+#endif
+
+
+#ifndef YY_ATTRIBUTE_PURE
+# if defined __GNUC__ && 2 < __GNUC__ + (96 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_PURE __attribute__ ((__pure__))
+# else
+#  define YY_ATTRIBUTE_PURE
+# endif
+#endif
+
+#ifndef YY_ATTRIBUTE_UNUSED
+# if defined __GNUC__ && 2 < __GNUC__ + (7 <= __GNUC_MINOR__)
+#  define YY_ATTRIBUTE_UNUSED __attribute__ ((__unused__))
+# else
+#  define YY_ATTRIBUTE_UNUSED
+# endif
+#endif
+
+/* Suppress unused-variable warnings by "using" E.  */
+#if ! defined lint || defined __GNUC__
+# define YY_USE(E) ((void) (E))
+#else
+# define YY_USE(E) /* empty */
+#endif
+
+/* Suppress an incorrect diagnostic about yylval being uninitialized.  */
+#if defined __GNUC__ && ! defined __ICC && 406 <= __GNUC__ * 100 + __GNUC_MINOR__
+# if __GNUC__ * 100 + __GNUC_MINOR__ < 407
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")
+# else
+#  define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN                           \
+    _Pragma ("GCC diagnostic push")                                     \
+    _Pragma ("GCC diagnostic ignored \"-Wuninitialized\"")              \
+    _Pragma ("GCC diagnostic ignored \"-Wmaybe-uninitialized\"")
+# endif
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END      \
+    _Pragma ("GCC diagnostic pop")
+#else
+# define YY_INITIAL_VALUE(Value) Value
+#endif
+#ifndef YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+# define YY_IGNORE_MAYBE_UNINITIALIZED_END
+#endif
+#ifndef YY_INITIAL_VALUE
+# define YY_INITIAL_VALUE(Value) /* Nothing. */
+#endif
+
+#if defined __cplusplus && defined __GNUC__ && ! defined __ICC && 6 <= __GNUC__
+# define YY_IGNORE_USELESS_CAST_BEGIN                          \
+    _Pragma ("GCC diagnostic push")                            \
+    _Pragma ("GCC diagnostic ignored \"-Wuseless-cast\"")
+# define YY_IGNORE_USELESS_CAST_END            \
+    _Pragma ("GCC diagnostic pop")
+#endif
+#ifndef YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_BEGIN
+# define YY_IGNORE_USELESS_CAST_END
+#endif
+
+
+#define YY_ASSERT(E) ((void) (0 && (E)))
+
+#if !defined yyoverflow
+
+/* The parser invokes alloca or malloc; define the necessary symbols.  */
+
+# ifdef YYSTACK_USE_ALLOCA
+#  if YYSTACK_USE_ALLOCA
+#   ifdef __GNUC__
+#    define YYSTACK_ALLOC __builtin_alloca
+#   elif defined __BUILTIN_VA_ARG_INCR
+#    include <alloca.h> /* INFRINGES ON USER NAME SPACE */
+#   elif defined _AIX
+#    define YYSTACK_ALLOC __alloca
+#   elif defined _MSC_VER
+#    include <malloc.h> /* INFRINGES ON USER NAME SPACE */
+#    define alloca _alloca
+#   else
+#    define YYSTACK_ALLOC alloca
+#    if ! defined _ALLOCA_H && ! defined EXIT_SUCCESS
+#     include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+      /* Use EXIT_SUCCESS as a witness for stdlib.h.  */
+#     ifndef EXIT_SUCCESS
+#      define EXIT_SUCCESS 0
+#     endif
+#    endif
+#   endif
+#  endif
+# endif
+
+# ifdef YYSTACK_ALLOC
+   /* Pacify GCC's 'empty if-body' warning.  */
+#  define YYSTACK_FREE(Ptr) do { /* empty */; } while (0)
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+    /* The OS might guarantee only one guard page at the bottom of the stack,
+       and a page size can be as small as 4096 bytes.  So we cannot safely
+       invoke alloca (N) if N exceeds 4096.  Use a slightly smaller number
+       to allow for a few compiler-allocated temporary stack slots.  */
+#   define YYSTACK_ALLOC_MAXIMUM 4032 /* reasonable circa 2006 */
+#  endif
+# else
+#  define YYSTACK_ALLOC YYMALLOC
+#  define YYSTACK_FREE YYFREE
+#  ifndef YYSTACK_ALLOC_MAXIMUM
+#   define YYSTACK_ALLOC_MAXIMUM YYSIZE_MAXIMUM
+#  endif
+#  if (defined __cplusplus && ! defined EXIT_SUCCESS \
+       && ! ((defined YYMALLOC || defined malloc) \
+             && (defined YYFREE || defined free)))
+#   include <stdlib.h> /* INFRINGES ON USER NAME SPACE */
+#   ifndef EXIT_SUCCESS
+#    define EXIT_SUCCESS 0
+#   endif
+#  endif
+#  ifndef YYMALLOC
+#   define YYMALLOC malloc
+#   if ! defined malloc && ! defined EXIT_SUCCESS
+void *malloc (YYSIZE_T); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+#  ifndef YYFREE
+#   define YYFREE free
+#   if ! defined free && ! defined EXIT_SUCCESS
+void free (void *); /* INFRINGES ON USER NAME SPACE */
+#   endif
+#  endif
+# endif
+#endif /* !defined yyoverflow */
+
+#if (! defined yyoverflow \
+     && (! defined __cplusplus \
+         || (defined YYSTYPE_IS_TRIVIAL && YYSTYPE_IS_TRIVIAL)))
+
+/* A type that is properly aligned for any stack member.  */
+union yyalloc
+{
+  yy_state_t yyss_alloc;
+  YYSTYPE yyvs_alloc;
+};
+
+/* The size of the maximum gap between one aligned stack and the next.  */
+# define YYSTACK_GAP_MAXIMUM (YYSIZEOF (union yyalloc) - 1)
+
+/* The size of an array large to enough to hold all stacks, each with
+   N elements.  */
+# define YYSTACK_BYTES(N) \
+     ((N) * (YYSIZEOF (yy_state_t) + YYSIZEOF (YYSTYPE)) \
+      + YYSTACK_GAP_MAXIMUM)
+
+# define YYCOPY_NEEDED 1
+
+/* Relocate STACK from its old location to the new one.  The
+   local variables YYSIZE and YYSTACKSIZE give the old and new number of
+   elements in the stack, and YYPTR gives the new location of the
+   stack.  Advance YYPTR to a properly aligned location for the next
+   stack.  */
+# define YYSTACK_RELOCATE(Stack_alloc, Stack)                           \
+    do                                                                  \
+      {                                                                 \
+        YYPTRDIFF_T yynewbytes;                                         \
+        YYCOPY (&yyptr->Stack_alloc, Stack, yysize);                    \
+        Stack = &yyptr->Stack_alloc;                                    \
+        yynewbytes = yystacksize * YYSIZEOF (*Stack) + YYSTACK_GAP_MAXIMUM; \
+        yyptr += yynewbytes / YYSIZEOF (*yyptr);                        \
+      }                                                                 \
+    while (0)
+
+#endif
+
+#if defined YYCOPY_NEEDED && YYCOPY_NEEDED
+/* Copy COUNT objects from SRC to DST.  The source and destination do
+   not overlap.  */
+# ifndef YYCOPY
+#  if defined __GNUC__ && 1 < __GNUC__
+#   define YYCOPY(Dst, Src, Count) \
+      __builtin_memcpy (Dst, Src, YY_CAST (YYSIZE_T, (Count)) * sizeof (*(Src)))
+#  else
+#   define YYCOPY(Dst, Src, Count)              \
+      do                                        \
+        {                                       \
+          YYPTRDIFF_T yyi;                      \
+          for (yyi = 0; yyi < (Count); yyi++)   \
+            (Dst)[yyi] = (Src)[yyi];            \
+        }                                       \
+      while (0)
+#  endif
+# endif
+#endif /* !YYCOPY_NEEDED */
+
+/* YYFINAL -- State number of the termination state.  */
+#define YYFINAL  3
+/* YYLAST -- Last index in YYTABLE.  */
+#define YYLAST   533
+
+/* YYNTOKENS -- Number of terminals.  */
+#define YYNTOKENS  89
+/* YYNNTS -- Number of nonterminals.  */
+#define YYNNTS  79
+/* YYNRULES -- Number of rules.  */
+#define YYNRULES  199
+/* YYNSTATES -- Number of states.  */
+#define YYNSTATES  358
+
+/* YYMAXUTOK -- Last valid token kind.  */
+#define YYMAXUTOK   320
+
+
+/* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex, with out-of-bounds checking.  */
+#define YYTRANSLATE(YYX)                                \
+  (0 <= (YYX) && (YYX) <= YYMAXUTOK                     \
+   ? YY_CAST (yysymbol_kind_t, yytranslate[YYX])        \
+   : YYSYMBOL_YYUNDEF)
+
+/* YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to TOKEN-NUM
+   as returned by yylex.  */
+static const yytype_int8 yytranslate[] =
+{
+       0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,    79,     2,     2,     2,    82,    77,     2,
+      68,    69,    71,    67,    70,    78,     2,    81,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,    72,    66,
+      83,    88,    84,    87,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,    75,     2,    76,    85,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,    73,    86,    74,    80,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+       5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
+      35,    36,    37,    38,    39,    40,    41,    42,    43,    44,
+      45,    46,    47,    48,    49,    50,    51,    52,    53,    54,
+      55,    56,    57,    58,    59,    60,    61,    62,    63,    64,
+      65
+};
+
+#if YYDEBUG
+/* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
+static const yytype_int16 yyrline[] =
+{
+       0,   131,   131,   131,   144,   145,   154,   167,   169,   175,
+     176,   180,   185,   186,   188,   193,   198,   204,   203,   215,
+     214,   230,   236,   237,   238,   239,   247,   248,   253,   258,
+     262,   268,   275,   276,   277,   282,   283,   288,   290,   295,
+     296,   301,   303,   305,   307,   312,   313,   314,   316,   318,
+     320,   322,   328,   329,   334,   335,   345,   353,   358,   359,
+     363,   364,   370,   371,   376,   383,   387,   398,   397,   403,
+     405,   406,   413,   412,   419,   419,   423,   422,   432,   431,
+     441,   440,   458,   463,   458,   474,   473,   484,   483,   494,
+     493,   504,   503,   513,   517,   521,   523,   527,   527,   540,
+     541,   546,   547,   549,   554,   556,   558,   559,   560,   562,
+     564,   581,   583,   585,   587,   589,   592,   591,   598,   603,
+     605,   610,   611,   613,   618,   619,   621,   626,   627,   629,
+     631,   633,   635,   640,   657,   658,   666,   667,   669,   671,
+     676,   677,   679,   684,   685,   687,   692,   693,   695,   697,
+     699,   704,   705,   707,   712,   713,   718,   719,   724,   725,
+     730,   731,   736,   737,   742,   744,   746,   743,   755,   756,
+     758,   760,   762,   764,   766,   768,   770,   772,   774,   776,
+     781,   782,   788,   789,   793,   798,   803,   804,   813,   814,
+     815,   828,   829,   830,   835,   844,   845,   851,   852,   853
+};
+#endif
+
+/** Accessing symbol of state STATE.  */
+#define YY_ACCESSING_SYMBOL(State) YY_CAST (yysymbol_kind_t, yystos[State])
+
+#if YYDEBUG || 0
+/* The user-facing name of the symbol whose (internal) number is
+   YYSYMBOL.  No bounds checking.  */
+static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
+
+/* YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+   First, the terminals, then, starting at YYNTOKENS, nonterminals.  */
+static const char *const yytname[] =
+{
+  "\"end of file\"", "error", "\"invalid token\"", "NIL", "BREAK", "DO",
+  "MAPPING", "ELSE", "CASE", "OBJECT", "DEFAULT", "STATIC", "CONTINUE",
+  "INT", "FLOAT", "RLIMITS", "FOR", "INHERIT", "IF", "GOTO", "RETURN",
+  "MIXED", "STRING", "WHILE", "FUNCTION", "CATCH", "SWITCH", "VOID",
+  "PRIVATE", "ATOMIC", "NOMASK", "VARARGS", "LARROW", "RARROW",
+  "PLUS_PLUS", "MIN_MIN", "LSHIFT", "RSHIFT", "LE", "GE", "EQ", "NE",
+  "LAND", "LOR", "PLUS_EQ", "MIN_EQ", "MULT_EQ", "DIV_EQ", "MOD_EQ",
+  "LSHIFT_EQ", "RSHIFT_EQ", "AND_EQ", "XOR_EQ", "OR_EQ", "COLON_COLON",
+  "DOT_DOT", "ELLIPSIS", "STRING_CONST", "IDENTIFIER", "INT_CONST",
+  "FLOAT_CONST", "MARK", "HASH", "HASH_HASH", "INCL_CONST", "NR_TOKENS",
+  "';'", "'+'", "'('", "')'", "','", "'*'", "':'", "'{'", "'}'", "'['",
+  "']'", "'&'", "'-'", "'!'", "'~'", "'/'", "'%'", "'<'", "'>'", "'^'",
+  "'|'", "'?'", "'='", "$accept", "program", "$@1",
+  "top_level_declarations", "top_level_declaration", "opt_inherit_label",
+  "ident", "composite_string", "string", "data_declaration",
+  "function_declaration", "$@2", "$@3", "local_data_declaration",
+  "formals_declaration", "formal_declaration_list",
+  "varargs_formal_declaration", "formal_declaration",
+  "class_specifier_list", "class_specifier_list2", "class_specifier",
+  "opt_private", "non_private", "type_specifier", "star_list",
+  "data_dcltr", "function_dcltr", "dcltr", "list_dcltr",
+  "dcltr_or_stmt_list", "dcltr_or_stmt", "if_stmt", "$@4", "stmt", "$@5",
+  "$@6", "$@7", "$@8", "$@9", "$@10", "$@11", "$@12", "$@13", "$@14",
+  "$@15", "compound_stmt", "$@16", "opt_caught_stmt", "function_name",
+  "primary_p1_exp", "$@17", "primary_p2_exp", "postfix_exp", "prefix_exp",
+  "cast_exp", "mult_oper_exp", "add_oper_exp", "shift_oper_exp",
+  "rel_oper_exp", "equ_oper_exp", "bitand_oper_exp", "bitxor_oper_exp",
+  "bitor_oper_exp", "and_oper_exp", "or_oper_exp", "cond_exp", "$@18",
+  "$@19", "exp", "list_exp", "opt_list_exp", "f_list_exp",
+  "f_opt_list_exp", "arg_list", "opt_arg_list", "opt_arg_list_comma",
+  "assoc_exp", "assoc_arg_list", "opt_assoc_arg_list_comma", YY_NULLPTR
+};
+
+static const char *
+yysymbol_name (yysymbol_kind_t yysymbol)
+{
+  return yytname[yysymbol];
+}
+#endif
+
+#define YYPACT_NINF (-214)
+
+#define yypact_value_is_default(Yyn) \
+  ((Yyn) == YYPACT_NINF)
+
+#define YYTABLE_NINF (-185)
+
+#define yytable_value_is_error(Yyn) \
+  0
+
+/* YYPACT[STATE-NUM] -- Index in YYTABLE of the portion describing
+   STATE-NUM.  */
+static const yytype_int16 yypact[] =
+{
+    -214,    24,  -214,  -214,    41,  -214,    71,  -214,  -214,  -214,
+    -214,  -214,  -214,   229,   136,    28,   182,  -214,    16,  -214,
+    -214,  -214,  -214,  -214,  -214,  -214,    19,  -214,  -214,   136,
+    -214,  -214,    35,  -214,    16,    30,  -214,   130,   -16,  -214,
+      64,  -214,    -9,  -214,    16,  -214,    65,    92,    87,   229,
+    -214,    93,    -8,  -214,  -214,  -214,  -214,   110,   108,  -214,
+    -214,    12,  -214,  -214,  -214,  -214,  -214,   366,   -16,  -214,
+     130,  -214,  -214,  -214,  -214,  -214,   108,  -214,  -214,   118,
+    -214,  -214,  -214,   270,   125,  -214,   149,  -214,   453,   124,
+     150,   134,   151,   153,   453,   155,   157,   159,   453,   453,
+      35,  -214,  -214,  -214,   453,   426,  -214,    27,   453,   453,
+     453,     9,  -214,  -214,   449,  -214,  -214,   197,  -214,  -214,
+     160,  -214,   -19,   107,  -214,  -214,   -31,    14,   138,   -30,
+     143,   152,   145,   147,   189,   -38,   266,  -214,    37,  -214,
+    -214,   348,   157,   -29,  -214,  -214,   453,   453,   453,   164,
+    -214,   170,   453,  -214,   108,   453,  -214,  -214,  -214,  -214,
+     453,   453,   453,  -214,   116,   166,   171,  -214,  -214,  -214,
+      35,  -214,  -214,   453,    26,    35,   453,  -214,  -214,   453,
+     453,   453,   453,   453,   453,   453,   453,   453,   453,   453,
+     453,   453,   453,   453,   453,   453,   453,  -214,   453,   453,
+     453,   453,   453,   453,   453,   453,   453,   453,   453,  -214,
+     453,   217,   453,  -214,   348,   164,   175,   178,   176,  -214,
+     177,   453,  -214,   179,   180,  -214,   185,   183,   186,  -214,
+     191,   187,    69,  -214,   453,   453,  -214,    61,   348,    20,
+     190,    16,  -214,   184,    54,   188,   207,  -214,  -214,  -214,
+     -31,   -31,    14,    14,   138,   138,   138,   138,   -30,   -30,
+     143,   152,   145,   147,   189,   453,  -214,  -214,  -214,  -214,
+    -214,  -214,  -214,  -214,  -214,  -214,  -214,  -214,   198,   193,
+     348,  -214,   453,   453,  -214,  -214,   120,   195,  -214,   200,
+     453,   201,   453,   453,   203,   453,   208,   233,  -214,  -214,
+    -214,   453,  -214,    86,   453,  -214,   453,    88,   453,  -214,
+    -214,   234,   240,   348,   348,  -214,   348,  -214,   108,   453,
+    -214,  -214,  -214,  -214,  -214,  -214,   239,  -214,  -214,   251,
+     232,  -214,   252,   348,  -214,   453,  -214,  -214,  -214,  -214,
+     253,   453,  -214,  -214,   453,   243,  -214,   108,   254,  -214,
+     256,  -214,  -214,  -214,  -214,  -214,   348,  -214
+};
+
+/* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
+   Performed when YYTABLE does not specify something else to do.  Zero
+   means the default is an error.  */
+static const yytype_uint8 yydefact[] =
+{
+       2,     0,     4,     1,    39,    41,    40,    42,    43,    44,
+       5,     7,     8,     0,     0,    32,    33,    50,    48,    45,
+      46,    52,    47,    51,    53,    11,     0,    54,    37,    34,
+      35,    38,     9,    15,     0,    49,    12,    22,     0,    58,
+      59,    60,     0,    36,     0,    10,     0,     0,    53,     0,
+      31,     0,    24,    26,    29,    54,    55,    56,     0,    16,
+      54,     0,    14,    13,    28,    19,    25,     0,     0,    30,
+      22,    97,    18,    59,    61,     6,     0,    27,    56,     0,
+      62,    20,    57,     0,     0,   106,     0,    74,     0,     0,
+       0,     0,     0,     0,   182,     0,    82,     0,     0,     0,
+       0,   104,   105,    96,     0,     0,    98,     0,     0,     0,
+       0,   110,   107,    64,     0,    32,    63,    71,    65,    70,
+       0,   121,   124,   127,   134,   136,   140,   143,   146,   151,
+     154,   156,   158,   160,   162,   164,   168,   180,     0,    66,
+      93,     0,     0,     0,    91,    94,     0,   182,     0,   183,
+     185,     0,     0,   116,     0,     0,   128,   129,   102,   131,
+       0,   191,   197,    54,     0,     0,     0,   130,   132,   133,
+       0,    54,    72,   188,     0,     0,   182,   125,   126,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,   165,     0,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,    69,
+       0,     0,     0,    87,     0,   184,     0,     0,     0,    95,
+       0,     0,    83,     0,     0,   186,   192,     0,     0,   195,
+     198,     0,     0,   111,     0,   188,   103,     0,     0,   189,
+       0,     0,   119,     0,   183,     0,     0,   137,   138,   139,
+     141,   142,   144,   145,   149,   150,   147,   148,   152,   153,
+     155,   157,   159,   161,   163,     0,   170,   171,   172,   173,
+     174,   175,   176,   177,   178,   179,   169,   181,     0,     0,
+       0,    92,     0,   182,    67,    76,     0,    99,    85,     0,
+     193,     0,     0,   199,     0,     0,     0,     0,    21,    73,
+     190,     0,   112,     0,   188,   122,   182,     0,     0,    89,
+      88,     0,     0,     0,     0,   117,     0,    84,     0,   188,
+     187,   108,   194,   196,   109,   135,     0,   113,   120,     0,
+       0,   166,     0,     0,    80,   182,    68,    77,   100,    86,
+       0,   188,   118,   123,     0,     0,    90,     0,     0,   115,
+       0,   167,    75,    81,    78,   114,     0,    79
+};
+
+/* YYPGOTO[NTERM-NUM].  */
+static const yytype_int16 yypgoto[] =
+{
+    -214,  -214,  -214,  -214,  -214,  -214,    -2,   -32,   -15,  -214,
+    -214,  -214,  -214,  -214,   199,  -214,   259,   282,   249,  -214,
+      -4,   250,    17,    21,   -34,   279,   308,   280,   168,  -214,
+    -214,  -214,  -214,  -134,  -214,  -214,  -214,  -214,  -214,  -214,
+    -214,  -214,  -214,  -214,  -214,   -58,  -214,  -214,  -214,  -214,
+    -214,  -214,  -214,  -214,   -71,    15,    23,   -17,    10,   154,
+     148,   161,   162,   146,  -214,     1,  -214,  -214,   -87,   -88,
+    -143,  -132,  -161,   204,  -213,  -214,    66,  -214,  -214
+};
+
+/* YYDEFGOTO[NTERM-NUM].  */
+static const yytype_int16 yydefgoto[] =
+{
+       0,     1,     2,     4,    10,    44,   111,    35,   112,    11,
+      12,    58,    76,   113,    51,    52,    53,    54,    13,    29,
+      14,    15,    16,    55,    38,    39,    73,    41,    42,    83,
+     116,   117,   313,   118,   238,   141,   314,   356,   347,   154,
+     287,   318,   280,   333,   214,   119,    80,   317,   120,   121,
+     221,   122,   123,   124,   125,   126,   127,   128,   129,   130,
+     131,   132,   133,   134,   135,   136,   265,   344,   137,   138,
+     150,   216,   151,   239,   240,   227,   229,   230,   231
+};
+
+/* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
+   positive, shift that token.  If negative, reduce the rule whose
+   number is the opposite.  If YYTABLE_NINF, syntax error.  */
+static const yytype_int16 yytable[] =
+{
+      72,   143,    46,    36,   217,   196,   149,   211,   186,   187,
+      30,    26,    61,   174,   175,   246,   218,   164,    81,    36,
+     220,    68,   297,   223,     3,    43,   212,   156,   157,    36,
+      45,    31,    63,   159,    27,    50,    57,   167,   168,   169,
+     179,    -3,    25,   213,   245,    32,    31,    50,    66,   197,
+     180,   181,     5,   188,   189,    56,   176,    59,   215,   149,
+     215,    60,    67,   170,   215,    50,    78,   215,    50,     6,
+       7,     8,     9,    33,   225,   228,   300,  -101,    75,    47,
+     281,   182,   -37,    33,    34,    25,   225,    37,   244,   224,
+     301,   329,   183,    25,   241,   165,   222,    47,   158,   -37,
+     -37,   -37,   -37,   209,   299,   166,   340,   210,   247,   248,
+     249,   266,   267,   268,   269,   270,   271,   272,   273,   274,
+     275,   276,   312,   277,   210,   279,   163,   298,   350,   232,
+    -184,    60,    47,   286,    62,   171,    17,   -17,   295,    18,
+      56,   177,   178,    19,    20,   330,   310,     5,   225,    33,
+     311,    21,    22,    47,    23,   328,   -23,    48,   210,   242,
+     331,    49,    65,   296,    28,     7,     8,     9,   236,   254,
+     255,   256,   257,   243,   184,   185,   332,   307,    70,   336,
+     337,    71,   338,   190,   191,   233,   210,    82,    25,   315,
+     210,   139,   348,   -38,   215,   149,   144,   250,   251,   346,
+     258,   259,   146,   320,   172,   322,   228,   252,   253,   303,
+     -38,   -38,   -38,   -38,   320,   140,   145,   225,   149,   147,
+     215,   148,   357,   152,   325,   153,    36,   155,   173,   192,
+     193,   195,   225,   194,   210,    17,   219,   234,    18,   235,
+     278,   282,    19,    20,   283,   284,   285,   149,   288,   289,
+      21,    22,   304,    23,   225,   290,    24,   291,   292,   302,
+     339,   293,   306,   294,   305,   309,   308,   316,   319,    79,
+     321,    84,   324,    85,    86,    87,   -39,   326,    88,   -39,
+      89,     5,    90,   -39,   -39,    91,    92,    25,    93,   353,
+      94,   -39,   -39,    95,   -39,    96,    97,   -39,     6,     7,
+       8,     9,   327,   334,    98,    99,   335,   341,   343,   352,
+     198,   199,   200,   201,   202,   203,   204,   205,   206,   207,
+     342,   345,   349,   354,   100,   355,    77,    33,    25,   101,
+     102,    64,   114,   115,    69,    40,   103,   104,   105,   237,
+      74,   261,   264,    71,   106,   351,   260,   107,   108,   109,
+     110,    85,    86,    87,   208,   262,    88,   263,    89,   323,
+      90,     0,     0,    91,    92,   226,    93,     0,    94,     0,
+       0,    95,    17,    96,    97,    18,     0,     0,     0,    19,
+      20,     0,    98,    99,     0,     0,     0,    21,    22,     0,
+      23,     0,     0,    24,     0,     0,     0,    49,     0,     0,
+       0,     0,   100,     0,     0,    33,    25,   101,   102,     0,
+       0,     0,     0,     0,   103,   104,   105,     0,     0,     0,
+       0,    71,     0,     0,    25,   107,   108,   109,   110,    85,
+       0,     0,    17,     0,     0,    18,     0,     0,     0,    19,
+      20,     0,     0,     0,     0,     0,     0,    21,    22,     0,
+      23,   142,     0,    24,     0,    17,    85,     0,    18,     0,
+      98,    99,    19,    20,     0,     0,     0,     0,     0,     0,
+      21,    22,     0,    23,     0,     0,    24,     0,   142,     0,
+     100,     0,     0,    33,    25,   101,   102,    98,    99,     0,
+       0,     0,     0,   104,   105,     0,     0,   160,     0,   161,
+       0,   162,     0,   107,   108,   109,   110,   100,     0,     0,
+      33,    25,   101,   102,     0,     0,     0,     0,     0,     0,
+     104,   105,     0,     0,     0,     0,     0,     0,     0,     0,
+     107,   108,   109,   110
+};
+
+static const yytype_int16 yycheck[] =
+{
+      58,    88,    34,    18,   147,    43,    94,   141,    38,    39,
+      14,    13,    44,    32,    33,   176,   148,   105,    76,    34,
+     152,    55,   235,   155,     0,    29,    55,    98,    99,    44,
+      32,    14,    47,   104,    13,    37,    38,   108,   109,   110,
+      71,     0,    58,    72,   176,    17,    29,    49,    56,    87,
+      81,    82,    11,    83,    84,    71,    75,    66,   146,   147,
+     148,    70,    70,    54,   152,    67,    68,   155,    70,    28,
+      29,    30,    31,    57,   161,   162,    56,    68,    66,    67,
+     214,    67,    11,    57,    68,    58,   173,    68,   176,   160,
+      70,   304,    78,    58,    68,    68,   154,    67,   100,    28,
+      29,    30,    31,    66,   238,   107,   319,    70,   179,   180,
+     181,   198,   199,   200,   201,   202,   203,   204,   205,   206,
+     207,   208,   283,   210,    70,   212,   105,    66,   341,   163,
+      76,    70,    67,   221,    69,   114,     6,    73,    69,     9,
+      71,    34,    35,    13,    14,   306,   280,    11,   235,    57,
+     282,    21,    22,    67,    24,    69,    69,    27,    70,   174,
+      72,    31,    69,   234,    28,    29,    30,    31,   170,   186,
+     187,   188,   189,   175,    36,    37,   308,   265,    68,   313,
+     314,    73,   316,    40,    41,    69,    70,    69,    58,    69,
+      70,    66,   335,    11,   282,   283,    72,   182,   183,   333,
+     190,   191,    68,   290,     7,   292,   293,   184,   185,   241,
+      28,    29,    30,    31,   301,    66,    66,   304,   306,    68,
+     308,    68,   356,    68,   295,    68,   241,    68,    68,    77,
+      85,    42,   319,    86,    70,     6,    66,    71,     9,    68,
+      23,    66,    13,    14,    66,    69,    69,   335,    69,    69,
+      21,    22,    68,    24,   341,    70,    27,    74,    72,    69,
+     318,    70,    55,    76,    76,    72,    68,    72,    68,    70,
+      69,     1,    69,     3,     4,     5,     6,    69,     8,     9,
+      10,    11,    12,    13,    14,    15,    16,    58,    18,   347,
+      20,    21,    22,    23,    24,    25,    26,    27,    28,    29,
+      30,    31,    69,    69,    34,    35,    66,    68,    76,    66,
+      44,    45,    46,    47,    48,    49,    50,    51,    52,    53,
+      69,    69,    69,    69,    54,    69,    67,    57,    58,    59,
+      60,    49,    83,    83,    55,    27,    66,    67,    68,   171,
+      60,   193,   196,    73,    74,   344,   192,    77,    78,    79,
+      80,     3,     4,     5,    88,   194,     8,   195,    10,   293,
+      12,    -1,    -1,    15,    16,   161,    18,    -1,    20,    -1,
+      -1,    23,     6,    25,    26,     9,    -1,    -1,    -1,    13,
+      14,    -1,    34,    35,    -1,    -1,    -1,    21,    22,    -1,
+      24,    -1,    -1,    27,    -1,    -1,    -1,    31,    -1,    -1,
+      -1,    -1,    54,    -1,    -1,    57,    58,    59,    60,    -1,
+      -1,    -1,    -1,    -1,    66,    67,    68,    -1,    -1,    -1,
+      -1,    73,    -1,    -1,    58,    77,    78,    79,    80,     3,
+      -1,    -1,     6,    -1,    -1,     9,    -1,    -1,    -1,    13,
+      14,    -1,    -1,    -1,    -1,    -1,    -1,    21,    22,    -1,
+      24,    25,    -1,    27,    -1,     6,     3,    -1,     9,    -1,
+      34,    35,    13,    14,    -1,    -1,    -1,    -1,    -1,    -1,
+      21,    22,    -1,    24,    -1,    -1,    27,    -1,    25,    -1,
+      54,    -1,    -1,    57,    58,    59,    60,    34,    35,    -1,
+      -1,    -1,    -1,    67,    68,    -1,    -1,    71,    -1,    73,
+      -1,    75,    -1,    77,    78,    79,    80,    54,    -1,    -1,
+      57,    58,    59,    60,    -1,    -1,    -1,    -1,    -1,    -1,
+      67,    68,    -1,    -1,    -1,    -1,    -1,    -1,    -1,    -1,
+      77,    78,    79,    80
+};
+
+/* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
+   state STATE-NUM.  */
+static const yytype_uint8 yystos[] =
+{
+       0,    90,    91,     0,    92,    11,    28,    29,    30,    31,
+      93,    98,    99,   107,   109,   110,   111,     6,     9,    13,
+      14,    21,    22,    24,    27,    58,    95,   112,    28,   108,
+     109,   111,    17,    57,    68,    96,    97,    68,   113,   114,
+     115,   116,   117,   109,    94,    95,    96,    67,    27,    31,
+      95,   103,   104,   105,   106,   112,    71,    95,   100,    66,
+      70,    96,    69,    97,   106,    69,    56,    70,   113,   114,
+      68,    73,   134,   115,   116,    66,   101,   105,    95,   103,
+     135,   134,    69,   118,     1,     3,     4,     5,     8,    10,
+      12,    15,    16,    18,    20,    23,    25,    26,    34,    35,
+      54,    59,    60,    66,    67,    68,    74,    77,    78,    79,
+      80,    95,    97,   102,   107,   110,   119,   120,   122,   134,
+     137,   138,   140,   141,   142,   143,   144,   145,   146,   147,
+     148,   149,   150,   151,   152,   153,   154,   157,   158,    66,
+      66,   124,    25,   157,    72,    66,    68,    68,    68,   158,
+     159,   161,    68,    68,   128,    68,   143,   143,    95,   143,
+      71,    73,    75,   112,   158,    68,    95,   143,   143,   143,
+      54,   112,     7,    68,    32,    33,    75,    34,    35,    71,
+      81,    82,    67,    78,    36,    37,    38,    39,    83,    84,
+      40,    41,    77,    85,    86,    42,    43,    87,    44,    45,
+      46,    47,    48,    49,    50,    51,    52,    53,    88,    66,
+      70,   122,    55,    72,   133,   158,   160,   159,   160,    66,
+     160,   139,   134,   160,   143,   157,   162,   164,   157,   165,
+     166,   167,   113,    69,    71,    68,    95,   117,   123,   162,
+     163,    68,    97,    95,   158,   160,   161,   143,   143,   143,
+     144,   144,   145,   145,   146,   146,   146,   146,   147,   147,
+     148,   149,   150,   151,   152,   155,   157,   157,   157,   157,
+     157,   157,   157,   157,   157,   157,   157,   157,    23,   157,
+     131,   122,    66,    66,    69,    69,   158,   129,    69,    69,
+      70,    74,    72,    70,    76,    69,   143,   163,    66,   122,
+      56,    70,    69,    96,    68,    76,    55,   158,    68,    72,
+     122,   160,   161,   121,   125,    69,    72,   136,   130,    68,
+     157,    69,   157,   165,    69,   143,    69,    69,    69,   163,
+     161,    72,   160,   132,    69,    66,   122,   122,   122,   134,
+     163,    68,    69,    76,   156,    69,   122,   127,   159,    69,
+     163,   154,    66,   134,    69,    69,   126,   122
+};
+
+/* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
+static const yytype_uint8 yyr1[] =
+{
+       0,    89,    91,    90,    92,    92,    93,    93,    93,    94,
+      94,    95,    96,    96,    96,    97,    98,   100,    99,   101,
+      99,   102,   103,   103,   103,   103,   104,   104,   105,   105,
+     106,   106,   107,   107,   107,   108,   108,   109,   109,   110,
+     110,   111,   111,   111,   111,   112,   112,   112,   112,   112,
+     112,   112,   112,   112,   113,   113,   114,   115,   116,   116,
+     117,   117,   118,   118,   119,   119,   119,   121,   120,   122,
+     122,   122,   123,   122,   124,   122,   125,   122,   126,   122,
+     127,   122,   128,   129,   122,   130,   122,   131,   122,   132,
+     122,   133,   122,   122,   122,   122,   122,   135,   134,   136,
+     136,   137,   137,   137,   138,   138,   138,   138,   138,   138,
+     138,   138,   138,   138,   138,   138,   139,   138,   138,   138,
+     138,   140,   140,   140,   141,   141,   141,   142,   142,   142,
+     142,   142,   142,   142,   143,   143,   144,   144,   144,   144,
+     145,   145,   145,   146,   146,   146,   147,   147,   147,   147,
+     147,   148,   148,   148,   149,   149,   150,   150,   151,   151,
+     152,   152,   153,   153,   154,   155,   156,   154,   157,   157,
+     157,   157,   157,   157,   157,   157,   157,   157,   157,   157,
+     158,   158,   159,   159,   160,   161,   162,   162,   163,   163,
+     163,   164,   164,   164,   165,   166,   166,   167,   167,   167
+};
+
+/* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
+static const yytype_int8 yyr2[] =
+{
+       0,     2,     0,     2,     0,     2,     5,     1,     1,     0,
+       1,     1,     1,     3,     3,     1,     4,     0,     5,     0,
+       7,     4,     0,     1,     1,     2,     1,     3,     2,     1,
+       2,     1,     1,     1,     2,     1,     2,     1,     1,     0,
+       1,     1,     1,     1,     1,     1,     1,     1,     1,     2,
+       1,     1,     1,     1,     0,     2,     2,     5,     1,     1,
+       1,     3,     0,     2,     1,     1,     2,     0,     6,     2,
+       1,     1,     0,     4,     0,     8,     0,     6,     0,    10,
+       0,     8,     0,     0,     5,     0,     6,     0,     5,     0,
+       7,     0,     4,     2,     2,     3,     1,     0,     4,     0,
+       2,     1,     2,     3,     1,     1,     1,     1,     5,     5,
+       1,     3,     4,     5,     8,     7,     0,     5,     6,     3,
+       5,     1,     4,     6,     1,     2,     2,     1,     2,     2,
+       2,     2,     2,     2,     1,     5,     1,     3,     3,     3,
+       1,     3,     3,     1,     3,     3,     1,     3,     3,     3,
+       3,     1,     3,     3,     1,     3,     1,     3,     1,     3,
+       1,     3,     1,     3,     1,     0,     0,     7,     1,     3,
+       3,     3,     3,     3,     3,     3,     3,     3,     3,     3,
+       1,     3,     0,     1,     1,     1,     1,     3,     0,     1,
+       2,     0,     1,     2,     3,     1,     3,     0,     1,     2
+};
+
+
+enum { YYENOMEM = -2 };
+
+#define yyerrok         (yyerrstatus = 0)
+#define yyclearin       (yychar = YYEMPTY)
+
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYNOMEM         goto yyexhaustedlab
+
+
+#define YYRECOVERING()  (!!yyerrstatus)
+
+#define YYBACKUP(Token, Value)                                    \
+  do                                                              \
+    if (yychar == YYEMPTY)                                        \
+      {                                                           \
+        yychar = (Token);                                         \
+        yylval = (Value);                                         \
+        YYPOPSTACK (yylen);                                       \
+        yystate = *yyssp;                                         \
+        goto yybackup;                                            \
+      }                                                           \
+    else                                                          \
+      {                                                           \
+        yyerror (YY_("syntax error: cannot back up")); \
+        YYERROR;                                                  \
+      }                                                           \
+  while (0)
+
+/* Backward compatibility with an undocumented macro.
+   Use YYerror or YYUNDEF. */
+#define YYERRCODE YYUNDEF
+
+
+/* Enable debugging if requested.  */
+#if YYDEBUG
+
+# ifndef YYFPRINTF
+#  include <stdio.h> /* INFRINGES ON USER NAME SPACE */
+#  define YYFPRINTF fprintf
+# endif
+
+# define YYDPRINTF(Args)                        \
+do {                                            \
+  if (yydebug)                                  \
+    YYFPRINTF Args;                             \
+} while (0)
+
+
+
+
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)                    \
+do {                                                                      \
+  if (yydebug)                                                            \
+    {                                                                     \
+      YYFPRINTF (stderr, "%s ", Title);                                   \
+      yy_symbol_print (stderr,                                            \
+                  Kind, Value); \
+      YYFPRINTF (stderr, "\n");                                           \
+    }                                                                     \
+} while (0)
+
+
+/*-----------------------------------.
+| Print this symbol's value on YYO.  |
+`-----------------------------------*/
+
+static void
+yy_symbol_value_print (FILE *yyo,
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+{
+  FILE *yyoutput = yyo;
+  YY_USE (yyoutput);
+  if (!yyvaluep)
+    return;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/*---------------------------.
+| Print this symbol on YYO.  |
+`---------------------------*/
+
+static void
+yy_symbol_print (FILE *yyo,
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep)
+{
+  YYFPRINTF (yyo, "%s %s (",
+             yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
+
+  yy_symbol_value_print (yyo, yykind, yyvaluep);
+  YYFPRINTF (yyo, ")");
+}
+
+/*------------------------------------------------------------------.
+| yy_stack_print -- Print the state stack from its BOTTOM up to its |
+| TOP (included).                                                   |
+`------------------------------------------------------------------*/
+
+static void
+yy_stack_print (yy_state_t *yybottom, yy_state_t *yytop)
+{
+  YYFPRINTF (stderr, "Stack now");
+  for (; yybottom <= yytop; yybottom++)
+    {
+      int yybot = *yybottom;
+      YYFPRINTF (stderr, " %d", yybot);
+    }
+  YYFPRINTF (stderr, "\n");
+}
+
+# define YY_STACK_PRINT(Bottom, Top)                            \
+do {                                                            \
+  if (yydebug)                                                  \
+    yy_stack_print ((Bottom), (Top));                           \
+} while (0)
+
+
+/*------------------------------------------------.
+| Report that the YYRULE is going to be reduced.  |
+`------------------------------------------------*/
+
+static void
+yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp,
+                 int yyrule)
+{
+  int yylno = yyrline[yyrule];
+  int yynrhs = yyr2[yyrule];
+  int yyi;
+  YYFPRINTF (stderr, "Reducing stack by rule %d (line %d):\n",
+             yyrule - 1, yylno);
+  /* The symbols being reduced.  */
+  for (yyi = 0; yyi < yynrhs; yyi++)
+    {
+      YYFPRINTF (stderr, "   $%d = ", yyi + 1);
+      yy_symbol_print (stderr,
+                       YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
+                       &yyvsp[(yyi + 1) - (yynrhs)]);
+      YYFPRINTF (stderr, "\n");
+    }
+}
+
+# define YY_REDUCE_PRINT(Rule)          \
+do {                                    \
+  if (yydebug)                          \
+    yy_reduce_print (yyssp, yyvsp, Rule); \
+} while (0)
+
+/* Nonzero means print parse trace.  It is left uninitialized so that
+   multiple parsers can coexist.  */
+int yydebug;
+#else /* !YYDEBUG */
+# define YYDPRINTF(Args) ((void) 0)
+# define YY_SYMBOL_PRINT(Title, Kind, Value, Location)
+# define YY_STACK_PRINT(Bottom, Top)
+# define YY_REDUCE_PRINT(Rule)
+#endif /* !YYDEBUG */
+
+
+/* YYINITDEPTH -- initial size of the parser's stacks.  */
+#ifndef YYINITDEPTH
+# define YYINITDEPTH 200
+#endif
+
+/* YYMAXDEPTH -- maximum size the stacks can grow to (effective only
+   if the built-in stack extension method is used).
+
+   Do not make this value too large; the results are undefined if
+   YYSTACK_ALLOC_MAXIMUM < YYSTACK_BYTES (YYMAXDEPTH)
+   evaluated with infinite-precision integer arithmetic.  */
+
+#ifndef YYMAXDEPTH
+# define YYMAXDEPTH 10000
+#endif
+
+
+
+
+
+
+/*-----------------------------------------------.
+| Release the memory associated to this symbol.  |
+`-----------------------------------------------*/
+
+static void
+yydestruct (const char *yymsg,
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep)
+{
+  YY_USE (yyvaluep);
+  if (!yymsg)
+    yymsg = "Deleting";
+  YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  YY_USE (yykind);
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+}
+
+
+/* Lookahead token kind.  */
+int yychar;
+
+/* The semantic value of the lookahead symbol.  */
+YYSTYPE yylval;
+/* Number of syntax errors so far.  */
+int yynerrs;
+
+
+
+
+/*----------.
+| yyparse.  |
+`----------*/
+
+int
+yyparse (void)
+{
+    yy_state_fast_t yystate = 0;
+    /* Number of tokens to shift before error messages enabled.  */
+    int yyerrstatus = 0;
+
+    /* Refer to the stacks through separate pointers, to allow yyoverflow
+       to reallocate them elsewhere.  */
+
+    /* Their size.  */
+    YYPTRDIFF_T yystacksize = YYINITDEPTH;
+
+    /* The state stack: array, bottom, top.  */
+    yy_state_t yyssa[YYINITDEPTH];
+    yy_state_t *yyss = yyssa;
+    yy_state_t *yyssp = yyss;
+
+    /* The semantic value stack: array, bottom, top.  */
+    YYSTYPE yyvsa[YYINITDEPTH];
+    YYSTYPE *yyvs = yyvsa;
+    YYSTYPE *yyvsp = yyvs;
+
+  int yyn;
+  /* The return value of yyparse.  */
+  int yyresult;
+  /* Lookahead symbol kind.  */
+  yysymbol_kind_t yytoken = YYSYMBOL_YYEMPTY;
+  /* The variables used to return semantic value and location from the
+     action routines.  */
+  YYSTYPE yyval;
+
+
+
+#define YYPOPSTACK(N)   (yyvsp -= (N), yyssp -= (N))
+
+  /* The number of symbols on the RHS of the reduced rule.
+     Keep to zero when no symbol should be popped.  */
+  int yylen = 0;
+
+  YYDPRINTF ((stderr, "Starting parse\n"));
+
+  yychar = YYEMPTY; /* Cause a token to be read.  */
+
+  goto yysetstate;
+
+
+/*------------------------------------------------------------.
+| yynewstate -- push a new state, which is found in yystate.  |
+`------------------------------------------------------------*/
+yynewstate:
+  /* In all cases, when you get here, the value and location stacks
+     have just been pushed.  So pushing a state here evens the stacks.  */
+  yyssp++;
+
+
+/*--------------------------------------------------------------------.
+| yysetstate -- set current state (the top of the stack) to yystate.  |
+`--------------------------------------------------------------------*/
+yysetstate:
+  YYDPRINTF ((stderr, "Entering state %d\n", yystate));
+  YY_ASSERT (0 <= yystate && yystate < YYNSTATES);
+  YY_IGNORE_USELESS_CAST_BEGIN
+  *yyssp = YY_CAST (yy_state_t, yystate);
+  YY_IGNORE_USELESS_CAST_END
+  YY_STACK_PRINT (yyss, yyssp);
+
+  if (yyss + yystacksize - 1 <= yyssp)
+#if !defined yyoverflow && !defined YYSTACK_RELOCATE
+    YYNOMEM;
+#else
+    {
+      /* Get the current used size of the three stacks, in elements.  */
+      YYPTRDIFF_T yysize = yyssp - yyss + 1;
+
+# if defined yyoverflow
+      {
+        /* Give user a chance to reallocate the stack.  Use copies of
+           these so that the &'s don't force the real ones into
+           memory.  */
+        yy_state_t *yyss1 = yyss;
+        YYSTYPE *yyvs1 = yyvs;
+
+        /* Each stack pointer address is followed by the size of the
+           data in use in that stack, in bytes.  This used to be a
+           conditional around just the two extra args, but that might
+           be undefined if yyoverflow is a macro.  */
+        yyoverflow (YY_("memory exhausted"),
+                    &yyss1, yysize * YYSIZEOF (*yyssp),
+                    &yyvs1, yysize * YYSIZEOF (*yyvsp),
+                    &yystacksize);
+        yyss = yyss1;
+        yyvs = yyvs1;
+      }
+# else /* defined YYSTACK_RELOCATE */
+      /* Extend the stack our own way.  */
+      if (YYMAXDEPTH <= yystacksize)
+        YYNOMEM;
+      yystacksize *= 2;
+      if (YYMAXDEPTH < yystacksize)
+        yystacksize = YYMAXDEPTH;
+
+      {
+        yy_state_t *yyss1 = yyss;
+        union yyalloc *yyptr =
+          YY_CAST (union yyalloc *,
+                   YYSTACK_ALLOC (YY_CAST (YYSIZE_T, YYSTACK_BYTES (yystacksize))));
+        if (! yyptr)
+          YYNOMEM;
+        YYSTACK_RELOCATE (yyss_alloc, yyss);
+        YYSTACK_RELOCATE (yyvs_alloc, yyvs);
+#  undef YYSTACK_RELOCATE
+        if (yyss1 != yyssa)
+          YYSTACK_FREE (yyss1);
+      }
+# endif
+
+      yyssp = yyss + yysize - 1;
+      yyvsp = yyvs + yysize - 1;
+
+      YY_IGNORE_USELESS_CAST_BEGIN
+      YYDPRINTF ((stderr, "Stack size increased to %ld\n",
+                  YY_CAST (long, yystacksize)));
+      YY_IGNORE_USELESS_CAST_END
+
+      if (yyss + yystacksize - 1 <= yyssp)
+        YYABORT;
+    }
+#endif /* !defined yyoverflow && !defined YYSTACK_RELOCATE */
+
+
+  if (yystate == YYFINAL)
+    YYACCEPT;
+
+  goto yybackup;
+
+
+/*-----------.
+| yybackup.  |
+`-----------*/
+yybackup:
+  /* Do appropriate processing given the current state.  Read a
+     lookahead token if we need one and don't already have one.  */
+
+  /* First try to decide what to do without reference to lookahead token.  */
+  yyn = yypact[yystate];
+  if (yypact_value_is_default (yyn))
+    goto yydefault;
+
+  /* Not known => get a lookahead token if don't already have one.  */
+
+  /* YYCHAR is either empty, or end-of-input, or a valid lookahead.  */
+  if (yychar == YYEMPTY)
+    {
+      YYDPRINTF ((stderr, "Reading a token\n"));
+      yychar = yylex ();
+    }
+
+  if (yychar <= YYEOF)
+    {
+      yychar = YYEOF;
+      yytoken = YYSYMBOL_YYEOF;
+      YYDPRINTF ((stderr, "Now at end of input.\n"));
+    }
+  else if (yychar == YYerror)
+    {
+      /* The scanner already issued an error message, process directly
+         to error recovery.  But do not keep the error token as
+         lookahead, it is too special and may lead us to an endless
+         loop in error recovery. */
+      yychar = YYUNDEF;
+      yytoken = YYSYMBOL_YYerror;
+      goto yyerrlab1;
+    }
+  else
+    {
+      yytoken = YYTRANSLATE (yychar);
+      YY_SYMBOL_PRINT ("Next token is", yytoken, &yylval, &yylloc);
+    }
+
+  /* If the proper action on seeing token YYTOKEN is to reduce or to
+     detect an error, take that action.  */
+  yyn += yytoken;
+  if (yyn < 0 || YYLAST < yyn || yycheck[yyn] != yytoken)
+    goto yydefault;
+  yyn = yytable[yyn];
+  if (yyn <= 0)
+    {
+      if (yytable_value_is_error (yyn))
+        goto yyerrlab;
+      yyn = -yyn;
+      goto yyreduce;
+    }
+
+  /* Count tokens shifted since error; after three, turn off error
+     status.  */
+  if (yyerrstatus)
+    yyerrstatus--;
+
+  /* Shift the lookahead token.  */
+  YY_SYMBOL_PRINT ("Shifting", yytoken, &yylval, &yylloc);
+  yystate = yyn;
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+  /* Discard the shifted token.  */
+  yychar = YYEMPTY;
+  goto yynewstate;
+
+
+/*-----------------------------------------------------------.
+| yydefault -- do the default action for the current state.  |
+`-----------------------------------------------------------*/
+yydefault:
+  yyn = yydefact[yystate];
+  if (yyn == 0)
+    goto yyerrlab;
+  goto yyreduce;
+
+
+/*-----------------------------.
+| yyreduce -- do a reduction.  |
+`-----------------------------*/
+yyreduce:
+  /* yyn is the number of a rule to reduce with.  */
+  yylen = yyr2[yyn];
+
+  /* If YYLEN is nonzero, implement the default value of the action:
+     '$$ = $1'.
+
+     Otherwise, the following line sets YYVAL to garbage.
+     This behavior is undocumented and Bison
+     users should not rely upon it.  Assigning to YYVAL
+     unconditionally makes the parser a bit smaller, and it avoids a
+     GCC warning that YYVAL may be used uninitialized.  */
+  yyval = yyvsp[1-yylen];
+
+
+  YY_REDUCE_PRINT (yyn);
+  switch (yyn)
+    {
+  case 2: /* $@1: %empty  */
+#line 131 "parser.y"
+                {
+		  nerrors = 0;
+		  ndeclarations = 0;
+		}
+#line 1766 "y.tab.c"
+    break;
+
+  case 3: /* program: $@1 top_level_declarations  */
+#line 136 "parser.y"
+                {
+		  if (nerrors > 0) {
+		      YYABORT;
+		  }
+		}
+#line 1776 "y.tab.c"
+    break;
+
+  case 5: /* top_level_declarations: top_level_declarations top_level_declaration  */
+#line 146 "parser.y"
+                {
+		  if (nerrors > 0) {
+		      YYABORT;
+		  }
+		}
+#line 1786 "y.tab.c"
+    break;
+
+  case 6: /* top_level_declaration: opt_private INHERIT opt_inherit_label composite_string ';'  */
+#line 155 "parser.y"
+                {
+		  if (ndeclarations > 0) {
+		      c_error("inherit must precede all declarations");
+		  } else if (nerrors > 0 ||
+			     !c_inherit((yyvsp[-1].node)->l.string->text, (yyvsp[-2].node), (yyvsp[-4].type) != 0)) {
+		      /*
+		       * The object to be inherited may have been compiled;
+		       * abort this compilation and possibly restart later.
+		       */
+		      YYABORT;
+		  }
+		}
+#line 1803 "y.tab.c"
+    break;
+
+  case 7: /* top_level_declaration: data_declaration  */
+#line 168 "parser.y"
+                { ndeclarations++; }
+#line 1809 "y.tab.c"
+    break;
+
+  case 8: /* top_level_declaration: function_declaration  */
+#line 170 "parser.y"
+                { ndeclarations++; }
+#line 1815 "y.tab.c"
+    break;
+
+  case 9: /* opt_inherit_label: %empty  */
+#line 175 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 1821 "y.tab.c"
+    break;
+
+  case 11: /* ident: IDENTIFIER  */
+#line 181 "parser.y"
+                { (yyval.node) = node_str(str_new(yytext, (long) yyleng)); }
+#line 1827 "y.tab.c"
+    break;
+
+  case 13: /* composite_string: composite_string '+' string  */
+#line 187 "parser.y"
+                { (yyval.node) = node_str(str_add((yyvsp[-2].node)->l.string, (yyvsp[0].node)->l.string)); }
+#line 1833 "y.tab.c"
+    break;
+
+  case 14: /* composite_string: '(' composite_string ')'  */
+#line 189 "parser.y"
+                { (yyval.node) = (yyvsp[-1].node); }
+#line 1839 "y.tab.c"
+    break;
+
+  case 15: /* string: STRING_CONST  */
+#line 194 "parser.y"
+                { (yyval.node) = node_str(str_new(yytext, (long) yyleng)); }
+#line 1845 "y.tab.c"
+    break;
+
+  case 16: /* data_declaration: class_specifier_list type_specifier list_dcltr ';'  */
+#line 199 "parser.y"
+                { c_global((yyvsp[-3].type), (yyvsp[-2].node), (yyvsp[-1].node)); }
+#line 1851 "y.tab.c"
+    break;
+
+  case 17: /* $@2: %empty  */
+#line 204 "parser.y"
+                { 
+		  typechecking = TRUE;
+		  c_function((yyvsp[-2].type), (yyvsp[-1].node), (yyvsp[0].node));
+		}
+#line 1860 "y.tab.c"
+    break;
+
+  case 18: /* function_declaration: class_specifier_list type_specifier function_dcltr $@2 compound_stmt  */
+#line 209 "parser.y"
+                {
+		  if (nerrors == 0) {
+		      c_funcbody((yyvsp[0].node));
+		  }
+		}
+#line 1870 "y.tab.c"
+    break;
+
+  case 19: /* $@3: %empty  */
+#line 215 "parser.y"
+                {
+		  typechecking = c_typechecking();
+		  c_function((yyvsp[-4].type), node_type((typechecking) ? T_VOID : T_NIL,
+					   (string *) NULL),
+			     node_bin(N_FUNC, 0, (yyvsp[-3].node), (yyvsp[-1].node)));
+		}
+#line 1881 "y.tab.c"
+    break;
+
+  case 20: /* function_declaration: class_specifier_list ident '(' formals_declaration ')' $@3 compound_stmt  */
+#line 222 "parser.y"
+                {
+		  if (nerrors == 0) {
+		      c_funcbody((yyvsp[0].node));
+		  }
+		}
+#line 1891 "y.tab.c"
+    break;
+
+  case 21: /* local_data_declaration: class_specifier_list type_specifier list_dcltr ';'  */
+#line 231 "parser.y"
+                { c_local((yyvsp[-3].type), (yyvsp[-2].node), (yyvsp[-1].node)); }
+#line 1897 "y.tab.c"
+    break;
+
+  case 22: /* formals_declaration: %empty  */
+#line 236 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 1903 "y.tab.c"
+    break;
+
+  case 23: /* formals_declaration: VOID  */
+#line 237 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 1909 "y.tab.c"
+    break;
+
+  case 25: /* formals_declaration: formal_declaration_list ELLIPSIS  */
+#line 240 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[-1].node);
+		  (yyval.node)->flags |= F_ELLIPSIS;
+		}
+#line 1918 "y.tab.c"
+    break;
+
+  case 27: /* formal_declaration_list: formal_declaration_list ',' varargs_formal_declaration  */
+#line 249 "parser.y"
+                { (yyval.node) = node_bin(N_PAIR, 0, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 1924 "y.tab.c"
+    break;
+
+  case 28: /* varargs_formal_declaration: VARARGS formal_declaration  */
+#line 254 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[0].node);
+		  (yyval.node)->flags |= F_VARARGS;
+		}
+#line 1933 "y.tab.c"
+    break;
+
+  case 30: /* formal_declaration: type_specifier data_dcltr  */
+#line 263 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[0].node);
+		  (yyval.node)->mod |= (yyvsp[-1].node)->mod;
+		  (yyval.node)->class = (yyvsp[-1].node)->class;
+		}
+#line 1943 "y.tab.c"
+    break;
+
+  case 31: /* formal_declaration: ident  */
+#line 268 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[0].node);
+		  (yyval.node)->mod = T_NIL;	/* only if typechecking, though */
+		}
+#line 1952 "y.tab.c"
+    break;
+
+  case 34: /* class_specifier_list: class_specifier class_specifier_list2  */
+#line 278 "parser.y"
+                { (yyval.type) = (yyvsp[-1].type) | (yyvsp[0].type); }
+#line 1958 "y.tab.c"
+    break;
+
+  case 36: /* class_specifier_list2: class_specifier_list2 class_specifier  */
+#line 284 "parser.y"
+                { (yyval.type) = (yyvsp[-1].type) | (yyvsp[0].type); }
+#line 1964 "y.tab.c"
+    break;
+
+  case 37: /* class_specifier: PRIVATE  */
+#line 289 "parser.y"
+                { (yyval.type) = C_STATIC | C_PRIVATE; }
+#line 1970 "y.tab.c"
+    break;
+
+  case 39: /* opt_private: %empty  */
+#line 295 "parser.y"
+                { (yyval.type) = 0; }
+#line 1976 "y.tab.c"
+    break;
+
+  case 40: /* opt_private: PRIVATE  */
+#line 297 "parser.y"
+                { (yyval.type) = C_STATIC | C_PRIVATE; }
+#line 1982 "y.tab.c"
+    break;
+
+  case 41: /* non_private: STATIC  */
+#line 302 "parser.y"
+                { (yyval.type) = C_STATIC; }
+#line 1988 "y.tab.c"
+    break;
+
+  case 42: /* non_private: ATOMIC  */
+#line 304 "parser.y"
+                { (yyval.type) = C_ATOMIC; }
+#line 1994 "y.tab.c"
+    break;
+
+  case 43: /* non_private: NOMASK  */
+#line 306 "parser.y"
+                { (yyval.type) = C_NOMASK; }
+#line 2000 "y.tab.c"
+    break;
+
+  case 44: /* non_private: VARARGS  */
+#line 308 "parser.y"
+                { (yyval.type) = C_VARARGS; }
+#line 2006 "y.tab.c"
+    break;
+
+  case 45: /* type_specifier: INT  */
+#line 312 "parser.y"
+                { (yyval.node) = node_type(T_INT, (string *) NULL); }
+#line 2012 "y.tab.c"
+    break;
+
+  case 46: /* type_specifier: FLOAT  */
+#line 313 "parser.y"
+                { (yyval.node) = node_type(T_FLOAT, (string *) NULL); }
+#line 2018 "y.tab.c"
+    break;
+
+  case 47: /* type_specifier: STRING  */
+#line 315 "parser.y"
+                { (yyval.node) = node_type(T_STRING, (string *) NULL); }
+#line 2024 "y.tab.c"
+    break;
+
+  case 48: /* type_specifier: OBJECT  */
+#line 317 "parser.y"
+                { (yyval.node) = node_type(T_OBJECT, (string *) NULL); }
+#line 2030 "y.tab.c"
+    break;
+
+  case 49: /* type_specifier: OBJECT composite_string  */
+#line 319 "parser.y"
+                { (yyval.node) = node_type(T_CLASS, c_objecttype((yyvsp[0].node))); }
+#line 2036 "y.tab.c"
+    break;
+
+  case 50: /* type_specifier: MAPPING  */
+#line 321 "parser.y"
+                { (yyval.node) = node_type(T_MAPPING, (string *) NULL); }
+#line 2042 "y.tab.c"
+    break;
+
+  case 51: /* type_specifier: FUNCTION  */
+#line 323 "parser.y"
+                {
+		  (yyval.node) = node_str(str_new("/" BIPREFIX "function",
+					BIPREFIXLEN + 9));
+		  (yyval.node) = node_type(T_CLASS, c_objecttype((yyval.node)));
+		}
+#line 2052 "y.tab.c"
+    break;
+
+  case 52: /* type_specifier: MIXED  */
+#line 328 "parser.y"
+                { (yyval.node) = node_type(T_MIXED, (string *) NULL); }
+#line 2058 "y.tab.c"
+    break;
+
+  case 53: /* type_specifier: VOID  */
+#line 329 "parser.y"
+                { (yyval.node) = node_type(T_VOID, (string *) NULL); }
+#line 2064 "y.tab.c"
+    break;
+
+  case 54: /* star_list: %empty  */
+#line 334 "parser.y"
+                { (yyval.type) = 0; }
+#line 2070 "y.tab.c"
+    break;
+
+  case 55: /* star_list: star_list '*'  */
+#line 336 "parser.y"
+                {
+		  (yyval.type) = (yyvsp[-1].type) + 1;
+		  if ((yyval.type) == 1 << (8 - REFSHIFT)) {
+		      c_error("too deep indirection");
+		  }
+		}
+#line 2081 "y.tab.c"
+    break;
+
+  case 56: /* data_dcltr: star_list ident  */
+#line 346 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[0].node);
+		  (yyval.node)->mod = ((yyvsp[-1].type) << REFSHIFT) & T_REF;
+		}
+#line 2090 "y.tab.c"
+    break;
+
+  case 57: /* function_dcltr: star_list ident '(' formals_declaration ')'  */
+#line 354 "parser.y"
+                { (yyval.node) = node_bin(N_FUNC, ((yyvsp[-4].type) << REFSHIFT) & T_REF, (yyvsp[-3].node), (yyvsp[-1].node)); }
+#line 2096 "y.tab.c"
+    break;
+
+  case 61: /* list_dcltr: list_dcltr ',' dcltr  */
+#line 365 "parser.y"
+                { (yyval.node) = node_bin(N_PAIR, 0, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2102 "y.tab.c"
+    break;
+
+  case 62: /* dcltr_or_stmt_list: %empty  */
+#line 370 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 2108 "y.tab.c"
+    break;
+
+  case 63: /* dcltr_or_stmt_list: dcltr_or_stmt_list dcltr_or_stmt  */
+#line 372 "parser.y"
+                { (yyval.node) = c_concat((yyvsp[-1].node), (yyvsp[0].node)); }
+#line 2114 "y.tab.c"
+    break;
+
+  case 64: /* dcltr_or_stmt: local_data_declaration  */
+#line 377 "parser.y"
+                {
+		  if (nstatements > 0) {
+		      c_error("declaration after statement");
+		  }
+		  (yyval.node) = (node *) NULL;
+		}
+#line 2125 "y.tab.c"
+    break;
+
+  case 65: /* dcltr_or_stmt: stmt  */
+#line 383 "parser.y"
+                {
+		  nstatements++;
+		  (yyval.node) = (yyvsp[0].node);
+		}
+#line 2134 "y.tab.c"
+    break;
+
+  case 66: /* dcltr_or_stmt: error ';'  */
+#line 388 "parser.y"
+                {
+		  if (nerrors >= MAX_ERRORS) {
+		      YYABORT;
+		  }
+		  (yyval.node) = (node *) NULL;
+		}
+#line 2145 "y.tab.c"
+    break;
+
+  case 67: /* $@4: %empty  */
+#line 398 "parser.y"
+                { c_startcond(); }
+#line 2151 "y.tab.c"
+    break;
+
+  case 68: /* if_stmt: IF '(' f_list_exp ')' $@4 stmt  */
+#line 399 "parser.y"
+                { (yyval.node) = c_if((yyvsp[-3].node), (yyvsp[0].node)); }
+#line 2157 "y.tab.c"
+    break;
+
+  case 69: /* stmt: list_exp ';'  */
+#line 404 "parser.y"
+                { (yyval.node) = c_exp_stmt((yyvsp[-1].node)); }
+#line 2163 "y.tab.c"
+    break;
+
+  case 71: /* stmt: if_stmt  */
+#line 407 "parser.y"
+                {
+		  c_endcond();
+		  (yyval.node) = c_endif((yyvsp[0].node), (node *) NULL);
+		}
+#line 2172 "y.tab.c"
+    break;
+
+  case 72: /* $@5: %empty  */
+#line 413 "parser.y"
+                { c_startcond2(); }
+#line 2178 "y.tab.c"
+    break;
+
+  case 73: /* stmt: if_stmt ELSE $@5 stmt  */
+#line 415 "parser.y"
+                {
+		  c_matchcond();
+		  (yyval.node) = c_endif((yyvsp[-3].node), (yyvsp[0].node));
+		}
+#line 2187 "y.tab.c"
+    break;
+
+  case 74: /* $@6: %empty  */
+#line 419 "parser.y"
+                { c_loop(); }
+#line 2193 "y.tab.c"
+    break;
+
+  case 75: /* stmt: DO $@6 stmt WHILE '(' f_list_exp ')' ';'  */
+#line 421 "parser.y"
+                { (yyval.node) = c_do((yyvsp[-2].node), (yyvsp[-5].node)); }
+#line 2199 "y.tab.c"
+    break;
+
+  case 76: /* $@7: %empty  */
+#line 423 "parser.y"
+                {
+		  c_loop();
+		  c_startcond();
+		}
+#line 2208 "y.tab.c"
+    break;
+
+  case 77: /* stmt: WHILE '(' f_list_exp ')' $@7 stmt  */
+#line 427 "parser.y"
+                {
+		  c_endcond();
+		  (yyval.node) = c_while((yyvsp[-3].node), (yyvsp[0].node));
+		}
+#line 2217 "y.tab.c"
+    break;
+
+  case 78: /* $@8: %empty  */
+#line 432 "parser.y"
+                {
+		  c_loop();
+		  c_startcond();
+		}
+#line 2226 "y.tab.c"
+    break;
+
+  case 79: /* stmt: FOR '(' opt_list_exp ';' f_opt_list_exp ';' opt_list_exp ')' $@8 stmt  */
+#line 436 "parser.y"
+                {
+		  c_endcond();
+		  (yyval.node) = c_for(c_exp_stmt((yyvsp[-7].node)), (yyvsp[-5].node), c_exp_stmt((yyvsp[-3].node)), (yyvsp[0].node));
+		}
+#line 2235 "y.tab.c"
+    break;
+
+  case 80: /* $@9: %empty  */
+#line 441 "parser.y"
+                {
+		  if (typechecking) {
+		      char tnbuf[TNBUFSIZE];
+
+		      if ((yyvsp[-3].node)->mod != T_INT && (yyvsp[-3].node)->mod != T_MIXED) {
+			  c_error("bad type for stack rlimit (%s)",
+				  i_typename(tnbuf, (yyvsp[-3].node)->mod));
+		      }
+		      if ((yyvsp[-1].node)->mod != T_INT && (yyvsp[-1].node)->mod != T_MIXED) {
+			  c_error("bad type for ticks rlimit (%s)",
+				  i_typename(tnbuf, (yyvsp[-1].node)->mod));
+		      }
+		  }
+		  c_startrlimits();
+		}
+#line 2255 "y.tab.c"
+    break;
+
+  case 81: /* stmt: RLIMITS '(' f_list_exp ';' f_list_exp ')' $@9 compound_stmt  */
+#line 457 "parser.y"
+                { (yyval.node) = c_endrlimits((yyvsp[-5].node), (yyvsp[-3].node), (yyvsp[0].node)); }
+#line 2261 "y.tab.c"
+    break;
+
+  case 82: /* $@10: %empty  */
+#line 458 "parser.y"
+                {
+		  c_startcatch();
+		  c_startcond();
+		}
+#line 2270 "y.tab.c"
+    break;
+
+  case 83: /* $@11: %empty  */
+#line 463 "parser.y"
+                {
+		  c_endcond();
+		  c_endcatch();
+		  c_startcond();
+		}
+#line 2280 "y.tab.c"
+    break;
+
+  case 84: /* stmt: CATCH $@10 compound_stmt $@11 opt_caught_stmt  */
+#line 469 "parser.y"
+                {
+		  c_endcond();
+		  (yyval.node) = c_donecatch((yyvsp[-2].node), (yyvsp[0].node));
+		}
+#line 2289 "y.tab.c"
+    break;
+
+  case 85: /* $@12: %empty  */
+#line 474 "parser.y"
+                {
+		  c_startswitch((yyvsp[-1].node), typechecking);
+		  c_startcond();
+		}
+#line 2298 "y.tab.c"
+    break;
+
+  case 86: /* stmt: SWITCH '(' f_list_exp ')' $@12 compound_stmt  */
+#line 479 "parser.y"
+                {
+		  c_endcond();
+		  (yyval.node) = c_endswitch((yyvsp[-3].node), (yyvsp[0].node));
+		}
+#line 2307 "y.tab.c"
+    break;
+
+  case 87: /* $@13: %empty  */
+#line 484 "parser.y"
+                { (yyvsp[-1].node) = c_case((yyvsp[-1].node), (node *) NULL); }
+#line 2313 "y.tab.c"
+    break;
+
+  case 88: /* stmt: CASE exp ':' $@13 stmt  */
+#line 485 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[-3].node);
+		  if ((yyval.node) != (node *) NULL) {
+		      (yyval.node)->l.left = (yyvsp[0].node);
+		  } else {
+		      (yyval.node) = (yyvsp[0].node);
+		  }
+		}
+#line 2326 "y.tab.c"
+    break;
+
+  case 89: /* $@14: %empty  */
+#line 494 "parser.y"
+                { (yyvsp[-3].node) = c_case((yyvsp[-3].node), (yyvsp[-1].node)); }
+#line 2332 "y.tab.c"
+    break;
+
+  case 90: /* stmt: CASE exp DOT_DOT exp ':' $@14 stmt  */
+#line 495 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[-5].node);
+		  if ((yyval.node) != (node *) NULL) {
+		      (yyval.node)->l.left = (yyvsp[0].node);
+		  } else {
+		      (yyval.node) = (yyvsp[0].node);
+		  }
+		}
+#line 2345 "y.tab.c"
+    break;
+
+  case 91: /* $@15: %empty  */
+#line 504 "parser.y"
+                { (yyvsp[0].node) = c_default(); }
+#line 2351 "y.tab.c"
+    break;
+
+  case 92: /* stmt: DEFAULT ':' $@15 stmt  */
+#line 505 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[-2].node);
+		  if ((yyval.node) != (node *) NULL) {
+		      (yyval.node)->l.left = (yyvsp[0].node);
+		  } else {
+		      (yyval.node) = (yyvsp[0].node);
+		  }
+		}
+#line 2364 "y.tab.c"
+    break;
+
+  case 93: /* stmt: BREAK ';'  */
+#line 514 "parser.y"
+                {
+		  (yyval.node) = c_break();
+		}
+#line 2372 "y.tab.c"
+    break;
+
+  case 94: /* stmt: CONTINUE ';'  */
+#line 518 "parser.y"
+                {
+		  (yyval.node) = c_continue();
+		}
+#line 2380 "y.tab.c"
+    break;
+
+  case 95: /* stmt: RETURN f_opt_list_exp ';'  */
+#line 522 "parser.y"
+                { (yyval.node) = c_return((yyvsp[-1].node), typechecking); }
+#line 2386 "y.tab.c"
+    break;
+
+  case 96: /* stmt: ';'  */
+#line 523 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 2392 "y.tab.c"
+    break;
+
+  case 97: /* $@16: %empty  */
+#line 527 "parser.y"
+                {
+		  nstatements = 0;
+		  c_startcompound();
+		}
+#line 2401 "y.tab.c"
+    break;
+
+  case 98: /* compound_stmt: '{' $@16 dcltr_or_stmt_list '}'  */
+#line 532 "parser.y"
+                {
+		  nstatements++;
+		  (yyval.node) = c_endcompound((yyvsp[-1].node));
+		}
+#line 2410 "y.tab.c"
+    break;
+
+  case 99: /* opt_caught_stmt: %empty  */
+#line 540 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 2416 "y.tab.c"
+    break;
+
+  case 100: /* opt_caught_stmt: ':' stmt  */
+#line 542 "parser.y"
+                { (yyval.node) = (yyvsp[0].node); }
+#line 2422 "y.tab.c"
+    break;
+
+  case 101: /* function_name: ident  */
+#line 546 "parser.y"
+                { (yyval.node) = c_flookup((yyvsp[0].node), typechecking); }
+#line 2428 "y.tab.c"
+    break;
+
+  case 102: /* function_name: COLON_COLON ident  */
+#line 548 "parser.y"
+                { (yyval.node) = c_iflookup((yyvsp[0].node), (node *) NULL); }
+#line 2434 "y.tab.c"
+    break;
+
+  case 103: /* function_name: ident COLON_COLON ident  */
+#line 550 "parser.y"
+                { (yyval.node) = c_iflookup((yyvsp[0].node), (yyvsp[-2].node)); }
+#line 2440 "y.tab.c"
+    break;
+
+  case 104: /* primary_p1_exp: INT_CONST  */
+#line 555 "parser.y"
+                { (yyval.node) = node_int((yyvsp[0].number)); }
+#line 2446 "y.tab.c"
+    break;
+
+  case 105: /* primary_p1_exp: FLOAT_CONST  */
+#line 557 "parser.y"
+                { (yyval.node) = node_float(&(yyvsp[0].real)); }
+#line 2452 "y.tab.c"
+    break;
+
+  case 106: /* primary_p1_exp: NIL  */
+#line 558 "parser.y"
+                { (yyval.node) = node_nil(); }
+#line 2458 "y.tab.c"
+    break;
+
+  case 108: /* primary_p1_exp: '(' '{' opt_arg_list_comma '}' ')'  */
+#line 561 "parser.y"
+                { (yyval.node) = c_aggregate((yyvsp[-2].node), T_MIXED | (1 << REFSHIFT)); }
+#line 2464 "y.tab.c"
+    break;
+
+  case 109: /* primary_p1_exp: '(' '[' opt_assoc_arg_list_comma ']' ')'  */
+#line 563 "parser.y"
+                { (yyval.node) = c_aggregate((yyvsp[-2].node), T_MAPPING); }
+#line 2470 "y.tab.c"
+    break;
+
+  case 110: /* primary_p1_exp: ident  */
+#line 564 "parser.y"
+                {
+		  (yyval.node) = c_variable((yyvsp[0].node));
+		  if (typechecking) {
+		      if ((yyval.node)->type == N_GLOBAL && (yyval.node)->mod != T_MIXED &&
+			  !conf_typechecking()) {
+			  /*
+			   * global vars might be modified by untypechecked
+			   * functions...
+			   */
+			  (yyval.node) = node_mon(N_CAST, (yyval.node)->mod, (yyval.node));
+			  (yyval.node)->class = (yyval.node)->l.left->class;
+		      }
+		  } else {
+		      /* the variable could be anything */
+		      (yyval.node)->mod = T_MIXED;
+		  }
+		}
+#line 2492 "y.tab.c"
+    break;
+
+  case 111: /* primary_p1_exp: '(' list_exp ')'  */
+#line 582 "parser.y"
+                { (yyval.node) = (yyvsp[-1].node); }
+#line 2498 "y.tab.c"
+    break;
+
+  case 112: /* primary_p1_exp: function_name '(' opt_arg_list ')'  */
+#line 584 "parser.y"
+                { (yyval.node) = c_checkcall(c_funcall((yyvsp[-3].node), (yyvsp[-1].node)), typechecking); }
+#line 2504 "y.tab.c"
+    break;
+
+  case 113: /* primary_p1_exp: '&' ident '(' opt_arg_list ')'  */
+#line 586 "parser.y"
+                { (yyval.node) = c_address((yyvsp[-3].node), (yyvsp[-1].node), typechecking); }
+#line 2510 "y.tab.c"
+    break;
+
+  case 114: /* primary_p1_exp: '&' '(' '*' cast_exp ')' '(' opt_arg_list ')'  */
+#line 588 "parser.y"
+                { (yyval.node) = c_extend((yyvsp[-4].node), (yyvsp[-1].node), typechecking); }
+#line 2516 "y.tab.c"
+    break;
+
+  case 115: /* primary_p1_exp: '(' '*' cast_exp ')' '(' opt_arg_list ')'  */
+#line 590 "parser.y"
+                { (yyval.node) = c_call((yyvsp[-4].node), (yyvsp[-1].node), typechecking); }
+#line 2522 "y.tab.c"
+    break;
+
+  case 116: /* $@17: %empty  */
+#line 592 "parser.y"
+                { c_startcond(); }
+#line 2528 "y.tab.c"
+    break;
+
+  case 117: /* primary_p1_exp: CATCH '(' $@17 list_exp ')'  */
+#line 594 "parser.y"
+                {
+		  c_endcond();
+		  (yyval.node) = node_mon(N_CATCH, T_STRING, (yyvsp[-1].node));
+		}
+#line 2537 "y.tab.c"
+    break;
+
+  case 118: /* primary_p1_exp: primary_p2_exp RARROW ident '(' opt_arg_list ')'  */
+#line 599 "parser.y"
+                {
+		  t_void((yyvsp[-5].node));
+		  (yyval.node) = c_checkcall(c_arrow((yyvsp[-5].node), (yyvsp[-3].node), (yyvsp[-1].node)), typechecking);
+		}
+#line 2546 "y.tab.c"
+    break;
+
+  case 119: /* primary_p1_exp: primary_p2_exp LARROW string  */
+#line 604 "parser.y"
+                { (yyval.node) = c_instanceof((yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2552 "y.tab.c"
+    break;
+
+  case 120: /* primary_p1_exp: primary_p2_exp LARROW '(' composite_string ')'  */
+#line 606 "parser.y"
+                { (yyval.node) = c_instanceof((yyvsp[-4].node), (yyvsp[-1].node)); }
+#line 2558 "y.tab.c"
+    break;
+
+  case 122: /* primary_p2_exp: primary_p2_exp '[' f_list_exp ']'  */
+#line 612 "parser.y"
+                { (yyval.node) = idx((yyvsp[-3].node), (yyvsp[-1].node)); }
+#line 2564 "y.tab.c"
+    break;
+
+  case 123: /* primary_p2_exp: primary_p2_exp '[' f_opt_list_exp DOT_DOT f_opt_list_exp ']'  */
+#line 614 "parser.y"
+                { (yyval.node) = range((yyvsp[-5].node), (yyvsp[-3].node), (yyvsp[-1].node)); }
+#line 2570 "y.tab.c"
+    break;
+
+  case 125: /* postfix_exp: postfix_exp PLUS_PLUS  */
+#line 620 "parser.y"
+                { (yyval.node) = uassign(N_PLUS_PLUS, (yyvsp[-1].node), "++"); }
+#line 2576 "y.tab.c"
+    break;
+
+  case 126: /* postfix_exp: postfix_exp MIN_MIN  */
+#line 622 "parser.y"
+                { (yyval.node) = uassign(N_MIN_MIN, (yyvsp[-1].node), "--"); }
+#line 2582 "y.tab.c"
+    break;
+
+  case 128: /* prefix_exp: PLUS_PLUS cast_exp  */
+#line 628 "parser.y"
+                { (yyval.node) = uassign(N_ADD_EQ_1, (yyvsp[0].node), "++"); }
+#line 2588 "y.tab.c"
+    break;
+
+  case 129: /* prefix_exp: MIN_MIN cast_exp  */
+#line 630 "parser.y"
+                { (yyval.node) = uassign(N_SUB_EQ_1, (yyvsp[0].node), "--"); }
+#line 2594 "y.tab.c"
+    break;
+
+  case 130: /* prefix_exp: '-' cast_exp  */
+#line 632 "parser.y"
+                { (yyval.node) = umin((yyvsp[0].node)); }
+#line 2600 "y.tab.c"
+    break;
+
+  case 131: /* prefix_exp: '+' cast_exp  */
+#line 634 "parser.y"
+                { (yyval.node) = (yyvsp[0].node); }
+#line 2606 "y.tab.c"
+    break;
+
+  case 132: /* prefix_exp: '!' cast_exp  */
+#line 636 "parser.y"
+                {
+		  t_void((yyvsp[0].node));
+		  (yyval.node) = c_not((yyvsp[0].node));
+		}
+#line 2615 "y.tab.c"
+    break;
+
+  case 133: /* prefix_exp: '~' cast_exp  */
+#line 641 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[0].node);
+		  t_void((yyval.node));
+		  if (typechecking && (yyval.node)->mod != T_INT && (yyval.node)->mod != T_MIXED) {
+		      char tnbuf[TNBUFSIZE];
+
+		      c_error("bad argument type for ~ (%s)",
+			      i_typename(tnbuf, (yyval.node)->mod));
+		      (yyval.node)->mod = T_MIXED;
+		  } else {
+		      (yyval.node) = xor(N_XOR, (yyval.node), node_int((Int) -1), "^");
+		  }
+		}
+#line 2633 "y.tab.c"
+    break;
+
+  case 135: /* cast_exp: '(' type_specifier star_list ')' cast_exp  */
+#line 659 "parser.y"
+                {
+		  (yyvsp[-3].node)->mod |= ((yyvsp[-2].type) << REFSHIFT) & T_REF;
+		  (yyval.node) = cast((yyvsp[0].node), (yyvsp[-3].node));
+		}
+#line 2642 "y.tab.c"
+    break;
+
+  case 137: /* mult_oper_exp: mult_oper_exp '*' cast_exp  */
+#line 668 "parser.y"
+                { (yyval.node) = mult(N_MULT, (yyvsp[-2].node), (yyvsp[0].node), "*"); }
+#line 2648 "y.tab.c"
+    break;
+
+  case 138: /* mult_oper_exp: mult_oper_exp '/' cast_exp  */
+#line 670 "parser.y"
+                { (yyval.node) = mdiv(N_DIV, (yyvsp[-2].node), (yyvsp[0].node), "/"); }
+#line 2654 "y.tab.c"
+    break;
+
+  case 139: /* mult_oper_exp: mult_oper_exp '%' cast_exp  */
+#line 672 "parser.y"
+                { (yyval.node) = mod(N_MOD, (yyvsp[-2].node), (yyvsp[0].node), "%"); }
+#line 2660 "y.tab.c"
+    break;
+
+  case 141: /* add_oper_exp: add_oper_exp '+' mult_oper_exp  */
+#line 678 "parser.y"
+                { (yyval.node) = add(N_ADD, (yyvsp[-2].node), (yyvsp[0].node), "+"); }
+#line 2666 "y.tab.c"
+    break;
+
+  case 142: /* add_oper_exp: add_oper_exp '-' mult_oper_exp  */
+#line 680 "parser.y"
+                { (yyval.node) = sub(N_SUB, (yyvsp[-2].node), (yyvsp[0].node), "-"); }
+#line 2672 "y.tab.c"
+    break;
+
+  case 144: /* shift_oper_exp: shift_oper_exp LSHIFT add_oper_exp  */
+#line 686 "parser.y"
+                { (yyval.node) = lshift(N_LSHIFT, (yyvsp[-2].node), (yyvsp[0].node), "<<"); }
+#line 2678 "y.tab.c"
+    break;
+
+  case 145: /* shift_oper_exp: shift_oper_exp RSHIFT add_oper_exp  */
+#line 688 "parser.y"
+                { (yyval.node) = rshift(N_RSHIFT, (yyvsp[-2].node), (yyvsp[0].node), ">>"); }
+#line 2684 "y.tab.c"
+    break;
+
+  case 147: /* rel_oper_exp: rel_oper_exp '<' shift_oper_exp  */
+#line 694 "parser.y"
+                { (yyval.node) = rel(N_LT, (yyval.node), (yyvsp[0].node), "<"); }
+#line 2690 "y.tab.c"
+    break;
+
+  case 148: /* rel_oper_exp: rel_oper_exp '>' shift_oper_exp  */
+#line 696 "parser.y"
+                { (yyval.node) = rel(N_GT, (yyval.node), (yyvsp[0].node), ">"); }
+#line 2696 "y.tab.c"
+    break;
+
+  case 149: /* rel_oper_exp: rel_oper_exp LE shift_oper_exp  */
+#line 698 "parser.y"
+                { (yyval.node) = rel(N_LE, (yyval.node), (yyvsp[0].node), "<="); }
+#line 2702 "y.tab.c"
+    break;
+
+  case 150: /* rel_oper_exp: rel_oper_exp GE shift_oper_exp  */
+#line 700 "parser.y"
+                { (yyval.node) = rel(N_GE, (yyval.node), (yyvsp[0].node), ">="); }
+#line 2708 "y.tab.c"
+    break;
+
+  case 152: /* equ_oper_exp: equ_oper_exp EQ rel_oper_exp  */
+#line 706 "parser.y"
+                { (yyval.node) = eq((yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2714 "y.tab.c"
+    break;
+
+  case 153: /* equ_oper_exp: equ_oper_exp NE rel_oper_exp  */
+#line 708 "parser.y"
+                { (yyval.node) = c_not(eq((yyvsp[-2].node), (yyvsp[0].node))); }
+#line 2720 "y.tab.c"
+    break;
+
+  case 155: /* bitand_oper_exp: bitand_oper_exp '&' equ_oper_exp  */
+#line 714 "parser.y"
+                { (yyval.node) = and(N_AND, (yyvsp[-2].node), (yyvsp[0].node), "&"); }
+#line 2726 "y.tab.c"
+    break;
+
+  case 157: /* bitxor_oper_exp: bitxor_oper_exp '^' bitand_oper_exp  */
+#line 720 "parser.y"
+                { (yyval.node) = xor(N_XOR, (yyvsp[-2].node), (yyvsp[0].node), "^"); }
+#line 2732 "y.tab.c"
+    break;
+
+  case 159: /* bitor_oper_exp: bitor_oper_exp '|' bitxor_oper_exp  */
+#line 726 "parser.y"
+                { (yyval.node) = or(N_OR, (yyvsp[-2].node), (yyvsp[0].node), "|"); }
+#line 2738 "y.tab.c"
+    break;
+
+  case 161: /* and_oper_exp: and_oper_exp LAND bitor_oper_exp  */
+#line 732 "parser.y"
+                { (yyval.node) = land((yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2744 "y.tab.c"
+    break;
+
+  case 163: /* or_oper_exp: or_oper_exp LOR and_oper_exp  */
+#line 738 "parser.y"
+                { (yyval.node) = lor((yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2750 "y.tab.c"
+    break;
+
+  case 165: /* $@18: %empty  */
+#line 744 "parser.y"
+                { c_startcond(); }
+#line 2756 "y.tab.c"
+    break;
+
+  case 166: /* $@19: %empty  */
+#line 746 "parser.y"
+                { c_startcond2(); }
+#line 2762 "y.tab.c"
+    break;
+
+  case 167: /* cond_exp: or_oper_exp '?' $@18 list_exp ':' $@19 cond_exp  */
+#line 748 "parser.y"
+                {
+		  c_matchcond();
+		  (yyval.node) = quest((yyvsp[-6].node), (yyvsp[-3].node), (yyvsp[0].node));
+		}
+#line 2771 "y.tab.c"
+    break;
+
+  case 169: /* exp: cond_exp '=' exp  */
+#line 757 "parser.y"
+                { (yyval.node) = assign(c_assign((yyvsp[-2].node)), (yyvsp[0].node)); }
+#line 2777 "y.tab.c"
+    break;
+
+  case 170: /* exp: cond_exp PLUS_EQ exp  */
+#line 759 "parser.y"
+                { (yyval.node) = add(N_ADD_EQ, c_lvalue((yyvsp[-2].node), "+="), (yyvsp[0].node), "+="); }
+#line 2783 "y.tab.c"
+    break;
+
+  case 171: /* exp: cond_exp MIN_EQ exp  */
+#line 761 "parser.y"
+                { (yyval.node) = sub(N_SUB_EQ, c_lvalue((yyvsp[-2].node), "-="), (yyvsp[0].node), "-="); }
+#line 2789 "y.tab.c"
+    break;
+
+  case 172: /* exp: cond_exp MULT_EQ exp  */
+#line 763 "parser.y"
+                { (yyval.node) = mult(N_MULT_EQ, c_lvalue((yyvsp[-2].node), "*="), (yyvsp[0].node), "*="); }
+#line 2795 "y.tab.c"
+    break;
+
+  case 173: /* exp: cond_exp DIV_EQ exp  */
+#line 765 "parser.y"
+                { (yyval.node) = mdiv(N_DIV_EQ, c_lvalue((yyvsp[-2].node), "/="), (yyvsp[0].node), "/="); }
+#line 2801 "y.tab.c"
+    break;
+
+  case 174: /* exp: cond_exp MOD_EQ exp  */
+#line 767 "parser.y"
+                { (yyval.node) = mod(N_MOD_EQ, c_lvalue((yyvsp[-2].node), "%="), (yyvsp[0].node), "%="); }
+#line 2807 "y.tab.c"
+    break;
+
+  case 175: /* exp: cond_exp LSHIFT_EQ exp  */
+#line 769 "parser.y"
+                { (yyval.node) = lshift(N_LSHIFT_EQ, c_lvalue((yyvsp[-2].node), "<<="), (yyvsp[0].node), "<<="); }
+#line 2813 "y.tab.c"
+    break;
+
+  case 176: /* exp: cond_exp RSHIFT_EQ exp  */
+#line 771 "parser.y"
+                { (yyval.node) = rshift(N_RSHIFT_EQ, c_lvalue((yyvsp[-2].node), ">>="), (yyvsp[0].node), ">>="); }
+#line 2819 "y.tab.c"
+    break;
+
+  case 177: /* exp: cond_exp AND_EQ exp  */
+#line 773 "parser.y"
+                { (yyval.node) = and(N_AND_EQ, c_lvalue((yyvsp[-2].node), "&="), (yyvsp[0].node), "&="); }
+#line 2825 "y.tab.c"
+    break;
+
+  case 178: /* exp: cond_exp XOR_EQ exp  */
+#line 775 "parser.y"
+                { (yyval.node) = xor(N_XOR_EQ, c_lvalue((yyvsp[-2].node), "^="), (yyvsp[0].node), "^="); }
+#line 2831 "y.tab.c"
+    break;
+
+  case 179: /* exp: cond_exp OR_EQ exp  */
+#line 777 "parser.y"
+                { (yyval.node) = or(N_OR_EQ, c_lvalue((yyvsp[-2].node), "|="), (yyvsp[0].node), "|="); }
+#line 2837 "y.tab.c"
+    break;
+
+  case 181: /* list_exp: list_exp ',' exp  */
+#line 783 "parser.y"
+                { (yyval.node) = comma((yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2843 "y.tab.c"
+    break;
+
+  case 182: /* opt_list_exp: %empty  */
+#line 788 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 2849 "y.tab.c"
+    break;
+
+  case 184: /* f_list_exp: list_exp  */
+#line 794 "parser.y"
+                { t_void((yyval.node) = (yyvsp[0].node)); }
+#line 2855 "y.tab.c"
+    break;
+
+  case 185: /* f_opt_list_exp: opt_list_exp  */
+#line 799 "parser.y"
+                { t_void((yyval.node) = (yyvsp[0].node)); }
+#line 2861 "y.tab.c"
+    break;
+
+  case 186: /* arg_list: exp  */
+#line 803 "parser.y"
+                { t_void((yyval.node) = (yyvsp[0].node)); }
+#line 2867 "y.tab.c"
+    break;
+
+  case 187: /* arg_list: arg_list ',' exp  */
+#line 805 "parser.y"
+                {
+		  t_void((yyvsp[0].node));
+		  (yyval.node) = node_bin(N_PAIR, 0, (yyvsp[-2].node), (yyvsp[0].node));
+		}
+#line 2876 "y.tab.c"
+    break;
+
+  case 188: /* opt_arg_list: %empty  */
+#line 813 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 2882 "y.tab.c"
+    break;
+
+  case 190: /* opt_arg_list: arg_list ELLIPSIS  */
+#line 816 "parser.y"
+                {
+		  (yyval.node) = (yyvsp[-1].node);
+		  if ((yyval.node)->type == N_PAIR) {
+		      (yyval.node)->r.right = node_mon(N_SPREAD, -1, (yyval.node)->r.right);
+		  } else {
+		      (yyval.node) = node_mon(N_SPREAD, -1, (yyval.node));
+		  }
+		}
+#line 2895 "y.tab.c"
+    break;
+
+  case 191: /* opt_arg_list_comma: %empty  */
+#line 828 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 2901 "y.tab.c"
+    break;
+
+  case 193: /* opt_arg_list_comma: arg_list ','  */
+#line 831 "parser.y"
+                { (yyval.node) = (yyvsp[-1].node); }
+#line 2907 "y.tab.c"
+    break;
+
+  case 194: /* assoc_exp: exp ':' exp  */
+#line 836 "parser.y"
+                {
+		  t_void((yyvsp[-2].node));
+		  t_void((yyvsp[0].node));
+		  (yyval.node) = node_bin(N_COMMA, 0, (yyvsp[-2].node), (yyvsp[0].node));
+		}
+#line 2917 "y.tab.c"
+    break;
+
+  case 196: /* assoc_arg_list: assoc_arg_list ',' assoc_exp  */
+#line 846 "parser.y"
+                { (yyval.node) = node_bin(N_PAIR, 0, (yyvsp[-2].node), (yyvsp[0].node)); }
+#line 2923 "y.tab.c"
+    break;
+
+  case 197: /* opt_assoc_arg_list_comma: %empty  */
+#line 851 "parser.y"
+                { (yyval.node) = (node *) NULL; }
+#line 2929 "y.tab.c"
+    break;
+
+  case 199: /* opt_assoc_arg_list_comma: assoc_arg_list ','  */
+#line 854 "parser.y"
+                { (yyval.node) = (yyvsp[-1].node); }
+#line 2935 "y.tab.c"
+    break;
+
+
+#line 2939 "y.tab.c"
+
+      default: break;
+    }
+  /* User semantic actions sometimes alter yychar, and that requires
+     that yytoken be updated with the new translation.  We take the
+     approach of translating immediately before every use of yytoken.
+     One alternative is translating here after every semantic action,
+     but that translation would be missed if the semantic action invokes
+     YYABORT, YYACCEPT, or YYERROR immediately after altering yychar or
+     if it invokes YYBACKUP.  In the case of YYABORT or YYACCEPT, an
+     incorrect destructor might then be invoked immediately.  In the
+     case of YYERROR or YYBACKUP, subsequent parser actions might lead
+     to an incorrect destructor call or verbose syntax error message
+     before the lookahead is translated.  */
+  YY_SYMBOL_PRINT ("-> $$ =", YY_CAST (yysymbol_kind_t, yyr1[yyn]), &yyval, &yyloc);
+
+  YYPOPSTACK (yylen);
+  yylen = 0;
+
+  *++yyvsp = yyval;
+
+  /* Now 'shift' the result of the reduction.  Determine what state
+     that goes to, based on the state we popped back to and the rule
+     number reduced by.  */
+  {
+    const int yylhs = yyr1[yyn] - YYNTOKENS;
+    const int yyi = yypgoto[yylhs] + *yyssp;
+    yystate = (0 <= yyi && yyi <= YYLAST && yycheck[yyi] == *yyssp
+               ? yytable[yyi]
+               : yydefgoto[yylhs]);
+  }
+
+  goto yynewstate;
+
+
+/*--------------------------------------.
+| yyerrlab -- here on detecting error.  |
+`--------------------------------------*/
+yyerrlab:
+  /* Make sure we have latest lookahead translation.  See comments at
+     user semantic actions for why this is necessary.  */
+  yytoken = yychar == YYEMPTY ? YYSYMBOL_YYEMPTY : YYTRANSLATE (yychar);
+  /* If not already recovering from an error, report this error.  */
+  if (!yyerrstatus)
+    {
+      ++yynerrs;
+      yyerror (YY_("syntax error"));
+    }
+
+  if (yyerrstatus == 3)
+    {
+      /* If just tried and failed to reuse lookahead token after an
+         error, discard it.  */
+
+      if (yychar <= YYEOF)
+        {
+          /* Return failure if at end of input.  */
+          if (yychar == YYEOF)
+            YYABORT;
+        }
+      else
+        {
+          yydestruct ("Error: discarding",
+                      yytoken, &yylval);
+          yychar = YYEMPTY;
+        }
+    }
+
+  /* Else will try to reuse lookahead token after shifting the error
+     token.  */
+  goto yyerrlab1;
+
+
+/*---------------------------------------------------.
+| yyerrorlab -- error raised explicitly by YYERROR.  |
+`---------------------------------------------------*/
+yyerrorlab:
+  /* Pacify compilers when the user code never invokes YYERROR and the
+     label yyerrorlab therefore never appears in user code.  */
+  if (0)
+    YYERROR;
+  ++yynerrs;
+
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYERROR.  */
+  YYPOPSTACK (yylen);
+  yylen = 0;
+  YY_STACK_PRINT (yyss, yyssp);
+  yystate = *yyssp;
+  goto yyerrlab1;
+
+
+/*-------------------------------------------------------------.
+| yyerrlab1 -- common code for both syntax error and YYERROR.  |
+`-------------------------------------------------------------*/
+yyerrlab1:
+  yyerrstatus = 3;      /* Each real token shifted decrements this.  */
+
+  /* Pop stack until we find a state that shifts the error token.  */
+  for (;;)
+    {
+      yyn = yypact[yystate];
+      if (!yypact_value_is_default (yyn))
+        {
+          yyn += YYSYMBOL_YYerror;
+          if (0 <= yyn && yyn <= YYLAST && yycheck[yyn] == YYSYMBOL_YYerror)
+            {
+              yyn = yytable[yyn];
+              if (0 < yyn)
+                break;
+            }
+        }
+
+      /* Pop the current state because it cannot handle the error token.  */
+      if (yyssp == yyss)
+        YYABORT;
+
+
+      yydestruct ("Error: popping",
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp);
+      YYPOPSTACK (1);
+      yystate = *yyssp;
+      YY_STACK_PRINT (yyss, yyssp);
+    }
+
+  YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
+  *++yyvsp = yylval;
+  YY_IGNORE_MAYBE_UNINITIALIZED_END
+
+
+  /* Shift the error token.  */
+  YY_SYMBOL_PRINT ("Shifting", YY_ACCESSING_SYMBOL (yyn), yyvsp, yylsp);
+
+  yystate = yyn;
+  goto yynewstate;
+
+
+/*-------------------------------------.
+| yyacceptlab -- YYACCEPT comes here.  |
+`-------------------------------------*/
+yyacceptlab:
+  yyresult = 0;
+  goto yyreturnlab;
+
+
+/*-----------------------------------.
+| yyabortlab -- YYABORT comes here.  |
+`-----------------------------------*/
+yyabortlab:
+  yyresult = 1;
+  goto yyreturnlab;
+
+
+/*-----------------------------------------------------------.
+| yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
+`-----------------------------------------------------------*/
+yyexhaustedlab:
+  yyerror (YY_("memory exhausted"));
+  yyresult = 2;
+  goto yyreturnlab;
+
+
+/*----------------------------------------------------------.
+| yyreturnlab -- parsing is finished, clean up and return.  |
+`----------------------------------------------------------*/
+yyreturnlab:
+  if (yychar != YYEMPTY)
+    {
+      /* Make sure we have latest lookahead translation.  See comments at
+         user semantic actions for why this is necessary.  */
+      yytoken = YYTRANSLATE (yychar);
+      yydestruct ("Cleanup: discarding lookahead",
+                  yytoken, &yylval);
+    }
+  /* Do not reclaim the symbols of the rule whose action triggered
+     this YYABORT or YYACCEPT.  */
+  YYPOPSTACK (yylen);
+  YY_STACK_PRINT (yyss, yyssp);
+  while (yyssp != yyss)
+    {
+      yydestruct ("Cleanup: popping",
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp);
+      YYPOPSTACK (1);
+    }
+#ifndef yyoverflow
+  if (yyss != yyssa)
+    YYSTACK_FREE (yyss);
+#endif
+
+  return yyresult;
+}
+
+#line 857 "parser.y"
+
+
+/*
+ * NAME:	t_void()
+ * DESCRIPTION:	if the argument is of type void, an error will result
+ */
+static void t_void(node *n)
+{
+    if (n != (node *) NULL && n->mod == T_VOID) {
+	c_error("void value not ignored");
+	n->mod = T_MIXED;
+    }
+}
+
+/*
+ * NAME:	t_unary()
+ * DESCRIPTION:	typecheck the argument of a unary operator
+ */
+static bool t_unary(node *n, char *name)
+{
+    char tnbuf[TNBUFSIZE];
+
+    t_void(n);
+    if (typechecking && !T_ARITHMETIC(n->mod) && n->mod != T_MIXED) {
+	c_error("bad argument type for %s (%s)", name,
+		i_typename(tnbuf, n->mod));
+	n->mod = T_MIXED;
+	return FALSE;
+    }
+    return TRUE;
+}
+
+/*
+ * NAME:	uassign()
+ * DESCRIPTION:	handle a unary assignment operator
+ */
+static node *uassign(int op, node *n, char *name)
+{
+    t_unary(n, name);
+    return node_mon((n->mod == T_INT) ? op + 1 : op, n->mod, c_lvalue(n, name));
+}
+
+/*
+ * NAME:	cast()
+ * DESCRIPTION:	cast an expression to a type
+ */
+static node *cast(node *n, node *type)
+{
+    xfloat flt;
+    Int i;
+    char *p, buffer[18];
+
+    if (type->mod != n->mod) {
+	switch (type->mod) {
+	case T_INT:
+	    switch (n->type) {
+	    case N_FLOAT:
+		/* cast float constant to int */
+		NFLT_GET(n, flt);
+		return node_int(flt_ftoi(&flt));
+
+	    case N_STR:
+		/* cast string to int */
+		p = n->l.string->text;
+		i = strtoint(&p);
+		if (p == n->l.string->text + n->l.string->len) {
+		    return node_int(i);
+		} else {
+		    c_error("cast of invalid string constant");
+		    n->mod = T_MIXED;
+		}
+		break;
+
+	    case N_TOFLOAT:
+	    case N_TOSTRING:
+		if (n->l.left->type == N_INT) {
+		    /* (int) (float) i, (int) (string) i */
+		    return n->l.left;
+		}
+		/* fall through */
+	    default:
+		if (n->mod == T_FLOAT || n->mod == T_STRING ||
+		    n->mod == T_MIXED) {
+		    return node_mon(N_TOINT, T_INT, n);
+		}
+		break;
+	    }
+	    break;
+
+	case T_FLOAT:
+	    switch (n->type) {
+	    case N_INT:
+		/* cast int constant to float */
+		flt_itof(n->l.number, &flt);
+		return node_float(&flt);
+
+	    case N_STR:
+		/* cast string to float */
+		p = n->l.string->text;
+		if (flt_atof(&p, &flt) &&
+		    p == n->l.string->text + n->l.string->len) {
+		    return node_float(&flt);
+		} else {
+		    yyerror("cast of invalid string constant");
+		    n->mod = T_MIXED;
+		}
+		break;
+
+	    case N_TOSTRING:
+		if (n->l.left->mod == T_INT) {
+		    return node_mon(N_TOFLOAT, T_FLOAT, n->l.left);
+		}
+		/* fall through */
+	    default:
+		if (n->mod == T_INT || n->mod == T_STRING || n->mod == T_MIXED)
+		{
+		    return node_mon(N_TOFLOAT, T_FLOAT, n);
+		}
+		break;
+	    }
+	    break;
+
+	case T_STRING:
+	    switch (n->type) {
+	    case N_INT:
+		/* cast int constant to string */
+		sprintf(buffer, "%ld", (long) n->l.number);
+		return node_str(str_new(buffer, (long) strlen(buffer)));
+
+	    case N_FLOAT:
+		/* cast float constant to string */
+		NFLT_GET(n, flt);
+		flt_ftoa(&flt, buffer);
+		return node_str(str_new(buffer, (long) strlen(buffer)));
+
+	    default:
+		if (n->mod == T_INT || n->mod == T_FLOAT || n->mod == T_MIXED) {
+		    return node_mon(N_TOSTRING, T_STRING, n);
+		}
+		break;
+	    }
+	    break;
+	}
+
+	if (type->mod == T_MIXED || (type->mod & T_TYPE) == T_VOID) {
+	    /* (mixed), (void), (void *) */
+	    c_error("cannot cast to %s", i_typename(buffer, type->mod));
+	    n->mod = T_MIXED;
+	} else if ((type->mod & T_REF) < (n->mod & T_REF)) {
+	    /* (mixed *) of (mixed **) */
+	    c_error("illegal cast of array type (%s)",
+		    i_typename(buffer, n->mod));
+	} else if ((n->mod & T_TYPE) != T_MIXED &&
+		   ((type->mod & T_TYPE) != T_CLASS ||
+		    ((n->mod & T_TYPE) != T_OBJECT &&
+		     (n->mod & T_TYPE) != T_CLASS) ||
+		    (type->mod & T_REF) != (n->mod & T_REF))) {
+	    /* can only cast from mixed, or object/class to class */
+	    c_error("cast of invalid type (%s)", i_typename(buffer, n->mod));
+	} else {
+	    if ((type->mod & T_REF) == 0 || (n->mod & T_REF) == 0) {
+		/* runtime cast */
+		n = node_mon(N_CAST, type->mod, n);
+	    } else {
+		n->mod = type->mod;
+	    }
+	    n->class = type->class;
+	}
+    } else if (type->mod == T_CLASS && str_cmp(type->class, n->class) != 0) {
+	/*
+	 * cast to different object class
+	 */
+	n = node_mon(N_CAST, type->mod, n);
+	n->class = type->class;
+    }
+    return n;
+}
+
+/*
+ * NAME:	idx()
+ * DESCRIPTION:	handle the [ ] operator
+ */
+static node *idx(node *n1, node *n2)
+{
+    char tnbuf[TNBUFSIZE];
+    unsigned short type;
+
+    if (n1->type == N_STR && n2->type == N_INT) {
+	/* str [ int ] */
+	if (n2->l.number < 0 || n2->l.number >= (Int) n1->l.string->len) {
+	    c_error("string index out of range");
+	} else {
+	    n2->l.number =
+		    UCHAR(n1->l.string->text[str_index(n1->l.string,
+						       (long) n2->l.number)]);
+	}
+	return n2;
+    }
+
+    if ((n1->mod & T_REF) != 0) {
+	/*
+	 * array
+	 */
+	if (typechecking) {
+	    type = n1->mod - (1 << REFSHIFT);
+	    if (n2->mod != T_INT && n2->mod != T_MIXED) {
+		c_error("bad index type (%s)", i_typename(tnbuf, n2->mod));
+	    }
+	    if (type != T_MIXED) {
+		/* you can't trust these arrays */
+		n2 = node_mon(N_CAST, type, node_bin(N_INDEX, type, n1, n2));
+		n2->class = n1->class;
+		return n2;
+	    }
+	}
+	type = T_MIXED;
+    } else if (n1->mod == T_STRING) {
+	/*
+	 * string
+	 */
+	if (typechecking && n2->mod != T_INT && n2->mod != T_MIXED) {
+	    c_error("bad index type (%s)", i_typename(tnbuf, n2->mod));
+	}
+	type = T_INT;
+    } else {
+	if (typechecking && n1->mod != T_MAPPING && n1->mod != T_MIXED) {
+	    c_error("bad indexed type (%s)", i_typename(tnbuf, n1->mod));
+	}
+	type = T_MIXED;
+    }
+    return node_bin(N_INDEX, type, n1, n2);
+}
+
+/*
+ * NAME:	range()
+ * DESCRIPTION:	handle the [ .. ] operator
+ */
+static node *range(node *n1, node *n2, node *n3)
+{
+    if (n1->type == N_STR && (n2 == (node *) NULL || n2->type == N_INT) &&
+	(n3 == (node *) NULL || n3->type == N_INT)) {
+	Int from, to;
+
+	/* str [ int .. int ] */
+	from = (n2 == (node *) NULL) ? 0 : n2->l.number;
+	to = (n3 == (node *) NULL) ? n1->l.string->len - 1 : n3->l.number;
+	if (from < 0 || from > to + 1 || to >= n1->l.string->len) {
+	    c_error("invalid string range");
+	} else {
+	    return node_str(str_range(n1->l.string, (long) from, (long) to));
+	}
+    }
+
+    if (typechecking && n1->mod != T_MAPPING && n1->mod != T_MIXED) {
+	char tnbuf[TNBUFSIZE];
+
+	/* indices */
+	if (n2 != (node *) NULL && n2->mod != T_INT && n2->mod != T_MIXED) {
+	    c_error("bad index type (%s)", i_typename(tnbuf, n2->mod));
+	}
+	if (n3 != (node *) NULL && n3->mod != T_INT && n3->mod != T_MIXED) {
+	    c_error("bad index type (%s)", i_typename(tnbuf, n3->mod));
+	}
+	/* range */
+	if ((n1->mod & T_REF) == 0 && n1->mod != T_STRING) {
+	    c_error("bad indexed type (%s)", i_typename(tnbuf, n1->mod));
+	}
+    }
+
+    return node_bin(N_RANGE, n1->mod, n1, node_bin(N_PAIR, 0, n2, n3));
+}
+
+/*
+ * NAME:	bini()
+ * DESCRIPTION:	handle a binary int operator
+ */
+static node *bini(int op, node *n1, node *n2, char *name)
+{
+    char tnbuf1[TNBUFSIZE], tnbuf2[TNBUFSIZE];
+
+    t_void(n1);
+    t_void(n2);
+
+    if (typechecking &&
+	((n1->mod != T_INT && n1->mod != T_MIXED) ||
+	 (n2->mod != T_INT && n2->mod != T_MIXED))) {
+	c_error("bad argument types for %s (%s, %s)", name,
+		i_typename(tnbuf1, n1->mod), i_typename(tnbuf2, n2->mod));
+    }
+    if (n1->mod == T_INT && n2->mod == T_INT) {
+	op++;
+    }
+    return node_bin(op, T_INT, n1, n2);
+}
+
+
+/*
+ * NAME:	bina()
+ * DESCRIPTION:	handle a binary arithmetic operator
+ */
+static node *bina(int op, node *n1, node *n2, char *name)
+{
+    char tnbuf1[TNBUFSIZE], tnbuf2[TNBUFSIZE];
+    unsigned short type;
+
+    t_void(n1);
+    t_void(n2);
+
+    type = T_MIXED;
+    if (typechecking &&
+	((n1->mod != n2->mod && n1->mod != T_MIXED && n2->mod != T_MIXED) ||
+	 (!T_ARITHMETIC(n1->mod) && n1->mod != T_MIXED) ||
+	 (!T_ARITHMETIC(n2->mod) && n2->mod != T_MIXED))) {
+	c_error("bad argument types for %s (%s, %s)", name,
+		i_typename(tnbuf1, n1->mod), i_typename(tnbuf2, n2->mod));
+    } else if (n1->mod == T_INT || n2->mod == T_INT) {
+	if (n1->mod == T_INT && n2->mod == T_INT) {
+	    op++;
+	}
+	type = T_INT;
+    } else if (n1->mod == T_FLOAT || n2->mod == T_FLOAT) {
+	type = T_FLOAT;
+        switch(op) {
+	    case N_ADD: 
+	    case N_ADD_EQ: 
+	    case N_ADD_EQ_1: 
+	    case N_DIV:
+	    case N_DIV_EQ:
+	    case N_EQ:
+	    case N_GE:
+	    case N_GT:
+	    case N_LE:
+	    case N_LT:
+	    case N_MULT:
+	    case N_MULT_EQ:
+	    case N_NE:
+	    case N_SUB_EQ_1:
+	    case N_SUB_EQ:
+	    case N_MIN_MIN:
+	    case N_PLUS_PLUS:
+		op+=2;
+		break;
+	    default:
+		break;
+	}
+    }
+
+    return node_bin(op, type, n1, n2);
+}
+
+/*
+ * NAME:	mult()
+ * DESCRIPTION:	handle the * *= operators
+ */
+static node *mult(int op, node *n1, node *n2, char *name)
+{
+    xfloat f1, f2;
+
+    if (n1->type == N_INT && n2->type == N_INT) {
+	/* i * i */
+	n1->l.number *= n2->l.number;
+	return n1;
+    }
+    if (n1->type == N_FLOAT && n2->type == N_FLOAT) {
+	NFLT_GET(n1, f1);
+	NFLT_GET(n2, f2);
+	flt_mult(&f1, &f2);
+	NFLT_PUT(n1, f1);
+	return n1;
+    }
+    return bina(op, n1, n2, name);
+}
+
+/*
+ * NAME:	mdiv()
+ * DESCRIPTION:	handle the / /= operators
+ */
+static node *mdiv(int op, node *n1, node *n2, char *name)
+{
+    xfloat f1, f2;
+
+    if (n1->type == N_INT && n2->type == N_INT) {
+	Int i, d;
+
+	/* i / i */
+	i = n1->l.number;
+	d = n2->l.number;
+	if (d == 0) {
+	    /* i / 0 */
+	    c_error("division by zero");
+	    return n1;
+	}
+	if ((d | i) < 0) {
+	    Int r;
+
+	    r = ((Uint) ((i < 0) ? -i : i)) / ((Uint) ((d < 0) ? -d : d));
+	    n1->l.number = ((i ^ d) < 0) ? -r : r;
+	} else {
+	    n1->l.number = ((Uint) i) / ((Uint) d);
+	}
+	return n1;
+    } else if (n1->type == N_FLOAT && n2->type == N_FLOAT) {
+	/* f / f */
+	if (NFLT_ISZERO(n2)) {
+	    /* f / 0.0 */
+	    c_error("division by zero");
+	    return n1;
+	}
+	NFLT_GET(n1, f1);
+	NFLT_GET(n2, f2);
+	flt_div(&f1, &f2);
+	NFLT_PUT(n1, f1);
+	return n1;
+    }
+
+    return bina(op, n1, n2, name);
+}
+
+/*
+ * NAME:	mod()
+ * DESCRIPTION:	handle the % %= operators
+ */
+static node *mod(int op, node *n1, node *n2, char *name)
+{
+    if (n1->type == N_INT && n2->type == N_INT) {
+	Int i, d;
+
+	/* i % i */
+	i = n1->l.number;
+	d = n2->l.number;
+	if (d == 0) {
+	    /* i % 0 */
+	    c_error("modulus by zero");
+	    return n1;
+	}
+	if (d < 0) {
+	    d = -d;
+	}
+	if (i < 0) {
+            n1->l.number = - (Int) (((Uint) -i) % ((Uint) d));
+	} else {
+	    n1->l.number = ((Uint) i) % ((Uint) d);
+	}
+	return n1;
+    }
+
+    return bini(op, n1, n2, name);
+}
+
+/*
+ * NAME:	add()
+ * DESCRIPTION:	handle the + += operators, possibly rearranging the order
+ *		of the expression
+ */
+static node *add(int op, node *n1, node *n2, char *name)
+{
+    char tnbuf1[TNBUFSIZE], tnbuf2[TNBUFSIZE];
+    xfloat f1, f2;
+    unsigned short type;
+
+    t_void(n1);
+    t_void(n2);
+
+    if (n1->mod == T_STRING) {
+	if (n2->mod == T_INT || n2->mod == T_FLOAT ||
+	    (n2->mod == T_MIXED && typechecking)) {
+	    n2 = cast(n2, node_type(T_STRING, (string *) NULL));
+	}
+    } else if (n2->mod == T_STRING && op == N_ADD) {
+	if (n1->mod == T_INT || n1->mod == T_FLOAT ||
+	    (n1->mod == T_MIXED && typechecking)) {
+	    n1 = cast(n1, node_type(T_STRING, (string *) NULL));
+	}
+    }
+
+    if (n1->type == N_INT && n2->type == N_INT) {
+	/* i + i */
+	n1->l.number += n2->l.number;
+	return n1;
+    }
+    if (n1->type == N_FLOAT && n2->type == N_FLOAT) {
+	/* f + f */
+	NFLT_GET(n1, f1);
+	NFLT_GET(n2, f2);
+	flt_add(&f1, &f2);
+	NFLT_PUT(n1, f1);
+	return n1;
+    }
+    if (n1->type == N_STR && n2->type == N_STR) {
+	/* s + s */
+	return node_str(str_add(n1->l.string, n2->l.string));
+    }
+
+    type = c_tmatch(n1->mod, n2->mod);
+    if (type == T_NIL || type == T_OBJECT || type == T_CLASS) {
+	type = T_MIXED;
+	if (typechecking) {
+	    c_error("bad argument types for %s (%s, %s)", name,
+		    i_typename(tnbuf1, n1->mod), i_typename(tnbuf2, n2->mod));
+	}
+    } else if (type == T_INT) {
+	op++;
+    } else if (op == N_ADD_EQ) {
+	if (n1->mod == T_INT) {
+	    n2 = node_mon(N_CAST, T_INT, n2);
+	    type = T_INT;
+	    op++;
+	} else if (n1->mod == T_FLOAT && n2->mod != T_FLOAT) {
+	    n2 = node_mon(N_CAST, T_FLOAT, n2);
+	    type = T_FLOAT;
+	}
+    }
+    return node_bin(op, type, n1, n2);
+}
+
+/*
+ * NAME:	sub()
+ * DESCRIPTION:	handle the - -= operators
+ */
+static node *sub(int op, node *n1, node *n2, char *name)
+{
+    char tnbuf1[TNBUFSIZE], tnbuf2[TNBUFSIZE];
+    xfloat f1, f2;
+    unsigned short type;
+
+    t_void(n1);
+    t_void(n2);
+
+    if (n1->type == N_INT && n2->type == N_INT) {
+	/* i - i */
+	n1->l.number -= n2->l.number;
+	return n1;
+    }
+    if (n1->type == N_FLOAT && n2->type == N_FLOAT) {
+	/* f - f */
+	NFLT_GET(n1, f1);
+	NFLT_GET(n2, f2);
+	flt_sub(&f1, &f2);
+	NFLT_PUT(n1, f1);
+	return n1;
+    }
+
+    type = c_tmatch(n1->mod, n2->mod);
+    if (type == T_NIL || type == T_STRING || type == T_OBJECT ||
+	type == T_CLASS || type == T_MAPPING) {
+	if ((type=n1->mod) != T_MAPPING ||
+	    (n2->mod != T_MIXED && (n2->mod & T_REF) == 0)) {
+	    type = T_MIXED;
+	    if (typechecking) {
+		c_error("bad argument types for %s (%s, %s)", name,
+			i_typename(tnbuf1, n1->mod),
+			i_typename(tnbuf2, n2->mod));
+	    }
+	}
+    } else if (type == T_INT) {
+	op++;
+    } else if (type == T_MIXED) {
+	type = (n1->mod == T_MIXED) ? n2->mod : n1->mod;
+    } else if (n1->mod == T_MIXED && (n2->mod & T_REF)) {
+	type = T_MIXED;
+    }
+    return node_bin(op, type, n1, n2);
+}
+
+/*
+ * NAME:	umin()
+ * DESCRIPTION:	handle unary minus
+ */
+static node *umin(node *n)
+{
+    xfloat flt;
+
+    if (t_unary(n, "unary -")) {
+	if (n->mod == T_FLOAT) {
+	    FLT_ZERO(flt.high, flt.low);
+	    n = sub(N_SUB, node_float(&flt), n, "-");
+	} else {
+	    n = sub(N_SUB, node_int((Int) 0), n, "-");
+	}
+    }
+    return n;
+}
+
+/*
+ * NAME:	lshift()
+ * DESCRIPTION:	handle the << <<= operators
+ */
+static node *lshift(int op, node *n1, node *n2, char *name)
+{
+    if (n2->type == N_INT) {
+	if (n2->l.number < 0) {
+	    c_error("negative left shift");
+	    n2->l.number = 0;
+	}
+	if (n1->type == N_INT) {
+	    /* i << i */
+	    n1->l.number = (n2->l.number < 32) ?
+			    (Uint) n1->l.number << n2->l.number : 0;
+	    return n1;
+	}
+    }
+
+    return bini(op, n1, n2, name);
+}
+
+/*
+ * NAME:	rshift()
+ * DESCRIPTION:	handle the >> >>= operators
+ */
+static node *rshift(int op, node *n1, node *n2, char *name)
+{
+    if (n2->type == N_INT) {
+	if (n2->l.number < 0) {
+	    c_error("negative right shift");
+	    n2->l.number = 0;
+	}
+	if (n1->type == N_INT) {
+	    /* i >> i */
+	    n1->l.number = (n2->l.number < 32) ?
+			    (Uint) n1->l.number >> n2->l.number : 0;
+	    return n1;
+	}
+    }
+
+    return bini(op, n1, n2, name);
+}
+
+/*
+ * NAME:	rel()
+ * DESCRIPTION:	handle the < > <= >= operators
+ */
+static node *rel(int op, node *n1, node *n2, char *name)
+{
+    char tnbuf1[TNBUFSIZE], tnbuf2[TNBUFSIZE];
+
+    t_void(n1);
+    t_void(n2);
+
+    if (n1->type == N_INT && n2->type == N_INT) {
+	/* i . i */
+	switch (op) {
+	case N_GE:
+	    n1->l.number = (n1->l.number >= n2->l.number);
+	    break;
+
+	case N_GT:
+	    n1->l.number = (n1->l.number > n2->l.number);
+	    break;
+
+	case N_LE:
+	    n1->l.number = (n1->l.number <= n2->l.number);
+	    break;
+
+	case N_LT:
+	    n1->l.number = (n1->l.number < n2->l.number);
+	    break;
+	}
+	return n1;
+    }
+    if (n1->type == N_FLOAT && n2->type == N_FLOAT) {
+	xfloat f1, f2;
+
+	/* f . f */
+	NFLT_GET(n1, f1);
+	NFLT_GET(n2, f2);
+
+	switch (op) {
+	case N_GE:
+	    return node_int((Int) (flt_cmp(&f1, &f2) >= 0));
+
+	case N_GT:
+	    return node_int((Int) (flt_cmp(&f1, &f2) > 0));
+
+	case N_LE:
+	    return node_int((Int) (flt_cmp(&f1, &f2) <= 0));
+
+	case N_LT:
+	    return node_int((Int) (flt_cmp(&f1, &f2) < 0));
+	}
+	return n1;
+    }
+    if (n1->type == N_STR && n2->type == N_STR) {
+	/* s . s */
+	switch (op) {
+	case N_GE:
+	    return node_int((Int) (str_cmp(n1->l.string, n2->l.string) >= 0));
+
+	case N_GT:
+	    return node_int((Int) (str_cmp(n1->l.string, n2->l.string) > 0));
+
+	case N_LE:
+	    return node_int((Int) (str_cmp(n1->l.string, n2->l.string) <= 0));
+
+	case N_LT:
+	    return node_int((Int) (str_cmp(n1->l.string, n2->l.string) < 0));
+	}
+    }
+
+    if (typechecking &&
+	((n1->mod != n2->mod && n1->mod != T_MIXED && n2->mod != T_MIXED) ||
+	 (!T_ARITHSTR(n1->mod) && n1->mod != T_MIXED) ||
+	 (!T_ARITHSTR(n2->mod) && n2->mod != T_MIXED))) {
+	c_error("bad argument types for %s (%s, %s)", name,
+		i_typename(tnbuf1, n1->mod), i_typename(tnbuf2, n2->mod));
+    } else if (n1->mod == T_INT && n2->mod == T_INT) {
+	op++;
+    }
+    return node_bin(op, T_INT, n1, n2);
+}
+
+/*
+ * NAME:	eq()
+ * DESCRIPTION:	handle the == operator
+ */
+static node *eq(node *n1, node *n2)
+{
+    char tnbuf1[TNBUFSIZE], tnbuf2[TNBUFSIZE];
+    xfloat f1, f2;
+    int op;
+
+    t_void(n1);
+    t_void(n2);
+
+    switch (n1->type) {
+    case N_INT:
+	if (n2->type == N_INT) {
+	    /* i == i */
+	    n1->l.number = (n1->l.number == n2->l.number);
+	    return n1;
+	}
+	if (nil_node == N_INT && n1->l.number == 0 && n2->type == N_STR) {
+	    /* nil == str */
+	    return node_int((Int) FALSE);
+	}
+	break;
+
+    case N_FLOAT:
+	if (n2->type == N_FLOAT) {
+	    /* f == f */
+	    NFLT_GET(n1, f1);
+	    NFLT_GET(n2, f2);
+	    return node_int((Int) (flt_cmp(&f1, &f2) == 0));
+	}
+	break;
+
+    case N_STR:
+	if (n2->type == N_STR) {
+	    /* s == s */
+	    return node_int((Int) (str_cmp(n1->l.string, n2->l.string) == 0));
+	}
+	if (n2->type == nil_node && n2->l.number == 0) {
+	    /* s == nil */
+	    return node_int((Int) FALSE);
+	}
+	break;
+
+    case N_NIL:
+	if (n2->type == N_NIL) {
+	    /* nil == nil */
+	    return node_int((Int) TRUE);
+	}
+	if (n2->type == N_STR) {
+	    /* nil == str */
+	    return node_int((Int) FALSE);
+	}
+	break;
+    }
+
+    op = N_EQ;
+    if (n1->mod != n2->mod && n1->mod != T_MIXED && n2->mod != T_MIXED &&
+	(!c_nil(n1) || !T_POINTER(n2->mod)) &&
+	(!c_nil(n2) || !T_POINTER(n1->mod))) {
+	if (typechecking) {
+	    c_error("incompatible types for equality (%s, %s)",
+		    i_typename(tnbuf1, n1->mod), i_typename(tnbuf2, n2->mod));
+	}
+    } else if (n1->mod == T_INT && n2->mod == T_INT) {
+	op++;
+    }
+    return node_bin(op, T_INT, n1, n2);
+}
+
+/*
+ * NAME:	and()
+ * DESCRIPTION:	handle the & &= operators
+ */
+static node *and(int op, node *n1, node *n2, char *name)
+{
+    unsigned short type;
+
+    if (n1->type == N_INT && n2->type == N_INT) {
+	/* i & i */
+	n1->l.number &= n2->l.number;
+	return n1;
+    }
+    if ((((type=n1->mod) == T_MIXED || type == T_MAPPING) &&
+	 ((n2->mod & T_REF) != 0 || n2->mod == T_MIXED)) ||
+	((type=c_tmatch(n1->mod, n2->mod)) & T_REF) != T_NIL) {
+	/*
+	 * possibly array & array or mapping & array
+	 */
+	return node_bin(op, type, n1, n2);
+    }
+    return bini(op, n1, n2, name);
+}
+
+/*
+ * NAME:	xor()
+ * DESCRIPTION:	handle the ^ ^= operators
+ */
+static node *xor(int op, node *n1, node *n2, char *name)
+{
+    unsigned short type;
+
+    if (n1->type == N_INT && n2->type == N_INT) {
+	/* i ^ i */
+	n1->l.number ^= n2->l.number;
+	return n1;
+    }
+    if (((type=n1->mod) == T_MIXED && n2->mod == T_MIXED) ||
+	((type=c_tmatch(n1->mod, n2->mod)) & T_REF) != T_NIL) {
+	/*
+	 * possibly array ^ array
+	 */
+	return node_bin(op, type, n1, n2);
+    }
+    return bini(op, n1, n2, name);
+}
+
+/*
+ * NAME:	or()
+ * DESCRIPTION:	handle the | |= operators
+ */
+static node *or(int op, node *n1, node *n2, char *name)
+{
+    unsigned short type;
+
+    if (n1->type == N_INT && n2->type == N_INT) {
+	/* i | i */
+	n1->l.number |= n2->l.number;
+	return n1;
+    }
+    if (((type=n1->mod) == T_MIXED && n2->mod == T_MIXED) ||
+	((type=c_tmatch(n1->mod, n2->mod)) & T_REF) != T_NIL) {
+	/*
+	 * possibly array | array
+	 */
+	return node_bin(op, type, n1, n2);
+    }
+    return bini(op, n1, n2, name);
+}
+
+/*
+ * NAME:	land()
+ * DESCRIPTION:	handle the && operator
+ */
+static node *land(node *n1, node *n2)
+{
+    t_void(n1);
+    t_void(n2);
+
+    if ((n1->flags & F_CONST) && (n2->flags & F_CONST)) {
+	n1 = c_tst(n1);
+	n2 = c_tst(n2);
+	n1->l.number &= n2->l.number;
+	return n1;
+    }
+
+    return node_bin(N_LAND, T_INT, n1, n2);
+}
+
+/*
+ * NAME:	lor()
+ * DESCRIPTION:	handle the || operator
+ */
+static node *lor(node *n1, node *n2)
+{
+    t_void(n1);
+    t_void(n2);
+
+    if ((n1->flags & F_CONST) && (n2->flags & F_CONST)) {
+	n1 = c_tst(n1);
+	n2 = c_tst(n2);
+	n1->l.number |= n2->l.number;
+	return n1;
+    }
+
+    return node_bin(N_LOR, T_INT, n1, n2);
+}
+
+/*
+ * NAME:	quest()
+ * DESCRIPTION:	handle the ? : operator
+ */
+static node *quest(node *n1, node *n2, node *n3)
+{
+    unsigned short type;
+
+    t_void(n1);
+
+    if ((n2->flags & F_CONST) && n3->type == n2->type) {
+	switch (n1->type) {
+	case N_INT:
+	    return (n1->l.number == 0) ? n3 : n2;
+
+	case N_FLOAT:
+	    return (NFLT_ISZERO(n1)) ? n3 : n2;
+
+	case N_STR:
+	    return n2;
+
+	case N_NIL:
+	    return n3;
+	}
+    }
+
+    type = T_MIXED;
+    if (c_nil(n2) && T_POINTER(n3->mod)) {
+	/*
+	 * expr ? nil : expr
+	 */
+	type = n3->mod;
+    } else if (c_nil(n3) && T_POINTER(n2->mod)) {
+	/*
+	 * expr ? expr : nil;
+	 */
+	type = n2->mod;
+    } else if (typechecking) {
+	/*
+	 * typechecked
+	 */
+	if (n2->mod == T_VOID || n3->mod == T_VOID) {
+	    /* result can never be used */
+	    type = T_VOID;
+	} else {
+	    type = c_tmatch(n2->mod, n3->mod);
+	    if (type == T_NIL) {
+		/* no typechecking here, just let the result be mixed */
+		type = T_MIXED;
+	    }
+	}
+    }
+
+    n1 = node_bin(N_QUEST, type, n1, node_bin(N_PAIR, 0, n2, n3));
+    if ((type & T_TYPE) == T_CLASS) {
+	if (n2->class == (string *) NULL) {
+	    n1->class = n3->class;
+	} else if (n3->class == (string *) NULL ||
+		   str_cmp(n2->class, n3->class) == 0) {
+	    n1->class = n2->class;
+	} else {
+	    /* downgrade to object */
+	    n1->type = (n1->type & T_REF) | T_OBJECT;
+	}
+    }
+    return n1;
+}
+
+/*
+ * NAME:	assign()
+ * DESCRIPTION:	handle the assignment operator
+ */
+static node *assign(node *n1, node *n2)
+{
+    char tnbuf1[TNBUFSIZE], tnbuf2[TNBUFSIZE];
+    node *n, *m;
+    unsigned short type;
+
+    if (n1->type == N_AGGR) {
+	/*
+	 * ({ a, b }) = array;
+	 */
+	if (typechecking) {
+	    type = n2->mod;
+	    if ((n2->mod & T_REF) != 0) {
+		type -= 1 << REFSHIFT;
+		if (type != T_MIXED) {
+		    n = node_mon(N_TYPE, type, (node *) NULL);
+		    n->class = n2->class;
+		    n1->r.right = n;
+		}
+	    } else if (type != T_MIXED) {
+		c_error("incompatible types for = (%s, %s)",
+			i_typename(tnbuf1, n1->mod),
+			i_typename(tnbuf2, type));
+		type = T_MIXED;
+	    }
+
+	    n = n1->l.left;
+	    while (n != (node *) NULL) {
+		if (n->type == N_PAIR) {
+		    m = n->l.left;
+		    n = n->r.right;
+		} else {
+		    m = n;
+		    n = (node *) NULL;
+		}
+		if (c_tmatch(m->mod, type) == T_NIL) {
+		    c_error("incompatible types for = (%s, %s)",
+			    i_typename(tnbuf1, m->mod),
+			    i_typename(tnbuf2, type));
+		}
+	    }
+	}
+	n1 = node_bin(N_ASSIGN, n2->mod, n1, n2);
+	n1->class = n2->class;
+	return n1;
+    } else {
+	if (typechecking && (!c_nil(n2) || !T_POINTER(n1->mod))) {
+	    /*
+	     * typechecked
+	     */
+	    if (c_tmatch(n1->mod, n2->mod) == T_NIL) {
+		c_error("incompatible types for = (%s, %s)",
+			i_typename(tnbuf1, n1->mod),
+			i_typename(tnbuf2, n2->mod));
+	    } else if ((n1->mod != T_MIXED && n2->mod == T_MIXED) ||
+		       (n1->mod == T_CLASS &&
+			(n2->mod != T_CLASS ||
+			 str_cmp(n1->class, n2->class) != 0))) {
+		n2 = node_mon(N_CAST, n1->mod, n2);
+		n2->class = n1->class;
+	    }
+	}
+
+	n2 = node_bin(N_ASSIGN, n1->mod, n1, n2);
+	n2->class = n1->class;
+	return n2;
+    }
+}
+
+/*
+ * NAME:	comma()
+ * DESCRIPTION:	handle the comma operator, rearranging the order of the
+ *		expression if needed
+ */
+static node *comma(node *n1, node *n2)
+{
+    if (n2->type == N_COMMA) {
+	/* a, (b, c) --> (a, b), c */
+	n2->l.left = comma(n1, n2->l.left);
+	return n2;
+    } else {
+	n1 = node_bin(N_COMMA, n2->mod, n1, n2);
+	n1->class = n2->class;
+	return n1;
+    }
+}
@@ -0,0 +1,218 @@
+/* A Bison parser, made by GNU Bison 3.8.2.  */
+
+/* Bison interface for Yacc-like parsers in C
+
+   Copyright (C) 1984, 1989-1990, 2000-2015, 2018-2021 Free Software Foundation,
+   Inc.
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>.  */
+
+/* As a special exception, you may create a larger work that contains
+   part or all of the Bison parser skeleton and distribute that work
+   under terms of your choice, so long as that work isn't itself a
+   parser generator using the skeleton or a modified version thereof
+   as a parser skeleton.  Alternatively, if you modify or redistribute
+   the parser skeleton itself, you may (at your option) remove this
+   special exception, which will cause the skeleton and the resulting
+   Bison output files to be licensed under the GNU General Public
+   License without this special exception.
+
+   This special exception was added by the Free Software Foundation in
+   version 2.2 of Bison.  */
+
+/* DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+   especially those whose name start with YY_ or yy_.  They are
+   private implementation details that can be changed or removed.  */
+
+#ifndef YY_YY_Y_TAB_H_INCLUDED
+# define YY_YY_Y_TAB_H_INCLUDED
+/* Debug traces.  */
+#ifndef YYDEBUG
+# define YYDEBUG 0
+#endif
+#if YYDEBUG
+extern int yydebug;
+#endif
+
+/* Token kinds.  */
+#ifndef YYTOKENTYPE
+# define YYTOKENTYPE
+  enum yytokentype
+  {
+    YYEMPTY = -2,
+    YYEOF = 0,                     /* "end of file"  */
+    YYerror = 256,                 /* error  */
+    YYUNDEF = 257,                 /* "invalid token"  */
+    NIL = 258,                     /* NIL  */
+    BREAK = 259,                   /* BREAK  */
+    DO = 260,                      /* DO  */
+    MAPPING = 261,                 /* MAPPING  */
+    ELSE = 262,                    /* ELSE  */
+    CASE = 263,                    /* CASE  */
+    OBJECT = 264,                  /* OBJECT  */
+    DEFAULT = 265,                 /* DEFAULT  */
+    STATIC = 266,                  /* STATIC  */
+    CONTINUE = 267,                /* CONTINUE  */
+    INT = 268,                     /* INT  */
+    FLOAT = 269,                   /* FLOAT  */
+    RLIMITS = 270,                 /* RLIMITS  */
+    FOR = 271,                     /* FOR  */
+    INHERIT = 272,                 /* INHERIT  */
+    IF = 273,                      /* IF  */
+    GOTO = 274,                    /* GOTO  */
+    RETURN = 275,                  /* RETURN  */
+    MIXED = 276,                   /* MIXED  */
+    STRING = 277,                  /* STRING  */
+    WHILE = 278,                   /* WHILE  */
+    FUNCTION = 279,                /* FUNCTION  */
+    CATCH = 280,                   /* CATCH  */
+    SWITCH = 281,                  /* SWITCH  */
+    VOID = 282,                    /* VOID  */
+    PRIVATE = 283,                 /* PRIVATE  */
+    ATOMIC = 284,                  /* ATOMIC  */
+    NOMASK = 285,                  /* NOMASK  */
+    VARARGS = 286,                 /* VARARGS  */
+    LARROW = 287,                  /* LARROW  */
+    RARROW = 288,                  /* RARROW  */
+    PLUS_PLUS = 289,               /* PLUS_PLUS  */
+    MIN_MIN = 290,                 /* MIN_MIN  */
+    LSHIFT = 291,                  /* LSHIFT  */
+    RSHIFT = 292,                  /* RSHIFT  */
+    LE = 293,                      /* LE  */
+    GE = 294,                      /* GE  */
+    EQ = 295,                      /* EQ  */
+    NE = 296,                      /* NE  */
+    LAND = 297,                    /* LAND  */
+    LOR = 298,                     /* LOR  */
+    PLUS_EQ = 299,                 /* PLUS_EQ  */
+    MIN_EQ = 300,                  /* MIN_EQ  */
+    MULT_EQ = 301,                 /* MULT_EQ  */
+    DIV_EQ = 302,                  /* DIV_EQ  */
+    MOD_EQ = 303,                  /* MOD_EQ  */
+    LSHIFT_EQ = 304,               /* LSHIFT_EQ  */
+    RSHIFT_EQ = 305,               /* RSHIFT_EQ  */
+    AND_EQ = 306,                  /* AND_EQ  */
+    XOR_EQ = 307,                  /* XOR_EQ  */
+    OR_EQ = 308,                   /* OR_EQ  */
+    COLON_COLON = 309,             /* COLON_COLON  */
+    DOT_DOT = 310,                 /* DOT_DOT  */
+    ELLIPSIS = 311,                /* ELLIPSIS  */
+    STRING_CONST = 312,            /* STRING_CONST  */
+    IDENTIFIER = 313,              /* IDENTIFIER  */
+    INT_CONST = 314,               /* INT_CONST  */
+    FLOAT_CONST = 315,             /* FLOAT_CONST  */
+    MARK = 316,                    /* MARK  */
+    HASH = 317,                    /* HASH  */
+    HASH_HASH = 318,               /* HASH_HASH  */
+    INCL_CONST = 319,              /* INCL_CONST  */
+    NR_TOKENS = 320                /* NR_TOKENS  */
+  };
+  typedef enum yytokentype yytoken_kind_t;
+#endif
+/* Token kinds.  */
+#define YYEMPTY -2
+#define YYEOF 0
+#define YYerror 256
+#define YYUNDEF 257
+#define NIL 258
+#define BREAK 259
+#define DO 260
+#define MAPPING 261
+#define ELSE 262
+#define CASE 263
+#define OBJECT 264
+#define DEFAULT 265
+#define STATIC 266
+#define CONTINUE 267
+#define INT 268
+#define FLOAT 269
+#define RLIMITS 270
+#define FOR 271
+#define INHERIT 272
+#define IF 273
+#define GOTO 274
+#define RETURN 275
+#define MIXED 276
+#define STRING 277
+#define WHILE 278
+#define FUNCTION 279
+#define CATCH 280
+#define SWITCH 281
+#define VOID 282
+#define PRIVATE 283
+#define ATOMIC 284
+#define NOMASK 285
+#define VARARGS 286
+#define LARROW 287
+#define RARROW 288
+#define PLUS_PLUS 289
+#define MIN_MIN 290
+#define LSHIFT 291
+#define RSHIFT 292
+#define LE 293
+#define GE 294
+#define EQ 295
+#define NE 296
+#define LAND 297
+#define LOR 298
+#define PLUS_EQ 299
+#define MIN_EQ 300
+#define MULT_EQ 301
+#define DIV_EQ 302
+#define MOD_EQ 303
+#define LSHIFT_EQ 304
+#define RSHIFT_EQ 305
+#define AND_EQ 306
+#define XOR_EQ 307
+#define OR_EQ 308
+#define COLON_COLON 309
+#define DOT_DOT 310
+#define ELLIPSIS 311
+#define STRING_CONST 312
+#define IDENTIFIER 313
+#define INT_CONST 314
+#define FLOAT_CONST 315
+#define MARK 316
+#define HASH 317
+#define HASH_HASH 318
+#define INCL_CONST 319
+#define NR_TOKENS 320
+
+/* Value type.  */
+#if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
+union YYSTYPE
+{
+#line 93 "parser.y"
+
+    Int number;			/* lex input */
+    xfloat real;		/* lex input */
+    unsigned short type;	/* internal */
+    struct _node_ *node;	/* internal */
+
+#line 204 "y.tab.h"
+
+};
+typedef union YYSTYPE YYSTYPE;
+# define YYSTYPE_IS_TRIVIAL 1
+# define YYSTYPE_IS_DECLARED 1
+#endif
+
+
+extern YYSTYPE yylval;
+
+
+int yyparse (void);
+
+
+#endif /* !YY_YY_Y_TAB_H_INCLUDED  */
@@ -56,71 +56,94 @@ typedef struct {
 static config conf[] = {
 # define ARRAY_SIZE	0
 				{ "array_size",		INT_CONST, FALSE, FALSE,
-							1, USHRT_MAX / 2 },
+							1, ASIZET_MAX / 2 },
 # define AUTO_OBJECT	1
 				{ "auto_object",	STRING_CONST, TRUE },
 # define BINARY_PORT	2
 				{ "binary_port",	'[', FALSE, FALSE,
 							1, USHRT_MAX },
-# define CACHE_SIZE	3
+# define CACHE_POLICY	3
+				{ "cache_policy",	INT_CONST, FALSE, FALSE,
+							0, 1 },
+# define CACHE_SIZE	4
 				{ "cache_size",		INT_CONST, FALSE, FALSE,
 							1, UINDEX_MAX },
-# define CALL_OUTS	4
+# define CALL_OUTS	5
 				{ "call_outs",		INT_CONST, FALSE, FALSE,
 							0, UINDEX_MAX - 1 },
-# define CREATE		5
+# define COMPRESSION	6
+				{ "compression",	INT_CONST, FALSE, FALSE,
+							0, 2 },
+# define CREATE		7
 				{ "create",		STRING_CONST },
-# define DIRECTORY	6
+# define DIRECTORY	8
 				{ "directory",		STRING_CONST },
-# define DRIVER_OBJECT	7
+# define DRIVER_OBJECT	9
 				{ "driver_object",	STRING_CONST, TRUE },
-# define DUMP_FILE	8
+# define DUMP_CHAIN	10
+				{ "dump_chain",		INT_CONST, FALSE, FALSE,
+							0, 15 },
+# define DUMP_FILE	11
 				{ "dump_file",		STRING_CONST },
-# define DUMP_INTERVAL	9
+# define DUMP_FORK	12
+				{ "dump_fork",		INT_CONST, FALSE, FALSE,
+							0, 1 },
+# define DUMP_INTERVAL	13
 				{ "dump_interval",	INT_CONST },
-# define DYNAMIC_CHUNK	10
+# define DYNAMIC_CHUNK	14
 				{ "dynamic_chunk",	INT_CONST, FALSE, FALSE,
 							1024 },
-# define ED_TMPFILE	11
+# define DYNAMIC_MMAP	15
+				{ "dynamic_mmap",	INT_CONST, FALSE, FALSE,
+							0, 2 },
+# define ED_TMPFILE	16
 				{ "ed_tmpfile",		STRING_CONST },
-# define EDITORS	12
+# define EDITORS	17
 				{ "editors",		INT_CONST, FALSE, FALSE,
 							0, EINDEX_MAX },
-# define INCLUDE_DIRS	13
+# define GC_SLICE	18
+				{ "gc_slice",		INT_CONST, FALSE, FALSE,
+							0, 1000 },
+# define INCLUDE_DIRS	19
 				{ "include_dirs",	'(' },
-# define INCLUDE_FILE	14
+# define INCLUDE_FILE	20
 				{ "include_file",	STRING_CONST, TRUE },
-# define MODULES	15
+# define MODULES	21
 				{ "modules",		'(' },
-# define OBJECTS	16
+# define OBJECTS	22
 				{ "objects",		INT_CONST, FALSE, FALSE,
 							2, UINDEX_MAX },
-# define PORTS		17 
+# define PORTS		23
 				{ "ports",		INT_CONST, FALSE, FALSE,
 							1, 32 },
-# define SECTOR_SIZE	18
+# define SECTOR_SIZE	24
 				{ "sector_size",	INT_CONST, FALSE, FALSE,
 							512, 65535 },
-# define STATIC_CHUNK	19
+# define STATIC_CHUNK	25
 				{ "static_chunk",	INT_CONST },
-# define SWAP_FILE	20
+# define SWAP_BUDGET	26
+				{ "swap_budget",	INT_CONST },
+# define SWAP_FILE	27
 				{ "swap_file",		STRING_CONST },
-# define SWAP_FRAGMENT	21
+# define SWAP_FRAGMENT	28
 				{ "swap_fragment",	INT_CONST, FALSE, FALSE,
 							0, SW_UNUSED },
-# define SWAP_SIZE	22
+# define SWAP_MMAP	29
+				{ "swap_mmap",		INT_CONST, FALSE, FALSE,
+							0, 1 },
+# define SWAP_SIZE	30
 				{ "swap_size",		INT_CONST, FALSE, FALSE,
 							1024, SW_UNUSED },
-# define TELNET_PORT	23
+# define TELNET_PORT	31
 				{ "telnet_port",	'[', FALSE, FALSE,
 							1, USHRT_MAX },
-# define TYPECHECKING	24
+# define TYPECHECKING	32
 				{ "typechecking",	INT_CONST, FALSE, FALSE,
 							0, 2 },
-# define USERS		25
+# define USERS		33
 				{ "users",		INT_CONST, FALSE, FALSE,
 							1, EINDEX_MAX },
-# define NR_OPTIONS	26
+# define NR_OPTIONS	34
 };
 
 
@@ -128,9 +151,10 @@ typedef struct { char fill; char c;	} alignc;
 typedef struct { char fill; short s;	} aligns;
 typedef struct { char fill; Int i;	} aligni;
 typedef struct { char fill; char *p;	} alignp;
+typedef struct { char fill; Uuint l;	} alignl;
 typedef struct { char c;		} alignz;
 
-# define FORMAT_VERSION	14
+# define FORMAT_VERSION	16
 
 # define DUMP_VALID	0	/* valid dump flag */
 # define DUMP_VERSION	1	/* dump file version number */
@@ -155,12 +179,12 @@ static dumpinfo header;		/* dumpfile header */
 # define utsize	(header[20])	/* sizeof(uindex) + sizeof(ssizet) */
 # define desize	(header[21])	/* sizeof(sector) + sizeof(eindex) */
 # define psize	(header[22])	/* sizeof(char*), upper nibble reserved */
-# define calign	(header[23])	/* align(char) */
+# define calign	(header[23])	/* align(char), sizeof(asizet) */
 # define salign	(header[24])	/* align(short) */
 # define ialign	(header[25])	/* align(Int) */
 # define palign	(header[26])	/* align(char*) */
 # define zalign	(header[27])	/* align(struct) */
-# define zero1	(header[36])	/* reserved (0) */
+# define lalign	(header[36])	/* align(Uuint) */
 # define zero2	(header[37])	/* reserved (0) */
 # define zero3	(header[38])	/* reserved (0) */
 # define zero4	(header[39])	/* reserved (0) */
@@ -170,6 +194,7 @@ static int ualign;		/* align(uindex) */
 static int talign;		/* align(ssizet) */
 static int dalign;		/* align(sector) */
 static int ealign;		/* align(eindex) */
+static int aalign;		/* align(asizet) */
 static dumpinfo rheader;	/* restored header */
 # define rs0	(rheader[ 6])	/* short, msb */
 # define rs1	(rheader[ 7])	/* short, lsb */
@@ -180,12 +205,12 @@ static dumpinfo rheader;	/* restored header */
 # define rutsize (rheader[20])	/* sizeof(uindex) + sizeof(ssizet) */
 # define rdesize (rheader[21])	/* sizeof(sector) + sizeof(eindex) */
 # define rpsize	(rheader[22])	/* sizeof(char*), upper nibble reserved */
-# define rcalign (rheader[23])	/* align(char) */
+# define rcalign (rheader[23])	/* align(char), sizeof(asizet) */
 # define rsalign (rheader[24])	/* align(short) */
 # define rialign (rheader[25])	/* align(Int) */
 # define rpalign (rheader[26])	/* align(char*) */
 # define rzalign (rheader[27])	/* align(struct) */
-# define rzero1	 (rheader[36])	/* reserved (0) */
+# define rlalign (rheader[36])	/* align(Uuint) */
 # define rzero2	 (rheader[37])	/* reserved (0) */
 # define rzero3	 (rheader[38])	/* reserved (0) */
 # define rzero4	 (rheader[39])	/* reserved (0) */
@@ -195,13 +220,16 @@ static int rusize;		/* sizeof(uindex) */
 static int rtsize;		/* sizeof(ssizet) */
 static int rdsize;		/* sizeof(sector) */
 static int resize;		/* sizeof(eindex) */
+static int rasize;		/* sizeof(asizet) */
 static int rualign;		/* align(uindex) */
 static int rtalign;		/* align(ssizet) */
 static int rdalign;		/* align(sector) */
 static int realign;		/* align(eindex) */
+static int raalign;		/* align(asizet) */
 static Uint starttime;		/* start time */
 static Uint elapsed;		/* elapsed time */
 static Uint boottime;		/* boot time */
+static int dumpchild;		/* process writing a snapshot */
 
 /*
  * NAME:	conf->dumpinit()
@@ -215,6 +243,7 @@ static void conf_dumpinit()
     aligns sdummy;
     aligni idummy;
     alignp pdummy;
+    alignl ldummy;
 
     header[DUMP_VALID] = TRUE;			/* valid dump flag */
     header[DUMP_VERSION] = FORMAT_VERSION;	/* dump file version number */
@@ -242,7 +271,8 @@ static void conf_dumpinit()
     ialign = (char *) &idummy.i - (char *) &idummy.fill;
     palign = (char *) &pdummy.p - (char *) &pdummy.fill;
     zalign = sizeof(alignz);
-    zero1 = zero2 = 0;
+    lalign = (char *) &ldummy.l - (char *) &ldummy.fill;
+    zero2 = 0;
 
     ualign = (sizeof(uindex) == sizeof(short)) ? salign : ialign;
     talign = (sizeof(ssizet) == sizeof(short)) ? salign : ialign;
@@ -252,17 +282,25 @@ static void conf_dumpinit()
     case sizeof(short):	ealign = salign; break;
     case sizeof(Int):	ealign = ialign; break;
     }
+    aalign = (sizeof(asizet) == sizeof(short)) ? salign : ialign;
+    if (sizeof(asizet) != sizeof(short)) {
+	calign |= sizeof(asizet) << 4;
+    }
 }
 
 /*
  * NAME:	conf->dump()
- * DESCRIPTION:	dump system state on file
+ * DESCRIPTION:	dump system state on file.  With dump_fork, the state is
+ *		flushed to the swap file, and a child process writes the
+ *		rest of the snapshot while the driver carries on
  */
 void conf_dump()
 {
     int fd;
     Uint etime;
 
+    conf_dumped(TRUE);
+
     header[DUMP_TYPECHECK] = conf[TYPECHECKING].u.num;
     header[DUMP_STARTTIME + 0] = starttime >> 24;
     header[DUMP_STARTTIME + 1] = starttime >> 16;
@@ -280,7 +318,14 @@ void conf_dump()
 
     o_copy(0);
     d_swapout(1);
-    fd = sw_dump(conf[DUMP_FILE].u.str);
+    fd = sw_dump(conf[DUMP_FILE].u.str, (bool) conf[DUMP_FORK].u.num);
+    if (conf[DUMP_FORK].u.num) {
+	dumpchild = P_fork();
+	if (dumpchild > 0) {
+	    return;
+	}
+	fd = sw_dumpfd();
+    }
     if (!kf_dump(fd)) {
 	fatal("failed to dump kfun table");
     }
@@ -296,6 +341,41 @@ void conf_dump()
 
     P_lseek(fd, 0L, SEEK_SET);
     (void) P_write(fd, header, sizeof(dumpinfo));
+
+    if (conf[DUMP_FORK].u.num) {
+	if (dumpchild == 0) {
+	    P_exitchild(0);
+	}
+
+	/* could not fork */
+	P_close(fd);
+	dumpchild = 0;
+	sw_dumped(TRUE);
+    }
+}
+
+/*
+ * NAME:	conf->dumped()
+ * DESCRIPTION:	check if the snapshot being written by a child process is
+ *		done, waiting for it if wait is TRUE.  Return TRUE if no
+ *		snapshot is being written anymore
+ */
+bool conf_dumped(bool wait)
+{
+    int status;
+
+    if (dumpchild > 0) {
+	status = P_reap(dumpchild, wait);
+	if (status == 0) {
+	    return FALSE;
+	}
+	if (status < 0) {
+	    message("Failed to write snapshot\012");	/* LF */
+	}
+	dumpchild = 0;
+	sw_dumped(status > 0);
+    }
+    return TRUE;
 }
 
 /*
@@ -305,7 +385,7 @@ void conf_dump()
 static void conf_restore(int fd)
 {
     bool conv_co1, conv_co2, conv_co3, conv_lwo, conv_ctrl1, conv_ctrl2,
-    conv_data, conv_type, conv_inherit, conv_time, conv_vm;
+    conv_data, conv_type, conv_inherit, conv_time, conv_vm, conv_chain;
     unsigned int secsize;
 
     if (P_read(fd, rheader, DUMP_HEADERSZ) != DUMP_HEADERSZ ||
@@ -315,7 +395,7 @@ static void conf_restore(int fd)
     }
     conv_co1 = conv_co2 = conv_co3 = conv_lwo = conv_ctrl1 = conv_ctrl2 =
 	       conv_data = conv_type = conv_inherit = conv_time = conv_vm =
-	       FALSE;
+	       conv_chain = FALSE;
     if (rheader[DUMP_VERSION] < 3) {
 	conv_co1 = TRUE;
     }
@@ -327,7 +407,7 @@ static void conf_restore(int fd)
     }
     if (rheader[DUMP_VERSION] < 6) {
 	conv_data = TRUE;
-	rzero1 = rzero2 = 0;
+	rlalign = rzero2 = 0;
     }
     if (rheader[DUMP_VERSION] < 7) {
 	conv_co2 = TRUE;
@@ -354,8 +434,14 @@ static void conf_restore(int fd)
     if (rheader[DUMP_VERSION] < 14) {
 	conv_vm = TRUE;
     }
+    if (rheader[DUMP_VERSION] < 15) {
+	conv_chain = TRUE;
+    }
+    if (rheader[DUMP_VERSION] < 16) {
+	rlalign = 0;		/* no hash in hte */
+    }
     rheader[DUMP_VERSION] = FORMAT_VERSION;
-    if (memcmp(header, rheader, DUMP_TYPE) != 0 || rzero1 != 0 || rzero2 != 0 ||
+    if (memcmp(header, rheader, DUMP_TYPE) != 0 || rzero2 != 0 ||
 	rzero3 != 0 || rzero4 != 0 || rzero5 != 0 || rzero6 != 0) {
 	error("Bad or incompatible restore file header");
     }
@@ -378,9 +464,11 @@ static void conf_restore(int fd)
     if (resize == 0) {
 	resize = sizeof(char);			/* backward compat */
     }
-    if ((rcalign >> 4) != 0) {
-	error("Cannot restore arrsize > 2");
+    rasize = UCHAR(rcalign) >> 4;
+    if (rasize == 0) {
+	rasize = sizeof(unsigned short);	/* backward compat */
     }
+    rcalign &= 0xf;
     if ((rsalign >> 4) != 0) {
 	error("Cannot restore Int size > 4");
     }
@@ -388,14 +476,15 @@ static void conf_restore(int fd)
     rualign = (rusize == sizeof(short)) ? rsalign : rialign;
     rtalign = (rtsize == sizeof(short)) ? rsalign : rialign;
     rdalign = (rdsize == sizeof(short)) ? rsalign : rialign;
+    raalign = (rasize == sizeof(short)) ? rsalign : rialign;
     switch (resize) {
     case sizeof(char):	realign = rcalign; break;
     case sizeof(short):	realign = rsalign; break;
     case sizeof(Int):	realign = rialign; break;
     }
     if (sizeof(uindex) < rusize || sizeof(ssizet) < rtsize ||
-	sizeof(sector) < rdsize) {
-	error("Cannot restore uindex, ssizet or sector of greater width");
+	sizeof(sector) < rdsize || sizeof(asizet) < rasize) {
+	error("Cannot restore uindex, ssizet, sector or asizet of greater width");
     }
     secsize = (UCHAR(rheader[DUMP_SECSIZE + 0]) << 8) |
 	       UCHAR(rheader[DUMP_SECSIZE + 1]);
@@ -404,7 +493,7 @@ static void conf_restore(int fd)
     }
     rpsize &= 0xf;
 
-    sw_restore(fd, secsize);
+    sw_restore(fd, secsize, conv_chain);
     kf_restore(fd, conv_co1);
     o_restore(fd, (uindex) ((conv_lwo) ? 1 << (rusize * 8 - 1) : 0));
     d_init_conv(conv_ctrl1, conv_ctrl2, conv_data, conv_co1, conv_co2,
@@ -437,7 +526,7 @@ Uint conf_dsize(char *layout)
 	switch (*p++) {
 	case 'c':	/* character */
 	    sz = rsz = sizeof(char);
-	    al = calign;
+	    al = calign & 0xf;
 	    ral = rcalign;
 	    break;
 
@@ -467,6 +556,13 @@ Uint conf_dsize(char *layout)
 	    ral = rtalign;
 	    break;
 
+	case 'a':	/* asizet */
+	    sz = sizeof(asizet);
+	    rsz = rasize;
+	    al = aalign;
+	    ral = raalign;
+	    break;
+
 	case 'd':	/* sector */
 	    sz = sizeof(sector);
 	    rsz = rdsize;
@@ -494,14 +590,22 @@ Uint conf_dsize(char *layout)
 	    size += sizeof(char*);
 	    size = ALGN(size, palign);
 	    size += sizeof(char*);
+	    size = ALGN(size, lalign);
+	    size += sizeof(Uuint);
 	    size = ALGN(size, zalign);
 	    rsize = ALGN(rsize, rzalign);
 	    rsize = ALGN(rsize, rpalign);
 	    rsize += rpsize;
 	    rsize = ALGN(rsize, rpalign);
 	    rsize += rpsize;
+	    if (rlalign != 0) {
+		rsize = ALGN(rsize, rlalign);
+		rsize += sizeof(Uuint);
+		ralign = ALGN(ralign, rlalign);
+	    }
 	    rsize = ALGN(rsize, rzalign);
 	    align = ALGN(align, palign);
+	    align = ALGN(align, lalign);
 	    ralign = ALGN(ralign, rpalign);
 	    continue;
 
@@ -551,7 +655,7 @@ Uint conf_dconv(char *buf, char *rbuf, char *layout, Uint n)
 	for (p = layout; *p != '\0' && *p != ']'; p++) {
 	    switch (*p) {
 	    case 'c':
-		i = ALGN(i, calign);
+		i = ALGN(i, calign & 0xf);
 		ri = ALGN(ri, rcalign);
 		buf[i] = rbuf[ri];
 		i += sizeof(char);
@@ -626,6 +730,29 @@ Uint conf_dconv(char *buf, char *rbuf, char *layout, Uint n)
 		ri += rtsize;
 		break;
 
+	    case 'a':
+		i = ALGN(i, aalign);
+		ri = ALGN(ri, raalign);
+		if (sizeof(asizet) == rasize) {
+		    if (sizeof(asizet) == sizeof(short)) {
+			buf[i + s0] = rbuf[ri + rs0];
+			buf[i + s1] = rbuf[ri + rs1];
+		    } else {
+			buf[i + i0] = rbuf[ri + ri0];
+			buf[i + i1] = rbuf[ri + ri1];
+			buf[i + i2] = rbuf[ri + ri2];
+			buf[i + i3] = rbuf[ri + ri3];
+		    }
+		} else {
+		    buf[i + i0] = 0;
+		    buf[i + i1] = 0;
+		    buf[i + i2] = rbuf[ri + rs0];
+		    buf[i + i3] = rbuf[ri + rs1];
+		}
+		i += sizeof(asizet);
+		ri += rasize;
+		break;
+
 	    case 'd':
 		i = ALGN(i, dalign);
 		ri = ALGN(ri, rdalign);
@@ -699,6 +826,14 @@ Uint conf_dconv(char *buf, char *rbuf, char *layout, Uint n)
 		    ri++;
 		}
 		ri += j;
+		i = ALGN(i, lalign);
+		for (j = sizeof(Uuint); j > 0; --j) {
+		    buf[i++] = 0;
+		}
+		if (rlalign != 0) {
+		    ri = ALGN(ri, rlalign);
+		    ri += sizeof(Uuint);
+		}
 		i = ALGN(i, zalign);
 		ri = ALGN(ri, rzalign);
 		break;
@@ -972,6 +1107,48 @@ static bool conf_config()
 	if (!conf[l].set && l != MODULES) {
 	    char buffer[64];
 
+	    switch (l) {
+	    case CACHE_POLICY:
+		/* optional, use LRU */
+		conf[l].u.num = 0;
+		continue;
+
+	    case COMPRESSION:
+		/* optional, predictor compression */
+		conf[l].u.num = CMP_PRED;
+		continue;
+
+	    case DUMP_CHAIN:
+		/* optional, full snapshots only */
+		conf[l].u.num = 0;
+		continue;
+
+	    case DUMP_FORK:
+		/* optional, dump in foreground */
+		conf[l].u.num = 0;
+		continue;
+
+	    case DYNAMIC_MMAP:
+		/* optional, use malloc */
+		conf[l].u.num = 0;
+		continue;
+
+	    case GC_SLICE:
+		/* optional, no idle garbage collection */
+		conf[l].u.num = 0;
+		continue;
+
+	    case SWAP_BUDGET:
+		/* optional, swap out by fragment only */
+		conf[l].u.num = 0;
+		continue;
+
+	    case SWAP_MMAP:
+		/* optional, use swap cache */
+		conf[l].u.num = 0;
+		continue;
+	    }
+
 #ifndef NETWORK_EXTENSIONS
             /* don't complain about the ports option not being
                specified if the network extensions are disabled */
@@ -1096,6 +1273,16 @@ static bool conf_includes()
     cputs("# define ST_PRECOMPILED\t24\t/* precompiled objects */\012");
     cputs("# define ST_TELNETPORTS\t25\t/* telnet ports */\012");
     cputs("# define ST_BINARYPORTS\t26\t/* binary ports */\012");
+    cputs("# define ST_CACHEHITS\t27\t/* swap cache hits */\012");
+    cputs("# define ST_CACHEMISSES\t28\t/* swap cache misses */\012");
+    cputs("# define ST_CACHEEVICTS\t29\t/* swap cache evictions */\012");
+    cputs("# define ST_DATASWAPOUTS\t30\t/* # dataspaces swapped out */\012");
+    cputs("# define ST_CTRLSWAPOUTS\t31\t/* # control blocks swapped out */\012");
+    cputs("# define ST_SWAPOUTMEM\t32\t/* memory freed by swapping out */\012");
+    cputs("# define ST_GCDATA\t33\t/* # dataspaces garbage collected */\012");
+    cputs("# define ST_GCCYCLES\t34\t/* # garbage collection cycles */\012");
+    cputs("# define ST_GCPENDING\t35\t/* # dataspaces left in this cycle */\012");
+    cputs("# define ST_OTABMAX\t36\t/* max object table size */\012");
 
     cputs("\012# define O_COMPILETIME\t0\t/* time of compilation */\012");
     cputs("# define O_PROGSIZE\t1\t/* program size of object */\012");
@@ -1106,6 +1293,10 @@ static bool conf_includes()
     cputs("# define O_UNDEFINED\t6\t/* undefined functions */\012");
     cputs("# define O_INHERITED\t7\t/* object inherited? */\012");
     cputs("# define O_INSTANTIATED\t8\t/* object instantiated? */\012");
+    cputs("# define O_STRINGMEM\t9\t/* memory used by strings */\012");
+    cputs("# define O_ARRAYMEM\t10\t/* memory used by arrays */\012");
+    cputs("# define O_MAPHASHMEM\t11\t/* memory used by mapping hash tables */\012");
+    cputs("# define O_CALLOUTMEM\t12\t/* memory used by callouts */\012");
 
     cputs("\012# define CO_HANDLE\t0\t/* callout handle */\012");
     cputs("# define CO_FUNCTION\t1\t/* function name */\012");
@@ -1369,7 +1560,10 @@ bool conf_init(char *configfile, char *dumpfile, char *module, sector *fragment)
     if (!sw_init(conf[SWAP_FILE].u.str,
 	    (sector) conf[SWAP_SIZE].u.num,
 	    (sector) conf[CACHE_SIZE].u.num,
-	    (unsigned int) conf[SECTOR_SIZE].u.num)) {
+	    (unsigned int) conf[SECTOR_SIZE].u.num,
+	    (int) conf[CACHE_POLICY].u.num,
+	    (bool) conf[SWAP_MMAP].u.num,
+	    (unsigned int) conf[DUMP_CHAIN].u.num)) {
 	comm_finish();
 	if (dumpfile != (char *) NULL) {
 	    P_close(fd);
@@ -1379,7 +1573,8 @@ bool conf_init(char *configfile, char *dumpfile, char *module, sector *fragment)
     }
 
     /* initialize swapped data handler */
-    d_init();
+    d_init(conf[COMPRESSION].u.num, (Uint) conf[SWAP_BUDGET].u.num,
+	   (unsigned int) conf[GC_SLICE].u.num);
     *fragment = conf[SWAP_FRAGMENT].u.num;
 
     /* initalize editor */
@@ -1411,7 +1606,8 @@ bool conf_init(char *configfile, char *dumpfile, char *module, sector *fragment)
 
     /* initialize memory manager */
     m_init((size_t) conf[STATIC_CHUNK].u.num,
-    	   (size_t) conf[DYNAMIC_CHUNK].u.num);
+    	   (size_t) conf[DYNAMIC_CHUNK].u.num,
+	   (int) conf[DYNAMIC_MMAP].u.num);
 
     /*
      * create include files
@@ -1520,7 +1716,7 @@ int conf_typechecking()
  * NAME:	config->array_size()
  * DESCRIPTION:	return the maximum array size
  */
-unsigned short conf_array_size()
+asizet conf_array_size()
 {
     return conf[ARRAY_SIZE].u.num;
 }
@@ -1553,7 +1749,7 @@ bool conf_statusi(frame *f, Int idx, value *v)
     char *version;
     uindex ncoshort, ncolong;
     array *a;
-    Uint t;
+    Uint t, stat[3];
     int i;
 
     switch (idx) {
@@ -1615,7 +1811,7 @@ bool conf_statusi(frame *f, Int idx, value *v)
 	break;
 
     case 13:	/* ST_OTABSIZE */
-	PUT_INTVAL(v, conf[OBJECTS].u.num);
+	PUT_INTVAL(v, o_tabsize());
 	break;
 
     case 14:	/* ST_NOBJECTS */
@@ -1685,6 +1881,39 @@ bool conf_statusi(frame *f, Int idx, value *v)
 	}
 	break;
 
+    case 27:	/* ST_CACHEHITS */
+    case 28:	/* ST_CACHEMISSES */
+    case 29:	/* ST_CACHEEVICTS */
+	sw_cachestat(stat);
+	PUT_INTVAL(v, stat[idx - 27]);
+	break;
+
+    case 30:	/* ST_DATASWAPOUTS */
+    case 31:	/* ST_CTRLSWAPOUTS */
+    case 32:	/* ST_SWAPOUTMEM */
+	{
+	    size_t swapstat[3];
+
+	    d_swapstat(swapstat);
+	    putval(v, swapstat[idx - 30]);
+	}
+	break;
+
+    case 33:	/* ST_GCDATA */
+    case 34:	/* ST_GCCYCLES */
+    case 35:	/* ST_GCPENDING */
+	{
+	    size_t gcstat[3];
+
+	    d_gcstat(gcstat);
+	    putval(v, gcstat[idx - 33]);
+	}
+	break;
+
+    case 36:	/* ST_OTABMAX */
+	PUT_INTVAL(v, UINDEX_MAX);	/* the object table grows on demand */
+	break;
+
     default:
 	return FALSE;
     }
@@ -1707,8 +1936,8 @@ array *conf_status(frame *f)
 	arr_del(a);
 	error((char *) NULL);
     }
-    a = arr_ext_new(f->data, 27L);
-    for (i = 0, v = a->elts; i < 27; i++, v++) {
+    a = arr_ext_new(f->data, 37L);
+    for (i = 0, v = a->elts; i < 37; i++, v++) {
 	conf_statusi(f, i, v);
     }
     ec_pop();
@@ -1784,6 +2013,26 @@ bool conf_objecti(dataspace *data, object *obj, Int idx, value *v)
 	PUT_INTVAL(v, O_HASDATA(obj));
 	break;
 
+    case 9:	/* O_STRINGMEM */
+    case 10:	/* O_ARRAYMEM */
+    case 11:	/* O_MAPHASHMEM */
+    case 12:	/* O_CALLOUTMEM */
+	if (obj->data != (dataspace *) NULL) {
+	    Uint mem[4];
+
+	    d_memory(obj->data, mem);
+	    PUT_INTVAL(v, mem[idx - 9]);
+	} else if (O_HASDATA(obj)) {
+	    Uint mem[4];
+
+	    /* don't swap in the dataspace just to report its size */
+	    d_swapped_memory(obj, mem);
+	    PUT_INTVAL(v, mem[idx - 9]);
+	} else {
+	    PUT_INTVAL(v, 0);
+	}
+	break;
+
     default:
 	return FALSE;
     }
@@ -1801,13 +2050,13 @@ array *conf_object(dataspace *data, object *obj)
     Int i;
     array *a;
 
-    a = arr_ext_new(data, 9L);
+    a = arr_ext_new(data, 13L);
     if (ec_push((ec_ftn) NULL)) {
 	arr_ref(a);
 	arr_del(a);
 	error((char *) NULL);
     }
-    for (i = 0, v = a->elts; i < 9; i++, v++) {
+    for (i = 0, v = a->elts; i < 13; i++, v++) {
 	conf_objecti(data, obj, i, v);
     }
     ec_pop();
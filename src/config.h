@@ -24,9 +24,25 @@ typedef unsigned short uindex;
 typedef uindex sector;
 # define SW_UNUSED	UINDEX_MAX
 
-/* sizeof(ssizet) <= sizeof(uindex) */
-typedef unsigned short ssizet;
+/* string length: define SSIZET_MAX > USHRT_MAX for 32 bit lengths */
+# ifndef SSIZET_MAX
 # define SSIZET_MAX	USHRT_MAX
+# endif
+# if SSIZET_MAX > USHRT_MAX
+typedef unsigned int ssizet;
+# else
+typedef unsigned short ssizet;
+# endif
+
+/* array size: define ASIZET_MAX > USHRT_MAX for 32 bit sizes */
+# ifndef ASIZET_MAX
+# define ASIZET_MAX	USHRT_MAX
+# endif
+# if ASIZET_MAX > USHRT_MAX
+typedef unsigned int asizet;
+# else
+typedef unsigned short asizet;
+# endif
 
 /* eindex can be anything */
 typedef unsigned char eindex;
@@ -45,11 +61,14 @@ typedef unsigned char eindex;
 # define STRMAPHASHSZ	20	/* # characters to hash of map string indices */
 # define STRMERGETABSZ	1024	/* general string merge table size */
 # define STRMERGEHASHSZ	20	/* # characters in merge strings to hash */
+# define STRAPPENDSTEP	16	/* min. granularity of in-place string appends */
 # define ARRMERGETABSZ	1024	/* general array merge table size */
 # define OBJHASHSZ	256	/* # characters in object names to hash */
 # define COPATCHHTABSZ	64	/* callout patch hash table size */
 # define OBJPATCHHTABSZ	128	/* object patch hash table size */
 # define CMPLIMIT	2048	/* compress strings if >= CMPLIMIT */
+# define DSLIMIT	16384	/* save incrementally if dataspace >= DSLIMIT */
+# define SWAPWINDOW	32	/* # swapout candidates considered */
 # define SWAPCHUNKSZ	10	/* # objects reconstructed in main loop */
 
 /* comm */
@@ -94,9 +113,10 @@ extern bool		conf_init	(char*, char*, char*, sector*);
 extern char	       *conf_base_dir	(void);
 extern char	       *conf_driver	(void);
 extern int		conf_typechecking (void);
-extern unsigned short	conf_array_size	(void);
+extern asizet		conf_array_size	(void);
 
 extern void   conf_dump		(void);
+extern bool   conf_dumped	(bool);
 extern Uint   conf_dsize	(char*);
 extern Uint   conf_dconv	(char*, char*, char*, Uint);
 extern void   conf_dread	(int, char*, char*, Uint);
@@ -65,6 +65,14 @@ typedef struct {
     Uint narr;				/* # of arrays */
 } arrimport;
 
+# define STRMEM(str)	((long) (sizeof(string) + (str)->len))
+/*
+ * Arrays and mappings may change size in place, so a referenced array is
+ * charged a fixed amount; its elements are counted when the dataspace is
+ * saved.
+ */
+# define ARRMEM		((long) sizeof(array))
+
 static dataplane *plist;		/* list of dataplanes */
 static uindex ncallout;			/* # callouts added */
 static dataspace *ifirst;		/* list of dataspaces with imports */
@@ -89,6 +97,7 @@ static void ref_rhs(dataspace *data, value *rhs)
 	} else {
 	    /* not in this object: ref imported string */
 	    data->plane->schange++;
+	    data->plane->strmem += STRMEM(str);
 	}
 	break;
 
@@ -105,6 +114,7 @@ static void ref_rhs(dataspace *data, value *rhs)
 	    } else {
 		/* ref new array */
 		data->plane->achange++;
+		data->plane->arrmem += ARRMEM;
 	    }
 	} else {
 	    /* not in this object: ref imported array */
@@ -119,6 +129,7 @@ static void ref_rhs(dataspace *data, value *rhs)
 		ifirst = data;
 	    }
 	    data->plane->achange++;
+	    data->plane->arrmem += ARRMEM;
 	}
 	break;
     }
@@ -139,6 +150,7 @@ static void del_lhs(dataspace *data, value *lhs)
 	if (str->primary != (strref *) NULL && str->primary->data == data) {
 	    /* in this object */
 	    if (--(str->primary->ref) == 0) {
+		data->plane->strmem -= STRMEM(str);
 		str->primary->str = (string *) NULL;
 		str->primary = (strref *) NULL;
 		str_del(str);
@@ -148,6 +160,7 @@ static void del_lhs(dataspace *data, value *lhs)
 	} else {
 	    /* not in this object: deref imported string */
 	    data->plane->schange--;
+	    data->plane->strmem -= STRMEM(str);
 	}
 	break;
 
@@ -161,7 +174,10 @@ static void del_lhs(dataspace *data, value *lhs)
 		/* swapped in */
 		data->plane->flags |= MOD_ARRAYREF;
 		if ((--(arr->primary->ref) & ~ARR_MOD) == 0) {
-		    d_get_elts(arr);
+		    data->plane->arrmem -= ARRMEM;
+		    if (d_get_packed(arr) == (char *) NULL) {
+			d_get_elts(arr);
+		    }
 		    arr->primary->arr = (array *) NULL;
 		    arr->primary = &arr->primary->plane->alocal;
 		    arr_del(arr);
@@ -170,11 +186,13 @@ static void del_lhs(dataspace *data, value *lhs)
 	    } else {
 		/* deref new array */
 		data->plane->achange--;
+		data->plane->arrmem -= ARRMEM;
 	    }
 	} else {
 	    /* not in this object: deref imported array */
 	    data->plane->imports--;
 	    data->plane->achange--;
+	    data->plane->arrmem -= ARRMEM;
 	}
 	break;
     }
@@ -500,6 +518,8 @@ void d_new_plane(dataspace *data, Int level)
     p->schange = data->plane->schange;
     p->achange = data->plane->achange;
     p->imports = data->plane->imports;
+    p->strmem = data->plane->strmem;
+    p->arrmem = data->plane->arrmem;
 
     /* copy value information from previous plane */
     p->original = (value *) NULL;
@@ -567,7 +587,9 @@ static void commit_values(value *v, unsigned int n, Int level)
 		    map_compact(arr->primary->data, arr);
 		}
 		arr->primary = &arr->primary->plane->prev->alocal;
-		commit_values(arr->elts, arr->size, level);
+		if (arr->elts != (value *) NULL) {
+		    commit_values(arr->elts, arr->size, level);
+		}
 	    }
 
 	}
@@ -827,6 +849,8 @@ void d_commit_plane(Int level, value *retval)
 	p->prev->schange = p->schange;
 	p->prev->achange = p->achange;
 	p->prev->imports = p->imports;
+	p->prev->strmem = p->strmem;
+	p->prev->arrmem = p->arrmem;
 	p->alocal.data->plane = p->prev;
 	plist = p->plist;
 	FREE(p);
@@ -973,12 +997,25 @@ abchunk **d_commit_arr(array *arr, dataplane *prev, dataplane *old)
 	} else {
 	    arr->primary->plane = prev;
 	}
-	commit_values(arr->elts, arr->size, prev->level);
+	if (arr->elts != (value *) NULL) {
+	    commit_values(arr->elts, arr->size, prev->level);
+	}
     }
 
     return (prev == old) ? (abchunk **) NULL : &prev->achunk;
 }
 
+/*
+ * NAME:	data->commit_elt()
+ * DESCRIPTION:	commit array element to previous plane
+ */
+abchunk **d_commit_elt(value *elt, dataplane *prev, dataplane *old)
+{
+    commit_values(elt, 1, prev->level);
+
+    return (prev == old) ? (abchunk **) NULL : &prev->achunk;
+}
+
 /*
  * NAME:	data->discard_arr()
  * DESCRIPTION:	restore array to previous plane
@@ -997,7 +1034,7 @@ void d_discard_arr(array *arr, dataplane *plane)
 void d_ref_imports(array *arr)
 {
     dataspace *data;
-    unsigned short n;
+    asizet n;
     value *v;
 
     data = arr->primary->data;
@@ -1081,10 +1118,12 @@ void d_wipe_extravar(dataspace *data)
 }
 
 /*
- * NAME:	data->assign_elt()
- * DESCRIPTION:	assign a value to an array element
+ * NAME:	assign_elt()
+ * DESCRIPTION:	assign a value to an array element, backing up either the
+ *		whole array or only the element
  */
-void d_assign_elt(dataspace *data, array *arr, value *elt, value *val)
+static void assign_elt(dataspace *data, array *arr, value *elt, value *val,
+		       bool single)
 {
     if (data->plane->level != arr->primary->data->plane->level) {
 	/*
@@ -1095,14 +1134,22 @@ void d_assign_elt(dataspace *data, array *arr, value *elt, value *val)
 
     data = arr->primary->data;
     if (arr->primary->plane != data->plane) {
-	/*
-	 * backup array's current elements
-	 */
-	arr_backup(&data->plane->achunk, arr);
-	if (arr->primary->arr != (array *) NULL) {
-	    arr->primary->plane = data->plane;
+	if (single) {
+	    /*
+	     * backup element only; the array stays on its original plane,
+	     * so that further changes are backed up as well
+	     */
+	    arr_backup_elt(&data->plane->achunk, arr, elt - arr->elts);
 	} else {
-	    arr->primary = &data->plane->alocal;
+	    /*
+	     * backup array's current elements
+	     */
+	    arr_backup(&data->plane->achunk, arr);
+	    if (arr->primary->arr != (array *) NULL) {
+		arr->primary->plane = data->plane;
+	    } else {
+		arr->primary = &data->plane->alocal;
+	    }
 	}
     }
 
@@ -1143,6 +1190,40 @@ void d_assign_elt(dataspace *data, array *arr, value *elt, value *val)
     elt->modified = TRUE;
 }
 
+/*
+ * NAME:	data->assign_elt()
+ * DESCRIPTION:	assign a value to an array or mapping element
+ */
+void d_assign_elt(dataspace *data, array *arr, value *elt, value *val)
+{
+    assign_elt(data, arr, elt, val, FALSE);
+}
+
+/*
+ * NAME:	data->assign_index()
+ * DESCRIPTION:	assign a value to an indexed array element.  Only the
+ *		element is backed up, so this must not be used for mappings
+ *		or light-weight objects, which may be rebuilt as a whole.
+ */
+void d_assign_index(dataspace *data, array *arr, unsigned int idx, value *val)
+{
+    if (d_get_packed(arr) != (char *) NULL && val->type == arr->ptype &&
+	data->plane->level == arr->primary->data->plane->level &&
+	arr->primary->plane == arr->primary->data->plane) {
+	/*
+	 * same type in a packed array that needs no backup: store in place
+	 */
+	if (arr->primary->arr != (array *) NULL &&
+	    (arr->primary->ref & ARR_MOD) == 0) {
+	    arr->primary->ref |= ARR_MOD;
+	    arr->primary->data->plane->flags |= MOD_ARRAY;
+	}
+	arr_put_packed(arr, idx, val);
+	return;
+    }
+    assign_elt(data, arr, &d_get_elts(arr)[idx], val, TRUE);
+}
+
 /*
  * NAME:	data->change_map()
  * DESCRIPTION:	mark a mapping as changed in size
@@ -1407,7 +1488,7 @@ array *d_list_callouts(dataspace *host, dataspace *data)
     dcallout *co;
     value *v, *v2, *elts;
     array *list, *a;
-    uindex max_args;
+    asizet max_args;
     xfloat flt;
 
     if (data->ncallouts == 0) {
@@ -1493,6 +1574,30 @@ array *d_list_callouts(dataspace *host, dataspace *data)
     return list;
 }
 
+/*
+ * NAME:	data->memory()
+ * DESCRIPTION:	return the memory used by the strings, arrays, mapping hash
+ *		tables and callouts of a dataspace, as of the last save plus
+ *		the changes made since
+ */
+void d_memory(dataspace *data, Uint *mem)
+{
+    long size;
+    array *a;
+
+    size = data->nstrings * (long) sizeof(string) + data->strsize +
+	   data->plane->strmem;
+    mem[0] = (size > 0) ? size : 0;
+    size = data->narrays * (long) sizeof(array) +
+	   data->eltsize * (long) sizeof(value) + data->plane->arrmem;
+    mem[1] = (size > 0) ? size : 0;
+    mem[2] = 0;
+    for (a = data->alist.next; a != &data->alist; a = a->next) {
+	mem[2] += map_hashmem(a);
+    }
+    mem[3] = data->ncallouts * sizeof(dcallout);
+}
+
 
 /*
  * NAME:	data->set_varmap()
@@ -1765,7 +1870,17 @@ static void d_import(arrimport *imp, dataspace *data, value *val,
 			a->tag = val->u.array->tag;
 			a->odcount = val->u.array->odcount;
 
-			if (a->size > 0) {
+			if (d_get_packed(val->u.array) != (char *) NULL) {
+			    /*
+			     * copy packed elements
+			     */
+			    a->ptype = val->u.array->ptype;
+			    memcpy(a->packed = ALLOC(char,
+						     PKD_SIZE(a->ptype,
+							      a->size)),
+				   val->u.array->packed,
+				   PKD_SIZE(a->ptype, a->size));
+			} else if (a->size > 0) {
 			    /*
 			     * copy elements
 			     */
@@ -1800,7 +1915,7 @@ static void d_import(arrimport *imp, dataspace *data, value *val,
 		    a->next->prev = a;
 		    data->alist.next = a;
 
-		    if (a->size > 0) {
+		    if (a->elts != (value *) NULL) {
 			/*
 			 * import elements too
 			 */
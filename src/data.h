@@ -65,6 +65,7 @@ typedef struct {
 struct _control_ {
     control *prev, *next;
     uindex ndata;		/* # of data blocks using this control block */
+    Uint access;		/* swapout round of last access */
 
     sector nsectors;		/* o # of sectors */
     sector *sectors;		/* o vector with sectors */
@@ -169,6 +170,8 @@ struct _dataplane_ {
     long schange;		/* # string changes */
     long achange;		/* # array changes */
     long imports;		/* # array imports */
+    long strmem;		/* string memory added since last save */
+    long arrmem;		/* array memory added since last save */
 
     value *original;		/* original variables */
     arrref alocal;		/* primary of new local arrays */
@@ -184,6 +187,7 @@ struct _dataplane_ {
 struct _dataspace_ {
     dataspace *prev, *next;	/* swap list */
     dataspace *gcprev, *gcnext;	/* garbage collection list */
+    Uint access;		/* swapout round of last access */
 
     dataspace *iprev;		/* previous in import list */
     dataspace *inext;		/* next in import list */
@@ -206,18 +210,21 @@ struct _dataspace_ {
     struct _svalue_ *selts;	/* o sarray elements */
     array alist;		/* array linked list sentinel */
     Uint arroffset;		/* o offset of array table in data space */
+    Uint eltoffset;		/* o offset of array elements */
 
     Uint nstrings;		/* i/o # strings */
     Uint strsize;		/* o total size of string text */
     struct _sstring_ *sstrings;	/* o sstrings */
     char *stext;		/* o sstrings text */
     Uint stroffset;		/* o offset of string table */
+    Uint txtoffset;		/* o offset of string text */
 
     uindex ncallouts;		/* # callouts */
     uindex fcallouts;		/* free callout list */
     dcallout *callouts;		/* callouts */
     struct _scallout_ *scallouts; /* o scallouts */
     Uint cooffset;		/* offset of callout table */
+    Uint datasize;		/* size of data space in swap, or 0 */
 
     dataplane base;		/* basic value plane */
     dataplane *plane;		/* current value plane */
@@ -230,7 +237,7 @@ struct _dataspace_ {
 
 /* sdata.c */
 
-extern void		d_init		 (void);
+extern void		d_init		 (int, Uint, unsigned int);
 extern void		d_init_conv	 (int, int, int, int, int, int, int,
 					    int, int);
 
@@ -238,6 +245,7 @@ extern control	       *d_new_control	 (void);
 extern dataspace       *d_new_dataspace  (object*);
 extern control	       *d_load_control	 (object*);
 extern dataspace       *d_load_dataspace (object*);
+extern void		d_swapped_memory (object*, Uint*);
 extern void		d_ref_control	 (control*);
 extern void		d_ref_dataspace  (dataspace*);
 
@@ -252,10 +260,15 @@ extern Uint		d_get_progsize	 (control*);
 extern void		d_new_variables	 (control*, value*);
 extern value	       *d_get_variable	 (dataspace*, unsigned int);
 extern value	       *d_get_elts	 (array*);
+extern char	       *d_get_packed	 (array*);
 extern void		d_get_callouts	 (dataspace*);
 
 extern sector		d_swapout	 (unsigned int);
+extern void		d_swapstat	 (size_t*);
+extern bool		d_collect	 (unsigned int);
+extern void		d_gcstat	 (size_t*);
 extern void		d_upgrade_mem	 (object*, object*);
+extern void		d_prefetch_obj	 (object*);
 extern void		d_restore_obj	 (object*, Uint*, uindex, bool, bool);
 extern void		d_converted	 (void);
 
@@ -268,6 +281,7 @@ extern void		d_new_plane	(dataspace*, Int);
 extern void		d_commit_plane	(Int, value*);
 extern void		d_discard_plane	(Int);
 extern abchunk	      **d_commit_arr	(array*, dataplane*, dataplane*);
+extern abchunk	      **d_commit_elt	(value*, dataplane*, dataplane*);
 extern void		d_discard_arr	(array*, dataplane*);
 
 extern void		d_ref_imports	(array*);
@@ -276,6 +290,8 @@ extern value	       *d_get_extravar	(dataspace*);
 extern void		d_set_extravar	(dataspace*, value*);
 extern void		d_wipe_extravar	(dataspace*);
 extern void		d_assign_elt	(dataspace*, array*, value*, value*);
+extern void		d_assign_index	(dataspace*, array*, unsigned int,
+					 value*);
 extern void		d_change_map	(array*);
 
 extern uindex		d_new_call_out	(dataspace*, string*, Int,
@@ -284,6 +300,7 @@ extern Int		d_del_call_out	(dataspace*, Uint, unsigned short*);
 extern string	       *d_get_call_out	(dataspace*, unsigned int, frame*,
 					   int*);
 extern array	       *d_list_callouts	(dataspace*, dataspace*);
+extern void		d_memory	(dataspace*, Uint*);
 
 extern void		d_set_varmap	(control*, unsigned int,
 					   unsigned short*);
@@ -308,6 +325,7 @@ extern void		d_del_dataspace	(dataspace*);
 
 /* bit values for dataspace->flags */
 # define DATA_STRCMP		0x03	/* strings compressed */
+# define DATA_STABLE		0x04	/* sections at explicit offsets */
 
 /* bit values for dataspace->plane->flags */
 # define MOD_ALL		0x3f
@@ -324,6 +342,7 @@ extern void		d_del_dataspace	(dataspace*);
 # define CMP_TYPE		0x03
 # define CMP_NONE		0x00	/* no compression */
 # define CMP_PRED		0x01	/* predictor compression */
+# define CMP_LZ			0x02	/* LZ compression */
 
 # define ARR_MOD		0x80000000L	/* in arrref->ref */
 
@@ -86,6 +86,7 @@ void endthread()
     ec_clear();
 
     co_swapcount(d_swapout(fragment));
+    m_release();
 
     if (stop) {
 	comm_finish();
@@ -116,6 +117,7 @@ void endthread()
     }
 
     if (stop) {
+	conf_dumped(TRUE);
 	sw_finish();
 	m_finish();
 	exit(0);
@@ -175,6 +177,9 @@ int dgd_main(int argc, char **argv)
     }
 
     for (;;) {
+	/* snapshot written in the background */
+	conf_dumped(FALSE);
+
 	/* rebuild swapfile */
 	if (rebuild) {
 	    timeout = co_time(&mtime);
@@ -203,6 +208,11 @@ int dgd_main(int argc, char **argv)
 
 	/* handle user input */
 	timeout = co_delay(rtime, rmtime, &mtime);
+	if ((timeout != 0 || mtime != 0) && d_collect(fragment)) {
+	    /* idle, but more garbage to collect: only poll */
+	    timeout = 0;
+	    mtime = 0;
+	}
 	comm_receive(cframe, timeout, mtime);
 
 	/* callouts */
@@ -500,7 +500,7 @@ static value *ext_array_index(array *a, int i)
  */
 static void ext_array_assign(dataspace *data, array *a, int i, value *val)
 {
-    d_assign_elt(data, a, &d_get_elts(a)[i], val);
+    d_assign_index(data, a, i, val);
 }
 
 /*
@@ -59,19 +59,37 @@ char strhashtab[] = {
     '\302', '\213', '\160', '\053', '\107', '\155', '\270', '\321',
 };
 
+# define HT_SAMPLE	256	/* # lookups per chain length sample */
+# define HT_MAXWALK	2	/* max. average # entries compared per lookup */
+# define HT_NSPLIT	2	/* max. # buckets split per insert */
+
+/*
+ * 64 bit FNV-1a
+ */
+# define FNV_OFFSET	(((Uuint) 0xcbf29ce4L << 32) | 0x84222325L)
+# define FNV_PRIME(h)	(((h) << 40) + (h) * 0x1b3)
+
 /*
  * NAME:	hashtab->new()
- * DESCRIPTION:	create a hashtable of size "size", where "maxlen" characters
- *		of each string are significant
+ * DESCRIPTION:	create a hashtable of initial size "size", where "maxlen"
+ *		bytes of raw memory are significant
  */
 hashtab *ht_new(unsigned int size, unsigned int maxlen, int mem)
 {
     hashtab *ht;
 
-    ht = (hashtab *) ALLOC(char, sizeof(hashtab) + sizeof(hte*) * (size - 1));
-    ht->size = size;
+    if (size == 0) {
+	size = 1;
+    }
+    ht = ALLOC(hashtab, 1);
+    ht->size = ht->lsize = ht->tabsize = size;
+    ht->split = 0;
+    ht->nsplit = 0;
+    ht->nlookup = ht->nwalk = 0;
+    ht->hash = 0;
     ht->maxlen = maxlen;
     ht->mem = mem;
+    ht->table = ALLOC(hte*, size);
     memset(ht->table, '\0', size * sizeof(hte*));
 
     return ht;
@@ -83,6 +101,7 @@ hashtab *ht_new(unsigned int size, unsigned int maxlen, int mem)
  */
 void ht_del(hashtab *ht)
 {
+    FREE(ht->table);
     FREE(ht);
 }
 
@@ -123,46 +142,178 @@ unsigned short hashmem(char *s, unsigned int len)
 }
 
 /*
- * NAME:	hashtab->lookup()
- * DESCRIPTION:	lookup a name in a hashtable, return the address of the entry
- *		or &NULL if none found
+ * NAME:	hashtab->hash()
+ * DESCRIPTION:	compute the 64 bit hash of a name; all characters of a
+ *		string are significant
  */
-hte **ht_lookup(hashtab *ht, char *name, int move)
+Uuint ht_hash(hashtab *ht, char *name)
+{
+    Uuint h;
+    unsigned int len;
+
+    h = FNV_OFFSET;
+    if (ht->mem) {
+	for (len = ht->maxlen; len != 0; --len) {
+	    h ^= UCHAR(*name++);
+	    h = FNV_PRIME(h);
+	}
+    } else {
+	while (*name != '\0') {
+	    h ^= UCHAR(*name++);
+	    h = FNV_PRIME(h);
+	}
+    }
+    return h ^ (h >> 32);
+}
+
+/*
+ * NAME:	hashtab->bucket()
+ * DESCRIPTION:	return the bucket for a hash value
+ */
+static Uint ht_bucket(hashtab *ht, Uuint h)
+{
+    Uint b;
+
+    b = h % ht->lsize;
+    if (b < ht->split) {
+	b = h % (ht->lsize << 1);
+    }
+    return b;
+}
+
+/*
+ * NAME:	hashtab->split()
+ * DESCRIPTION:	split the next bucket in two, preserving the order of the
+ *		entries in both
+ */
+static void ht_split(hashtab *ht)
+{
+    hte **e, **f, *next;
+    Uint b, lsize;
+
+    b = ht->lsize + ht->split;
+    lsize = ht->lsize << 1;
+    e = &ht->table[ht->split];
+    f = &ht->table[b];
+    while (*e != (hte *) NULL) {
+	if ((*e)->hash % lsize == b) {
+	    /* move to new bucket */
+	    next = (*e)->next;
+	    *f = *e;
+	    f = &(*e)->next;
+	    *e = next;
+	} else {
+	    e = &(*e)->next;
+	}
+    }
+    *f = (hte *) NULL;
+
+    if (++ht->split == ht->lsize) {
+	ht->lsize = lsize;
+	ht->split = 0;
+    }
+    --ht->nsplit;
+}
+
+/*
+ * NAME:	hashtab->hlookup()
+ * DESCRIPTION:	lookup a name with a given hash value in a hashtable, return
+ *		the address of the entry or &NULL if none found
+ */
+hte **ht_hlookup(hashtab *ht, char *name, Uuint hash, int move)
 {
     hte **first, **e, *next;
+    Uint walk, size;
 
+    if (ht->nlookup == HT_SAMPLE) {
+	/*
+	 * schedule doubling the table if chains have become too long; the
+	 * buckets are allocated here, so inserting never moves the table
+	 */
+	if (ht->nwalk > HT_SAMPLE * HT_MAXWALK && ht->nsplit == 0) {
+	    ht->nsplit = ht->lsize + ht->split;
+	    size = ht->nsplit << 1;
+	    if (size > ht->tabsize) {
+		ht->table = REALLOC(ht->table, hte*, ht->tabsize, size);
+		memset(ht->table + ht->tabsize, '\0',
+		       (size - ht->tabsize) * sizeof(hte*));
+		ht->tabsize = size;
+	    }
+	}
+	ht->nlookup = ht->nwalk = 0;
+    }
+    ht->nlookup++;
+    ht->hash = hash;
+
+    walk = 0;
+    first = e = &ht->table[ht_bucket(ht, hash)];
     if (ht->mem) {
-	first = e = &(ht->table[hashmem(name, ht->maxlen) % ht->size]);
 	while (*e != (hte *) NULL) {
-	    if (memcmp((*e)->name, name, ht->maxlen) == 0) {
+	    walk++;
+	    if ((*e)->hash == hash &&
+		memcmp((*e)->name, name, ht->maxlen) == 0) {
 		if (move && e != first) {
 		    /* move to first position */
 		    next = (*e)->next;
 		    (*e)->next = *first;
 		    *first = *e;
 		    *e = next;
-		    return first;
+		    e = first;
 		}
 		break;
 	    }
 	    e = &((*e)->next);
 	}
     } else {
-	first = e = &(ht->table[hashstr(name, ht->maxlen) % ht->size]);
 	while (*e != (hte *) NULL) {
-	    if (strcmp((*e)->name, name) == 0) {
+	    walk++;
+	    if ((*e)->hash == hash && strcmp((*e)->name, name) == 0) {
 		if (move && e != first) {
 		    /* move to first position */
 		    next = (*e)->next;
 		    (*e)->next = *first;
 		    *first = *e;
 		    *e = next;
-		    return first;
+		    e = first;
 		}
 		break;
 	    }
 	    e = &((*e)->next);
 	}
     }
+    ht->nwalk += walk;
     return e;
 }
+
+/*
+ * NAME:	hashtab->lookup()
+ * DESCRIPTION:	lookup a name in a hashtable, return the address of the entry
+ *		or &NULL if none found
+ */
+hte **ht_lookup(hashtab *ht, char *name, int move)
+{
+    return ht_hlookup(ht, name, ht_hash(ht, name), move);
+}
+
+/*
+ * NAME:	hashtab->insert()
+ * DESCRIPTION:	insert an entry at an address in the chain found by the last
+ *		lookup in the hashtable, which must have been for the name of
+ *		the entry.  Any scheduled growth of the table is done here,
+ *		but the chain of the new entry is never relinked
+ */
+void ht_insert(hashtab *ht, hte **e, hte *entry)
+{
+    int i;
+
+    entry->next = *e;
+    entry->hash = ht->hash;
+    *e = entry;
+
+    for (i = HT_NSPLIT; ht->nsplit != 0 && i != 0; --i) {
+	if (ht_bucket(ht, entry->hash) == ht->split) {
+	    break;	/* caller may still hold addresses in this chain */
+	}
+	ht_split(ht);
+    }
+}
@@ -23,13 +23,21 @@
 typedef struct _hte_ {
     struct _hte_ *next;	/* next entry in hash table */
     char *name;		/* string to use in hashing */
+    Uuint hash;		/* hash of name */
 } hte;
 
 typedef struct {
-    Uint size;			/* size of hash table (power of two) */
-    unsigned short maxlen;	/* max length of string to be used in hashing */
+    Uint size;			/* initial size of hash table */
+    Uint lsize;			/* size of hash table at current level */
+    Uint split;			/* next bucket to split */
+    Uint tabsize;		/* allocated size of bucket array */
+    Uint nsplit;		/* # buckets still to be split */
+    Uint nlookup;		/* # lookups in current sample */
+    Uint nwalk;			/* # entries compared in current sample */
+    Uuint hash;			/* hash of name last looked up */
+    unsigned short maxlen;	/* max length of memory to be used in hashing */
     bool mem;			/* \0-terminated string or raw memory? */
-    hte *table[1];		/* hash table entries */
+    hte **table;		/* hash table entries */
 } hashtab;
 
 extern char		strhashtab[];
@@ -38,6 +46,9 @@ extern unsigned short	hashmem		(char*, unsigned int);
 
 extern hashtab	       *ht_new		(unsigned int, unsigned int, int);
 extern void		ht_del		(hashtab*);
+extern Uuint		ht_hash		(hashtab*, char*);
 extern hte	      **ht_lookup	(hashtab*, char*, int);
+extern hte	      **ht_hlookup	(hashtab*, char*, Uuint, int);
+extern void		ht_insert	(hashtab*, hte**, hte*);
 
 # endif /* H_HASH */
@@ -148,6 +148,11 @@ typedef unsigned int Uint;
 # ifdef INCLUDE_FILE_IO
 # include <fcntl.h>
 # include <sys/stat.h>
+# ifndef DARWIN
+# include <sys/uio.h>
+# define P_preadv	preadv
+# define P_pwritev	pwritev
+# endif
 # endif
 
 # ifdef INCLUDE_CTYPE
@@ -189,6 +194,11 @@ typedef unsigned int Uint;
 # ifndef FNDELAY
 # define FNDELAY	O_NDELAY
 # endif
+# ifdef LINUX
+# include <sys/uio.h>
+# define P_preadv	preadv
+# define P_pwritev	pwritev
+# endif
 # endif
 
 # ifdef INCLUDE_CTYPE
@@ -287,6 +297,22 @@ extern void  P_closedir	(void);
 
 extern voidf *P_dload	(char*, char*);
 
+extern char *P_mmap	(size_t, bool);
+extern void  P_munmap	(char*, size_t);
+extern void  P_mrelease	(char*, size_t);
+extern char *P_mapfile	(int, size_t);
+extern void  P_unmapfile	(char*, size_t);
+extern void  P_msync	(char*, size_t);
+extern void  P_readahead	(int, off_t, size_t);
+
+extern bool  P_wbstart	(void);
+extern Uint  P_wbwrite	(int, char*, unsigned int, off_t);
+extern bool  P_wbwait	(Uint);
+
+extern int   P_fork	(void);
+extern int   P_reap	(int, bool);
+extern void  P_exitchild	(int);
+
 extern void  P_srandom	(long);
 extern long  P_random	(void);
 
@@ -17,8 +17,17 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+# define INCLUDE_FILE_IO
 # include "dgd.h"
 # include <signal.h>
+# include <sys/mman.h>
+# include <sys/wait.h>
+# include <errno.h>
+# include <pthread.h>
+
+# ifndef MAP_ANONYMOUS
+# define MAP_ANONYMOUS	MAP_ANON
+# endif
 
 /*
  * NAME:	term()
@@ -55,3 +64,253 @@ void P_message(char *mess)
     fputs(mess, stderr);
     fflush(stderr);
 }
+
+/*
+ * NAME:	P->mmap()
+ * DESCRIPTION:	map anonymous memory, possibly backed by huge pages
+ */
+char *P_mmap(size_t size, bool huge)
+{
+    char *mem;
+
+    mem = (char *) mmap((void *) NULL, size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == (char *) MAP_FAILED) {
+	return (char *) NULL;
+    }
+# ifdef MADV_HUGEPAGE
+    if (huge) {
+	madvise(mem, size, MADV_HUGEPAGE);
+    }
+# else
+    UNREFERENCED_PARAMETER(huge);
+# endif
+    return mem;
+}
+
+/*
+ * NAME:	P->munmap()
+ * DESCRIPTION:	unmap memory
+ */
+void P_munmap(char *mem, size_t size)
+{
+    munmap(mem, size);
+}
+
+/*
+ * NAME:	P->mrelease()
+ * DESCRIPTION:	return the pages fully within a range of mapped memory to
+ *		the OS, leaving the mapping itself intact
+ */
+void P_mrelease(char *mem, size_t size)
+{
+    size_t pagesize;
+    char *end;
+
+    pagesize = sysconf(_SC_PAGESIZE);
+    end = (char *) ((uintptr_t) (mem + size) & ~(pagesize - 1));
+    mem = (char *) (((uintptr_t) mem + pagesize - 1) & ~(pagesize - 1));
+    if (mem < end) {
+	madvise(mem, end - mem, MADV_DONTNEED);
+    }
+}
+
+/*
+ * NAME:	P->mapfile()
+ * DESCRIPTION:	map a file into memory, shared with the file itself
+ */
+char *P_mapfile(int fd, size_t size)
+{
+    char *mem;
+
+    mem = (char *) mmap((void *) NULL, size, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+    return (mem == (char *) MAP_FAILED) ? (char *) NULL : mem;
+}
+
+/*
+ * NAME:	P->unmapfile()
+ * DESCRIPTION:	unmap a mapped file
+ */
+void P_unmapfile(char *mem, size_t size)
+{
+    munmap(mem, size);
+}
+
+/*
+ * NAME:	P->msync()
+ * DESCRIPTION:	write the changes to a mapped file to disk
+ */
+void P_msync(char *mem, size_t size)
+{
+    msync(mem, size, MS_SYNC);
+}
+
+/*
+ * NAME:	P->readahead()
+ * DESCRIPTION:	start reading part of a file in the background, so that
+ *		a later read need not wait for the disk
+ */
+void P_readahead(int fd, off_t offset, size_t size)
+{
+# ifdef POSIX_FADV_WILLNEED
+    posix_fadvise(fd, offset, (off_t) size, POSIX_FADV_WILLNEED);
+# else
+    UNREFERENCED_PARAMETER(fd);
+    UNREFERENCED_PARAMETER(offset);
+    UNREFERENCED_PARAMETER(size);
+# endif
+}
+
+# define WB_QUEUE	64		/* max # of queued writes */
+
+static struct {
+    int fd;			/* file descriptor */
+    char *buf;			/* data to write */
+    unsigned int size;		/* size of data */
+    off_t offset;		/* offset in file */
+} wbq[WB_QUEUE];		/* write-behind queue */
+static Uint wbqueued, wbwritten;	/* # writes queued, # completed */
+static bool wberror;			/* has a write failed? */
+static pthread_mutex_t wblock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wbwork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t wbdone = PTHREAD_COND_INITIALIZER;
+
+/*
+ * NAME:	writer()
+ * DESCRIPTION:	write-behind thread
+ */
+static void *writer(void *arg)
+{
+    int i;
+    bool failed;
+
+    UNREFERENCED_PARAMETER(arg);
+    pthread_mutex_lock(&wblock);
+    for (;;) {
+	while (wbwritten == wbqueued) {
+	    pthread_cond_wait(&wbwork, &wblock);
+	}
+	i = wbwritten % WB_QUEUE;
+	pthread_mutex_unlock(&wblock);
+
+	failed = (pwrite(wbq[i].fd, wbq[i].buf, wbq[i].size, wbq[i].offset) !=
+							    (ssize_t) wbq[i].size);
+
+	pthread_mutex_lock(&wblock);
+	if (failed) {
+	    wberror = TRUE;
+	}
+	wbwritten++;
+	pthread_cond_signal(&wbdone);
+    }
+    return NULL;
+}
+
+/*
+ * NAME:	P->wbstart()
+ * DESCRIPTION:	start the write-behind thread
+ */
+bool P_wbstart()
+{
+    pthread_t thread;
+    sigset_t mask, omask;
+    int err;
+
+    /* leave signal handling to the main thread */
+    sigfillset(&mask);
+    pthread_sigmask(SIG_BLOCK, &mask, &omask);
+    err = pthread_create(&thread, (pthread_attr_t *) NULL, writer, NULL);
+    pthread_sigmask(SIG_SETMASK, &omask, (sigset_t *) NULL);
+    if (err != 0) {
+	return FALSE;
+    }
+    pthread_detach(thread);
+    return TRUE;
+}
+
+/*
+ * NAME:	P->wbwrite()
+ * DESCRIPTION:	queue a positional write, and return its sequence number.
+ *		The buffer must be left alone until the write has completed
+ */
+Uint P_wbwrite(int fd, char *buf, unsigned int size, off_t offset)
+{
+    int i;
+    Uint seq;
+
+    pthread_mutex_lock(&wblock);
+    while (wbqueued - wbwritten == WB_QUEUE) {
+	pthread_cond_wait(&wbdone, &wblock);
+    }
+    i = wbqueued % WB_QUEUE;
+    wbq[i].fd = fd;
+    wbq[i].buf = buf;
+    wbq[i].size = size;
+    wbq[i].offset = offset;
+    seq = wbqueued++;
+    pthread_cond_signal(&wbwork);
+    pthread_mutex_unlock(&wblock);
+
+    return seq;
+}
+
+/*
+ * NAME:	P->wbwait()
+ * DESCRIPTION:	wait until a queued write and all writes queued before it
+ *		have completed.  Return FALSE if any write failed
+ */
+bool P_wbwait(Uint seq)
+{
+    bool ok;
+
+    pthread_mutex_lock(&wblock);
+    while ((Int) (wbwritten - seq) <= 0 && !wberror) {
+	pthread_cond_wait(&wbdone, &wblock);
+    }
+    ok = !wberror;
+    pthread_mutex_unlock(&wblock);
+
+    return ok;
+}
+
+/*
+ * NAME:	P->fork()
+ * DESCRIPTION:	create a child process.  Return its process ID in the
+ *		parent, 0 in the child, or -1 on failure
+ */
+int P_fork()
+{
+    return fork();
+}
+
+/*
+ * NAME:	P->reap()
+ * DESCRIPTION:	check if a child process has terminated, waiting for it if
+ *		block is TRUE.  Return 0 if it is still running, 1 if it
+ *		exited successfully, and -1 otherwise
+ */
+int P_reap(int pid, bool block)
+{
+    pid_t p;
+    int status;
+
+    do {
+	p = waitpid((pid_t) pid, &status, (block) ? 0 : WNOHANG);
+    } while (p < 0 && errno == EINTR);
+    if (p == 0) {
+	return 0;
+    }
+    return (p == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0) ?
+	    1 : -1;
+}
+
+/*
+ * NAME:	P->exitchild()
+ * DESCRIPTION:	terminate a child process, leaving alone what it shares
+ *		with its parent
+ */
+void P_exitchild(int status)
+{
+    _exit(status);
+}
@@ -982,8 +982,7 @@ bool conn_udp(connection *conn, char *challenge,
 	}
     }
 
-    conn->chain.next = (hte *)*hash;
-    *hash = conn;
+    ht_insert(chtab, (hte **) hash, (hte *) conn);
     conn->npkts = 0;
     m_static();
     conn->udpbuf = ALLOC(char, BINBUF_SIZE);
@@ -17,6 +17,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+# include <windows.h>
+# include <io.h>
 # include "dgd.h"
 
 /*
@@ -36,3 +38,154 @@ long P_random(void)
 {
     return (long) (rand() ^ (rand() << 9) ^ (rand() << 16));
 }
+
+/*
+ * NAME:	P->mmap()
+ * DESCRIPTION:	map anonymous memory
+ */
+char *P_mmap(size_t size, bool huge)
+{
+    UNREFERENCED_PARAMETER(huge);
+    return (char *) VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE,
+				 PAGE_READWRITE);
+}
+
+/*
+ * NAME:	P->munmap()
+ * DESCRIPTION:	unmap memory
+ */
+void P_munmap(char *mem, size_t size)
+{
+    UNREFERENCED_PARAMETER(size);
+    VirtualFree(mem, 0, MEM_RELEASE);
+}
+
+/*
+ * NAME:	P->mrelease()
+ * DESCRIPTION:	return the pages fully within a range of mapped memory to
+ *		the OS, leaving the mapping itself intact
+ */
+void P_mrelease(char *mem, size_t size)
+{
+    SYSTEM_INFO info;
+    char *end;
+
+    GetSystemInfo(&info);
+    end = (char *) ((uintptr_t) (mem + size) & ~(info.dwPageSize - 1));
+    mem = (char *) (((uintptr_t) mem + info.dwPageSize - 1) &
+		    ~(info.dwPageSize - 1));
+    if (mem < end) {
+	VirtualAlloc(mem, end - mem, MEM_RESET, PAGE_READWRITE);
+    }
+}
+
+/*
+ * NAME:	P->mapfile()
+ * DESCRIPTION:	map a file into memory, shared with the file itself
+ */
+char *P_mapfile(int fd, size_t size)
+{
+    HANDLE map;
+    char *mem;
+
+    map = CreateFileMapping((HANDLE) _get_osfhandle(fd), NULL, PAGE_READWRITE,
+			    (DWORD) ((unsigned long long) size >> 32),
+			    (DWORD) size, NULL);
+    if (map == NULL) {
+	return (char *) NULL;
+    }
+    mem = (char *) MapViewOfFile(map, FILE_MAP_WRITE, 0, 0, size);
+    CloseHandle(map);	/* the view keeps the mapping alive */
+    return mem;
+}
+
+/*
+ * NAME:	P->unmapfile()
+ * DESCRIPTION:	unmap a mapped file
+ */
+void P_unmapfile(char *mem, size_t size)
+{
+    UNREFERENCED_PARAMETER(size);
+    UnmapViewOfFile(mem);
+}
+
+/*
+ * NAME:	P->msync()
+ * DESCRIPTION:	write the changes to a mapped file to disk
+ */
+void P_msync(char *mem, size_t size)
+{
+    FlushViewOfFile(mem, size);
+}
+
+/*
+ * NAME:	P->readahead()
+ * DESCRIPTION:	no read-ahead hints on Windows
+ */
+void P_readahead(int fd, off_t offset, size_t size)
+{
+    UNREFERENCED_PARAMETER(fd);
+    UNREFERENCED_PARAMETER(offset);
+    UNREFERENCED_PARAMETER(size);
+}
+
+/*
+ * NAME:	P->wbstart()
+ * DESCRIPTION:	start the write-behind thread (not available)
+ */
+bool P_wbstart()
+{
+    return FALSE;
+}
+
+/*
+ * NAME:	P->wbwrite()
+ * DESCRIPTION:	write synchronously
+ */
+Uint P_wbwrite(int fd, char *buf, unsigned int size, off_t offset)
+{
+    P_lseek(fd, offset, SEEK_SET);
+    if (P_write(fd, buf, size) != (int) size) {
+	fatal("cannot write swap file");
+    }
+    return 0;
+}
+
+/*
+ * NAME:	P->wbwait()
+ * DESCRIPTION:	wait for a write to complete
+ */
+bool P_wbwait(Uint seq)
+{
+    UNREFERENCED_PARAMETER(seq);
+    return TRUE;
+}
+
+/*
+ * NAME:	P->fork()
+ * DESCRIPTION:	no child processes on Windows
+ */
+int P_fork()
+{
+    return -1;
+}
+
+/*
+ * NAME:	P->reap()
+ * DESCRIPTION:	there are no child processes to reap
+ */
+int P_reap(int pid, bool block)
+{
+    UNREFERENCED_PARAMETER(pid);
+    UNREFERENCED_PARAMETER(block);
+    return -1;
+}
+
+/*
+ * NAME:	P->exitchild()
+ * DESCRIPTION:	terminate a child process
+ */
+void P_exitchild(int status)
+{
+    exit(status);
+}
@@ -701,6 +701,19 @@ void i_global_lvalue(frame *f, int inherit, int index, int vtype, Uint class)
     }
 }
 
+/*
+ * NAME:	interpret->elt()
+ * DESCRIPTION:	return an array element, using buf for a packed element
+ */
+static value *i_elt(array *a, asizet idx, value *buf)
+{
+    if (d_get_packed(a) != (char *) NULL) {
+	arr_get_packed(a, idx, buf);
+	return buf;
+    }
+    return &d_get_elts(a)[idx];
+}
+
 /*
  * NAME:	interpret->index()
  * DESCRIPTION:	index a value, REPLACING it with the indexed value
@@ -708,7 +721,7 @@ void i_global_lvalue(frame *f, int inherit, int index, int vtype, Uint class)
 void i_index(frame *f)
 {
     int i;
-    value *aval, *ival, *val;
+    value *aval, *ival, *val, elt;
     array *a;
 
     val = NULL;
@@ -732,8 +745,8 @@ void i_index(frame *f)
 	    i_del_value(ival);
 	    error("Non-numeric array index");
 	}
-	val = &d_get_elts(aval->u.array)[arr_index(aval->u.array,
-						   (long) ival->u.number)];
+	val = i_elt(aval->u.array,
+		    arr_index(aval->u.array, (long) ival->u.number), &elt);
 	break;
 
     case T_MAPPING:
@@ -800,8 +813,8 @@ void i_index2(frame *f, value *aval, value *ival, value *val)
 	    i_del_value(ival);
 	    error("Non-numeric array index");
 	}
-	*val = d_get_elts(aval->u.array)[arr_index(aval->u.array,
-						   ival->u.number)];
+	*val = *i_elt(aval->u.array, arr_index(aval->u.array, ival->u.number),
+		      val);
 	break;
 
     case T_MAPPING:
@@ -844,7 +857,7 @@ void i_index2(frame *f, value *aval, value *ival, value *val)
 void i_index_lvalue(frame *f, int vtype, Uint class)
 {
     int i;
-    value *lval, *ival, *val;
+    value *lval, *ival, *val, elt;
 
     i_add_ticks(f, 2);
     ival = f->sp++;
@@ -918,7 +931,7 @@ void i_index_lvalue(frame *f, int vtype, Uint class)
 	break;
 
     case T_ALVALUE:
-	val = &d_get_elts(lval->u.array)[f->lip[-1].u.number];
+	val = i_elt(lval->u.array, f->lip[-1].u.number, &elt);
 	switch (val->type) {
 	case T_STRING:
 	    if (ival->type != T_INT) {
@@ -1145,13 +1158,15 @@ void i_cast(frame *f, value *val, unsigned int type, Uint class)
  */
 void i_dup(frame *f)
 {
+    value elt;
+
     switch (f->sp->type) {
     case T_LVALUE:
 	i_push_value(f, f->sp->u.lval);
 	break;
 
     case T_ALVALUE:
-	i_push_value(f, d_get_elts(f->sp->u.array) + f->lip[-1].u.number);
+	i_push_value(f, i_elt(f->sp->u.array, f->lip[-1].u.number, &elt));
 	break;
 
     case T_MLVALUE:
@@ -1184,7 +1199,8 @@ static value *istr(value *val, string *str, ssizet i, value *v)
 	error("Non-numeric value in indexed string assignment");
     }
 
-    PUT_STRVAL_NOREF(val, (str->primary == (strref *) NULL && str->ref == 1) ?
+    PUT_STRVAL_NOREF(val, (str->primary == (strref *) NULL && str->ref == 1 &&
+			    str->parent == (string *) NULL) ?
 			   str : str_new(str->text, (long) str->len));
     val->u.string->text[i] = v->u.number;
     return val;
@@ -1241,6 +1257,7 @@ bool i_store_index(frame *f, value *var, value *aval, value *ival, value *val)
 {
     string *str;
     array *arr;
+    asizet i;
 
     i_add_ticks(f, 3);
     switch (aval->type) {
@@ -1261,10 +1278,12 @@ bool i_store_index(frame *f, value *var, value *aval, value *ival, value *val)
 	    error("Non-numeric array index");
 	}
 	arr = aval->u.array;
-	aval = &d_get_elts(arr)[arr_index(arr, ival->u.number)];
+	i = arr_index(arr, ival->u.number);
 	if (var->type != T_STRING ||
-	    (aval->type == T_STRING && var->u.string == aval->u.string)) {
-	    d_assign_elt(f->data, arr, aval, val);
+	    (d_get_packed(arr) == (char *) NULL &&
+	     (aval = &d_get_elts(arr)[i])->type == T_STRING &&
+	     var->u.string == aval->u.string)) {
+	    d_assign_index(f->data, arr, i, val);
 	}
 	arr_del(arr);
 	break;
@@ -1327,7 +1346,7 @@ void i_store(frame *f)
 
 	case T_ALVALUE:
 	    a = lval->u.array;
-	    d_assign_elt(f->data, a, &d_get_elts(a)[(--f->lip)->u.number], val);
+	    d_assign_index(f->data, a, (--f->lip)->u.number, val);
 	    arr_del(a);
 	    break;
 
@@ -1340,9 +1359,9 @@ void i_store(frame *f)
 
 	case T_SALVALUE:
 	    a = lval->u.array;
-	    d_assign_elt(f->data, a, &a->elts[f->lip[-2].u.number],
-			 istr(&ival, f->lip[-1].u.string, f->lip[-1].oindex,
-			      val));
+	    d_assign_index(f->data, a, f->lip[-2].u.number,
+			   istr(&ival, f->lip[-1].u.string, f->lip[-1].oindex,
+				val));
 	    str_del((--f->lip)->u.string);
 	    --f->lip;
 	    arr_del(a);
@@ -2301,6 +2320,118 @@ static void i_interpret0(frame *f, char *pc)
     }
 }
 
+/*
+ * NAME:	interpret->sum_first()
+ * DESCRIPTION:	if the summands on the stack add up to a string without error,
+ *		return the first one
+ */
+static value *i_sum_first(frame *f, int nargs)
+{
+    value *v;
+    long size;
+
+    size = 0;
+    for (v = f->sp; --nargs > 0; v++) {
+	if (v->u.number == -2) {
+	    /* simple term */
+	    v++;
+	    if (v->type == T_STRING) {
+		size += v->u.string->len;
+	    } else if (v->type == T_INT) {
+		size += 11;
+	    } else {
+		return (value *) NULL;
+	    }
+	} else if (v->u.number < -2) {
+	    /* aggregate */
+	    return (value *) NULL;
+	} else {
+	    /* subrange term */
+	    size += v->u.number - v[1].u.number + 1;
+	    v += 2;
+	    if (v->type != T_STRING) {
+		return (value *) NULL;
+	    }
+	}
+    }
+
+    if (v->u.number != -2 || (++v)->type != T_STRING ||
+	size + v->u.string->len > MAX_STRLEN) {
+	return (value *) NULL;
+    }
+    return v;
+}
+
+/*
+ * NAME:	interpret->append_var()
+ * DESCRIPTION:	prepare for string addition followed by a store into the local
+ *		or global variable that holds the first string: if the variable
+ *		and the stack hold the only references to that string, release
+ *		the variable's reference so the kfun can append in place
+ */
+static void i_append_var(frame *f, int kfun, char *pc)
+{
+    unsigned short instr;
+    short local;
+    int inherit;
+    dataspace *data;
+    value *v, *var;
+
+    if (kfun == KF_ADD) {
+	v = f->sp + 1;
+	if (f->sp->type != T_STRING || v->type != T_STRING ||
+	    (long) v->u.string->len + f->sp->u.string->len > MAX_STRLEN) {
+	    return;
+	}
+    } else {
+	v = i_sum_first(f, FETCH1U(pc));
+	if (v == (value *) NULL) {
+	    return;
+	}
+    }
+    if (v->u.string->primary != (strref *) NULL || v->u.string->ref != 2) {
+	return;
+    }
+
+    instr = UCHAR(*pc) & I_EINSTR_MASK;
+    switch (instr & ~I_POP_BIT) {
+    case I_STORE_LOCAL:
+	local = SCHAR(pc[1]);
+	var = (local < 0) ? f->fp + local : f->argp + local;
+	if (var->type == T_STRING && var->u.string == v->u.string) {
+	    /* the store will overwrite the variable anyway */
+	    var->type = T_NIL;
+	    str_del(v->u.string);
+	}
+	break;
+
+    case I_STORE_GLOBAL:
+    case I_STORE_FAR_GLOBAL:
+	data = f->data;
+	if (f->lwobj != (array *) NULL ||
+	    (data->plane->level != 0 && data->plane->original == (value *) NULL))
+	{
+	    /* not an object variable, or it would be backed up first */
+	    return;
+	}
+	if ((instr & ~I_POP_BIT) == I_STORE_GLOBAL) {
+	    inherit = f->p_ctrl->ninherits - 1;
+	    pc++;
+	} else {
+	    inherit = UCHAR(pc[1]);
+	    pc += 2;
+	}
+	inherit = f->ctrl->imap[f->p_index + inherit];
+	var = d_get_variable(data,
+			     f->ctrl->inherits[inherit].varoffset + UCHAR(*pc));
+	if (var->type == T_STRING && var->u.string == v->u.string) {
+	    /* the store will overwrite the variable anyway */
+	    d_assign_var(data, var, &nil_value);
+	}
+	break;
+    }
+}
+
 /*
  * NAME:	interpret->interpret1()
  * DESCRIPTION:	Main interpreter function v1. Interpret stack machine code.
@@ -2528,7 +2659,11 @@ static void i_interpret1(frame *f, char *pc)
 
 	case I_CALL_KFUNC:
 	case I_CALL_KFUNC | I_POP_BIT:
-	    kf = &KFUN(FETCH1U(pc));
+	    u = FETCH1U(pc);
+	    if ((u == KF_ADD || u == KF_SUM) && size == 0) {
+		i_append_var(f, u, pc);
+	    }
+	    kf = &KFUN(u);
 	    if (PROTO_VARGS(kf->proto) != 0) {
 		/* variable # of arguments */
 		u = FETCH1U(pc) + size;
@@ -3296,7 +3431,7 @@ static array *i_func_trace(frame *f, dataspace *data)
     unsigned short n;
     value *args;
     array *a;
-    unsigned short max_args;
+    asizet max_args;
 
     max_args = conf_array_size() - 5;
 
@@ -54,6 +54,30 @@ static char *kf_itoa(Int i, char *buffer)
 
     return p;
 }
+
+/*
+ * NAME:	kfun->strrange()
+ * DESCRIPTION:	replace the string in v by a subrange of itself, without
+ *		copying if the range covers the whole string, or if the string
+ *		is unshared and the range is the first half or more of it
+ */
+static void kf_strrange(value *v, long l1, long l2)
+{
+    string *str;
+
+    str = v->u.string;
+    if (l1 == 0 && l2 == (long) str->len - 1) {
+	return;
+    }
+    if (str->primary == (strref *) NULL && str->ref == 1 &&
+	str->parent == (string *) NULL && l1 == 0 && l2 >= -1 &&
+	l2 < (long) str->len && (l2 + 1) << 1 >= str->len) {
+	str->text[str->len = l2 + 1] = '\0';
+	return;
+    }
+    PUT_STR(v, str_range(str, l1, l2));
+    str_del(str);
+}
 # endif
 
 
@@ -150,7 +174,15 @@ int kf_add(frame *f)
 	    return 0;
 
 	case T_STRING:
-	    str = str_add(f->sp[1].u.string, f->sp->u.string);
+	    str = f->sp[1].u.string;
+	    if (str->primary == (strref *) NULL && str->ref == 1) {
+		/* intermediate result: append in place */
+		str = str_append(str, f->sp->u.string);
+		str_del((f->sp++)->u.string);
+		f->sp->u.string = str;
+		return 0;
+	    }
+	    str = str_add(str, f->sp->u.string);
 	    str_del(f->sp->u.string);
 	    f->sp++;
 	    str_del(f->sp->u.string);
@@ -1207,7 +1239,6 @@ char pt_rangeft[] = { C_STATIC, 3, 0, 0, 9, T_MIXED, T_MIXED, T_MIXED,
  */
 int kf_rangeft(frame *f)
 {
-    string *str;
     array *a;
 
     if (f->sp[2].type == T_MAPPING) {
@@ -1230,11 +1261,9 @@ int kf_rangeft(frame *f)
     switch (f->sp[2].type) {
     case T_STRING:
 	i_add_ticks(f, 2);
-	str = str_range(f->sp[2].u.string, (long) f->sp[1].u.number,
-			(long) f->sp->u.number);
+	kf_strrange(&f->sp[2], (long) f->sp[1].u.number,
+		    (long) f->sp->u.number);
 	f->sp += 2;
-	str_del(f->sp->u.string);
-	PUT_STR(f->sp, str);
 	break;
 
     case T_ARRAY:
@@ -1266,7 +1295,6 @@ char pt_rangef[] = { C_STATIC, 2, 0, 0, 8, T_MIXED, T_MIXED, T_MIXED };
  */
 int kf_rangef(frame *f)
 {
-    string *str;
     array *a;
 
     if (f->sp[1].type == T_MAPPING) {
@@ -1285,11 +1313,9 @@ int kf_rangef(frame *f)
     switch (f->sp[1].type) {
     case T_STRING:
 	i_add_ticks(f, 2);
-	str = str_range(f->sp[1].u.string, (long) f->sp->u.number,
-			f->sp[1].u.string->len - 1L);
+	kf_strrange(&f->sp[1], (long) f->sp->u.number,
+		    f->sp[1].u.string->len - 1L);
 	f->sp++;
-	str_del(f->sp->u.string);
-	PUT_STR(f->sp, str);
 	break;
 
     case T_ARRAY:
@@ -1321,7 +1347,6 @@ char pt_ranget[] = { C_STATIC, 2, 0, 0, 8, T_MIXED, T_MIXED, T_MIXED };
  */
 int kf_ranget(frame *f)
 {
-    string *str;
     array *a;
 
     if (f->sp[1].type == T_MAPPING) {
@@ -1340,10 +1365,8 @@ int kf_ranget(frame *f)
     switch (f->sp[1].type) {
     case T_STRING:
 	i_add_ticks(f, 2);
-	str = str_range(f->sp[1].u.string, 0L, (long) f->sp->u.number);
+	kf_strrange(&f->sp[1], 0L, (long) f->sp->u.number);
 	f->sp++;
-	str_del(f->sp->u.string);
-	PUT_STR(f->sp, str);
 	break;
 
     case T_ARRAY:
@@ -1374,7 +1397,6 @@ char pt_range[] = { C_STATIC, 1, 0, 0, 7, T_MIXED, T_MIXED };
  */
 int kf_range(frame *f)
 {
-    string *str;
     array *a;
 
     if (f->sp->type == T_MAPPING) {
@@ -1389,9 +1411,7 @@ int kf_range(frame *f)
     switch (f->sp->type) {
     case T_STRING:
 	i_add_ticks(f, 2);
-	str = str_range(f->sp->u.string, 0L, f->sp->u.string->len - 1L);
-	str_del(f->sp->u.string);
-	PUT_STR(f->sp, str);
+	kf_strrange(f->sp, 0L, f->sp->u.string->len - 1L);
 	break;
 
     case T_ARRAY:
@@ -2014,6 +2034,7 @@ int kf_sum(frame *f, int nargs)
     i_add_ticks(f, nargs);
     type = T_NIL;
     isize = size = 0;
+    e1 = (value *) NULL;
     nonint = nargs;
     result = 0;
     for (v = f->sp, i = nargs; --i >= 0; v++) {
@@ -2023,6 +2044,11 @@ int kf_sum(frame *f, int nargs)
 	    vtype = v->type;
 	    if (vtype == T_STRING) {
 		size += v->u.string->len;
+		if (i == 0 && v->u.string->primary == (strref *) NULL &&
+		    v->u.string->ref == 1) {
+		    /* unshared intermediate result */
+		    e1 = v;
+		}
 	    } else if (vtype == T_ARRAY) {
 		size += v->u.array->size;
 	    } else {
@@ -2063,12 +2089,19 @@ int kf_sum(frame *f, int nargs)
      */
     result = 0;
     if (type == T_STRING) {
-	s = str_new((char *) NULL, size);
-	s->text[size] = '\0';
+	if (e1 != (value *) NULL) {
+	    /* append to the leftmost term in place */
+	    s = e1->u.string = str_extend(e1->u.string, size);
+	} else {
+	    s = str_new((char *) NULL, size);
+	    s->text[size] = '\0';
+	}
 	for (v = f->sp, i = nargs; --i >= 0; v++) {
 	    if (v->u.number == -2) {
 		/* simple term */
-		v++;
+		if (++v == e1) {
+		    break;
+		}
 		if (v->type == T_STRING) {
 		    size -= v->u.string->len;
 		    memcpy(s->text + size, v->u.string->text, v->u.string->len);
@@ -2099,8 +2132,12 @@ int kf_sum(frame *f, int nargs)
 	    memcpy(s->text, num, strlen(num));
 	}
 
-	f->sp = v - 1;
-	PUT_STRVAL(f->sp, s);
+	if (e1 != (value *) NULL) {
+	    f->sp = e1;
+	} else {
+	    f->sp = v - 1;
+	    PUT_STRVAL(f->sp, s);
+	}
     } else if (type == T_ARRAY) {
 	a = arr_new(f->data, size);
 	e1 = a->elts + size;
@@ -2456,7 +2493,15 @@ int kf_add_string(frame *f)
     string *str;
 
     i_add_ticks(f, 2);
-    str = str_add(f->sp[1].u.string, f->sp->u.string);
+    str = f->sp[1].u.string;
+    if (str->primary == (strref *) NULL && str->ref == 1) {
+	/* intermediate result: append in place */
+	str = str_append(str, f->sp->u.string);
+	str_del((f->sp++)->u.string);
+	f->sp->u.string = str;
+	return 0;
+    }
+    str = str_add(str, f->sp->u.string);
     str_del(f->sp->u.string);
     f->sp++;
     str_del(f->sp->u.string);
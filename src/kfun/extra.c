@@ -219,7 +219,14 @@ int kf_explode(frame *f)
 	    p += len;
 	}
 	/* final array element */
-	PUT_STRVAL(v, str_new(p - size, (long) size));
+	if (size == f->sp[1].u.string->len) {
+	    /* no separators: share the string */
+	    PUT_STRVAL(v, f->sp[1].u.string);
+	} else {
+	    len = p - f->sp[1].u.string->text;
+	    PUT_STRVAL(v, str_range(f->sp[1].u.string, (long) len - size,
+				    (long) len - 1));
+	}
     }
 
     str_del((f->sp++)->u.string);
@@ -265,7 +272,8 @@ int kf_implode(frame *f)
 	    }
 	    len += v->u.string->len;
 	}
-	str = str_new((char *) NULL, len);
+	/* leave room to append to the result in place */
+	str = str_extend(str_new((char *) NULL, 0L), len);
 
 	/* create the imploded string */
 	p = str->text;
@@ -292,6 +300,169 @@ int kf_implode(frame *f)
 # endif
 
 
+# ifdef FUNCDEF
+FUNCDEF("sort_array", kf_sort_array, pt_sort_array, 0)
+# else
+# ifdef CLOSURES
+extern int kf_call_function (frame*, int);
+
+char pt_sort_array[] = { C_TYPECHECKED | C_STATIC, 1, 1, 0, 8,
+			 T_MIXED | (1 << REFSHIFT), T_MIXED | (1 << REFSHIFT),
+			 T_OBJECT };
+
+/*
+ * NAME:	sort_compare()
+ * DESCRIPTION:	compare two values with a function
+ */
+static Int sort_compare(frame *f, value *func, value *v1, value *v2)
+{
+    Int c;
+
+    i_grow_stack(f, 3);
+    i_push_value(f, func);
+    i_push_value(f, v1);
+    i_push_value(f, v2);
+    kf_call_function(f, 3);
+    if (f->sp->type != T_INT) {
+	error("Bad comparison result for kfun sort_array");
+    }
+    c = (f->sp++)->u.number;
+    return c;
+}
+
+/*
+ * NAME:	sort_merge()
+ * DESCRIPTION:	stable merge sort of element indices, with a comparison
+ *		function; return the buffer holding the result
+ */
+static Uint *sort_merge(frame *f, value *func, value *elts, Uint *src,
+			Uint *dst, Uint size)
+{
+    Uint width, lo, mid, hi, i, j, k;
+    Uint *tmp;
+
+    for (width = 1; width < size; width <<= 1) {
+	for (lo = 0; lo < size; lo = hi) {
+	    mid = (lo + width < size) ? lo + width : size;
+	    hi = (mid + width < size) ? mid + width : size;
+	    i = lo;
+	    j = mid;
+	    k = lo;
+	    if (j < hi &&
+		sort_compare(f, func, &elts[src[j]], &elts[src[j - 1]]) >= 0) {
+		/* halves already in order */
+		j = hi;
+	    }
+	    while (i < mid && j < hi) {
+		if (sort_compare(f, func, &elts[src[j]], &elts[src[i]]) < 0) {
+		    dst[k++] = src[j++];
+		} else {
+		    dst[k++] = src[i++];
+		}
+	    }
+	    while (i < mid) {
+		dst[k++] = src[i++];
+	    }
+	    while (k < hi) {
+		dst[k] = src[k];
+		k++;
+	    }
+	}
+	tmp = src;
+	src = dst;
+	dst = tmp;
+    }
+
+    return src;
+}
+# else
+char pt_sort_array[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7,
+			 T_MIXED | (1 << REFSHIFT), T_MIXED | (1 << REFSHIFT) };
+# endif
+
+/*
+ * NAME:	kfun->sort_array()
+ * DESCRIPTION:	return a sorted copy of an array
+ */
+int kf_sort_array(frame *f, int nargs)
+{
+    array *a;
+    Uint size, n;
+    Int ticks;
+# ifdef CLOSURES
+    value func, *v;
+    Uint *index, *buf, *sorted;
+
+    if (nargs == 2) {
+	if (f->sp->type != T_NIL) {
+	    if (f->sp->type != T_LWOBJECT ||
+		(v=d_get_elts(f->sp->u.array))[0].type != T_INT ||
+		v[0].u.number != BUILTIN_FUNCTION) {
+		return 2;
+	    }
+
+	    /*
+	     * sort a private copy of the array, so that the comparison
+	     * function cannot change it in the meanwhile
+	     */
+	    func = *f->sp;
+	    size = f->sp[1].u.array->size;
+	    a = arr_new(f->data, (long) size);
+	    i_copy(a->elts, d_get_elts(f->sp[1].u.array), size);
+	    d_ref_imports(a);
+	    PUSH_ARRVAL(f, a);
+	    i_add_ticks(f, size);
+
+	    if (size > 1) {
+		index = ALLOC(Uint, size);
+		buf = ALLOC(Uint, size);
+		for (n = 0; n < size; n++) {
+		    index[n] = n;
+		}
+		if (ec_push((ec_ftn) NULL)) {
+		    FREE(buf);
+		    FREE(index);
+		    error((char *) NULL);	/* pass on the error */
+		}
+		sorted = sort_merge(f, &func, a->elts, index, buf, size);
+		ec_pop();
+
+		/* put the elements in sorted order */
+		v = ALLOC(value, size);
+		for (n = 0; n < size; n++) {
+		    v[n] = a->elts[sorted[n]];
+		}
+		memcpy(a->elts, v, size * sizeof(value));
+		FREE(v);
+		FREE(buf);
+		FREE(index);
+	    }
+
+	    f->sp++;
+	    i_del_value(f->sp++);
+	    arr_del(f->sp->u.array);
+	    PUT_ARRVAL_NOREF(f->sp, a);
+	    return 0;
+	}
+	f->sp++;
+    }
+# else
+    UNREFERENCED_PARAMETER(nargs);
+# endif
+
+    size = f->sp->u.array->size;
+    for (ticks = size, n = size; n > 1; n >>= 1) {
+	ticks += size;
+    }
+    i_add_ticks(f, ticks);
+    a = arr_sort(f->data, f->sp->u.array);
+    arr_del(f->sp->u.array);
+    PUT_ARRVAL(f->sp, a);
+    return 0;
+}
+# endif
+
+
 # ifdef FUNCDEF
 FUNCDEF("random", kf_random, pt_random, 0)
 # else
@@ -538,7 +709,14 @@ int kf_sscanf(frame *f, int nargs)
 		    error("No lvalue for %%s");
 		}
 		--nargs;
-		PUSH_STRVAL(f, str_new(s, (long) size));
+		if (size == top[1].u.string->len) {
+		    /* the whole string */
+		    PUSH_STRVAL(f, top[1].u.string);
+		} else {
+		    sl = s - top[1].u.string->text;
+		    PUSH_STRVAL(f, str_range(top[1].u.string, (long) sl,
+					     (long) sl + size - 1));
+		}
 		v = f->sp;
 		i_store(f);
 		v->u.string->ref--;
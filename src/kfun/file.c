@@ -203,7 +203,7 @@ static void save_array(savecontext *x, array *a)
     }
     x->narrays++;
 
-    sprintf(buf, "({%d|", a->size);
+    sprintf(buf, "({%lu|", (unsigned long) a->size);
     put(x, buf, strlen(buf));
     for (i = a->size, v = d_get_elts(a); i > 0; --i, v++) {
 	switch (v->type) {
@@ -258,7 +258,7 @@ static void save_mapping(savecontext *x, array *a)
 {
     char buf[18];
     Uint i;
-    uindex n;
+    asizet n;
     value *v;
     xfloat flt;
 
@@ -289,7 +289,7 @@ static void save_mapping(savecontext *x, array *a)
 	}
 	v++;
     }
-    sprintf(buf, "([%d|", n);
+    sprintf(buf, "([%lu|", (unsigned long) n);
     put(x, buf, strlen(buf));
 
     for (i = a->size >> 1, v = a->elts; i > 0; --i) {
@@ -710,7 +710,7 @@ static char *restore_mapping	(restcontext*, char*, value*);
  */
 static char *restore_array(restcontext *x, char *buf, value *val)
 {
-    unsigned short i;
+    asizet i;
     value *v;
     array *a;
     
@@ -760,7 +760,7 @@ static char *restore_array(restcontext *x, char *buf, value *val)
  */
 static char *restore_mapping(restcontext *x, char *buf, value *val)
 {
-    unsigned short i;
+    asizet i;
     value *v;
     array *a;
     
@@ -1174,8 +1174,9 @@ char pt_read_file[] = { C_TYPECHECKED | C_STATIC, 1, 2, 0, 9, T_STRING,
  */
 int kf_read_file(frame *f, int nargs)
 {
-    char file[STRINGSZ], *buf;
+    char file[STRINGSZ];
     struct stat sbuf;
+    string *str;
     Int l, size;
     static int fd;
 
@@ -1237,22 +1238,16 @@ int kf_read_file(frame *f, int nargs)
 	P_close(fd);
 	error("String too long");
     }
-    buf = (size != 0) ? ALLOCA(char, size) : (char *) NULL;
-    if (size > 0 && (size=P_read(fd, buf, (unsigned int) size)) < 0) {
+    /* read directly into the string, which may be large */
+    PUT_STRVAL(f->sp, str = str_new((char *) NULL, size));
+    if (size > 0 && (size=P_read(fd, str->text, (unsigned int) size)) < 0) {
 	/* read failed */
 	P_close(fd);
-	if (buf != (char *) NULL) {
-	    AFREE(buf);
-	}
 	error("Read failed in read_file()");
     }
     P_close(fd);
     i_add_ticks(f, 2 * size);
-
-    PUT_STRVAL(f->sp, str_new((char *) buf, size));
-    if (buf != (char *) NULL) {
-	AFREE(buf);
-    }
+    str->text[str->len = size] = '\0';
 
     return 0;
 }
@@ -766,17 +766,11 @@ char pt_allocate_int[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7,
  */
 int kf_allocate_int(frame *f)
 {
-    int i;
-    value *v;
-
     if (f->sp->u.number < 0) {
 	return 1;
     }
     i_add_ticks(f, f->sp->u.number);
-    PUT_ARRVAL(f->sp, arr_new(f->data, (long) f->sp->u.number));
-    for (i = f->sp->u.array->size, v = f->sp->u.array->elts; i > 0; --i, v++) {
-	*v = zero_int;
-    }
+    PUT_ARRVAL(f->sp, arr_new_packed(f->data, (long) f->sp->u.number, T_INT));
     return 0;
 }
 # endif
@@ -794,17 +788,11 @@ char pt_allocate_float[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7,
  */
 int kf_allocate_float(frame *f)
 {
-    int i;
-    value *v;
-
     if (f->sp->u.number < 0) {
 	return 1;
     }
     i_add_ticks(f, f->sp->u.number);
-    PUT_ARRVAL(f->sp, arr_new(f->data, (long) f->sp->u.number));
-    for (i = f->sp->u.array->size, v = f->sp->u.array->elts; i > 0; --i, v++) {
-	*v = zero_float;
-    }
+    PUT_ARRVAL(f->sp, arr_new_packed(f->data, (long) f->sp->u.number, T_FLOAT));
     return 0;
 }
 # endif
@@ -822,7 +810,7 @@ char pt_sizeof[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_INT,
  */
 int kf_sizeof(frame *f)
 {
-    unsigned short size;
+    asizet size;
 
     size = f->sp->u.array->size;
     arr_del(f->sp->u.array);
@@ -890,7 +878,7 @@ char pt_map_sizeof[] = { C_TYPECHECKED | C_STATIC, 1, 0, 0, 7, T_INT,
  */
 int kf_map_sizeof(frame *f)
 {
-    unsigned short size;
+    asizet size;
 
     i_add_ticks(f, f->sp->u.array->size);
     size = map_size(f->data, f->sp->u.array);
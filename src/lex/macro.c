@@ -86,7 +86,7 @@ void mc_clear()
  */
 void mc_define(char *name, char *replace, int narg)
 {
-    macro **m;
+    macro **m, *mac;
 
     m = (macro **) ht_lookup(mt, name, FALSE);
     if (*m != (macro *) NULL) {
@@ -98,7 +98,7 @@ void mc_define(char *name, char *replace, int narg)
     } else {
 	if (flist != (macro *) NULL) {
 	    /* get macro from free list */
-	    *m = flist;
+	    mac = flist;
 	    flist = (macro *) flist->chain.next;
 	} else {
 	    /* allocate new macro */
@@ -110,9 +110,9 @@ void mc_define(char *name, char *replace, int narg)
 		mlist = l;
 		mchunksz = 0;
 	    }
-	    *m = &mlist->m[mchunksz++];
+	    mac = &mlist->m[mchunksz++];
 	}
-	(*m)->chain.next = (hte *) NULL;
+	ht_insert(mt, (hte **) m, (hte *) mac);
 	(*m)->chain.name = strcpy(ALLOC(char, strlen(name) + 1), name);
 	(*m)->replace = (char *) NULL;
     }
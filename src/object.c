@@ -25,6 +25,7 @@
 # include "object.h"
 # include "interpret.h"
 # include "data.h"
+# include "call_out.h"
 
 typedef struct _objplane_ objplane;
 
@@ -63,11 +64,12 @@ struct _objplane_ {
     struct _objplane_ *prev;	/* previous object plane */
 };
 
-object *otable;			/* object table */
+object **otable;		/* object table segments */
 char *ocmap;			/* object change map */
 bool obase;			/* object base plane flag */
 bool swap, dump, stop;		/* global state vars */
 static uindex otabsize;		/* size of object table */
+static Uint osegs;		/* # object table segments */
 static uindex uobjects;		/* objects to check for upgrades */
 static objplane baseplane;	/* base object plane */
 static objplane *oplane;	/* current object plane */
@@ -75,6 +77,9 @@ static char *omap;		/* object dump bitmap */
 static Uint *counttab;		/* object count table */
 static object *upgraded;	/* list of upgraded objects */
 static uindex dobjects, dobject;/* objects to copy */
+static uindex *cobjs;		/* objects with callouts, copied first */
+static uindex ncobjs, cobj;	/* # objects with callouts, next to copy */
+static uindex dahead;		/* # objects to copy already read ahead */
 static uindex mobjects;		/* max objects to copy */
 static uindex dchunksz;		/* copy chunk size */
 static Uint dinterval;		/* copy interval */
@@ -82,16 +87,55 @@ static Uint dtime;		/* time copying started */
 Uint odcount;			/* objects destructed count */
 static uindex rotabsize;	/* size of object table at restore */
 
+/*
+ * NAME:	object->grow()
+ * DESCRIPTION:	grow the object table to hold at least n objects, adding
+ *		segments so that existing objects are not moved
+ */
+static void o_grow(Uint n)
+{
+    Uint size, nsegs;
+
+    size = otabsize + (otabsize >> 1);
+    if (size < n) {
+	size = n;
+    }
+    nsegs = (size + OBJ_SEGSZ - 1) >> OBJ_SEGBITS;
+    size = nsegs << OBJ_SEGBITS;
+    if (size > UINDEX_MAX) {
+	size = UINDEX_MAX;	/* OBJ_NONE is not a valid index */
+    }
+
+    m_static();
+    otable = REALLOC(otable, object*, osegs, nsegs);
+    while (osegs < nsegs) {
+	otable[osegs] = ALLOC(object, OBJ_SEGSZ);
+	memset(otable[osegs++], '\0', OBJ_SEGSZ * sizeof(object));
+    }
+    ocmap = REALLOC(ocmap, char, (otabsize + 7) >> 3, (size + 7) >> 3);
+    memset(ocmap + ((otabsize + 7) >> 3), '\0',
+	   ((size + 7) >> 3) - ((otabsize + 7) >> 3));
+    omap = REALLOC(omap, char, (otabsize + 7) >> 3, (size + 7) >> 3);
+    memset(omap + ((otabsize + 7) >> 3), '\0',
+	   ((size + 7) >> 3) - ((otabsize + 7) >> 3));
+    counttab = REALLOC(counttab, Uint, otabsize, size);
+    m_dynamic();
+
+    otabsize = size;
+}
+
 /*
  * NAME:	object->init()
  * DESCRIPTION:	initialize the object tables
  */
 void o_init(unsigned int n, Uint interval)
 {
-    otable = ALLOC(object, otabsize = n);
-    memset(otable, '\0', n * sizeof(object));
-    ocmap = ALLOC(char, (n + 7) >> 3);
-    memset(ocmap, '\0', (n + 7) >> 3);
+    otable = (object **) NULL;
+    ocmap = omap = (char *) NULL;
+    counttab = (Uint *) NULL;
+    otabsize = 0;
+    osegs = 0;
+    o_grow(n);
     for (n = 4; n < otabsize; n <<= 1) ;
     baseplane.htab = ht_new(n >> 2, OBJHASHSZ, FALSE);
     baseplane.optab = (optable *) NULL;
@@ -102,9 +146,6 @@ void o_init(unsigned int n, Uint interval)
     baseplane.ocount = 3;
     baseplane.swap = baseplane.dump = baseplane.stop = FALSE;
     oplane = &baseplane;
-    omap = ALLOC(char, (n + 7) >> 3);
-    memset(omap, '\0', (n + 7) >> 3);
-    counttab = ALLOC(Uint, n);
     upgraded = (object *) NULL;
     uobjects = dobjects = mobjects = 0;
     dinterval = (interval * 19) / 20;
@@ -249,8 +290,7 @@ static object *o_oaccess(unsigned int index, int access)
 		    oplane->htab = ht_new(OBJPATCHHTABSZ, OBJHASHSZ, FALSE);
 		}
 		h = ht_lookup(oplane->htab, name, FALSE);
-		obj->chain.next = *h;
-		*h = (hte *) obj;
+		ht_insert(oplane->htab, h, (hte *) obj);
 	    }
 	}
 	return obj;
@@ -281,7 +321,7 @@ object *o_owrite(unsigned int index)
  */
 bool o_space()
 {
-    return (oplane->free != OBJ_NONE) ? TRUE : (oplane->nobjects != otabsize);
+    return (oplane->free != OBJ_NONE) ? TRUE : (oplane->nobjects != UINDEX_MAX);
 }
 
 /*
@@ -302,7 +342,10 @@ static object *o_alloc()
     } else {
 	/* use new space in object table */
 	if (oplane->nobjects == otabsize) {
-	    error("Too many objects");
+	    if (otabsize == UINDEX_MAX) {
+		error("Too many objects");
+	    }
+	    o_grow((Uint) otabsize + 1);
 	}
 	n = oplane->nobjects++;
 	obj = OBJW(n);
@@ -617,8 +660,7 @@ object *o_new(char *name, control *ctrl)
 	oplane->htab = ht_new(OBJPATCHHTABSZ, OBJHASHSZ, FALSE);
     }
     h = ht_lookup(oplane->htab, name, FALSE);
-    o->chain.next = *h;
-    *h = (hte *) o;
+    ht_insert(oplane->htab, h, (hte *) o);
 
     o->flags = O_MASTER;
     o->cref = 0;
@@ -913,12 +955,15 @@ object *o_find(char *name, int access)
 	    return (object *) NULL;
 	}
     } else {
-	/* look it up in the hash table */
+	Uuint h;
+
+	/* look it up in the hash table, hashing the name only once */
+	h = ht_hash(baseplane.htab, name);
 	if (oplane->htab == (hashtab *) NULL ||
-	    (o = (object *) *ht_lookup(oplane->htab, name, TRUE)) ==
+	    (o = (object *) *ht_hlookup(oplane->htab, name, h, TRUE)) ==
 							    (object *) NULL) {
 	    if (oplane != &baseplane) {
-		o = (object *) *ht_lookup(baseplane.htab, name, FALSE);
+		o = (object *) *ht_hlookup(baseplane.htab, name, h, FALSE);
 		if (o != (object *) NULL) {
 		    number = o->index;
 		    o = (access == OACC_READ)? OBJR(number) : OBJW(number);
@@ -1199,6 +1244,15 @@ uindex o_count()
     return oplane->nobjects - oplane->nfreeobjs;
 }
 
+/*
+ * NAME:	object->tabsize()
+ * DESCRIPTION:	return the current size of the object table
+ */
+uindex o_tabsize()
+{
+    return otabsize;
+}
+
 
 typedef struct {
     uindex free;	/* free object list */
@@ -1219,11 +1273,13 @@ static void o_sweep(uindex n)
 {
     Uint count, *ct;
     object *obj;
+    uindex i;
 
     uobjects = n;
-    dobject = 0;
+    dobject = dahead = 0;
     count = 3;
-    for (obj = otable, ct = counttab; n > 0; obj++, ct++, --n) {
+    for (i = 0, ct = counttab; i < n; i++, ct++) {
+	obj = OBJ(i);
 	if (obj->count != 0) {
 	    if (obj->cfirst != SW_UNUSED || obj->dfirst != SW_UNUSED) {
 		BSET(omap, obj->index);
@@ -1290,7 +1346,7 @@ void o_trim()
     /* 1. prepare a list of free objects */
     for (i = 0; i < baseplane.nfreeobjs; i++) {
         entries[i] = j;
-        j = otable[j].prev;
+        j = OBJ(j)->prev;
     }
 
     /* 2. sort indices from low to high */
@@ -1303,14 +1359,16 @@ void o_trim()
 	baseplane.nfreeobjs--;
     }
 
-    memset(otable + baseplane.nobjects, '\0', npurge * sizeof(object));
+    for (i = baseplane.nobjects; npurge > 0; i++, --npurge) {
+	memset(OBJ(i), '\0', sizeof(object));
+    }
 
     /* 4. relink remaining free objects from low to high */
     j = OBJ_NONE;
 
     for (i = 0; i < baseplane.nfreeobjs; i++) {
 	uindex n = entries[baseplane.nfreeobjs - i - 1];
-	otable[n].prev = j;
+	OBJ(n)->prev = j;
 	j = n;
     }
 
@@ -1324,7 +1382,7 @@ void o_trim()
  */
 bool o_dump(int fd)
 {
-    uindex i;
+    uindex i, n;
     object *o;
     unsigned int len, buflen;
     dump_header dh;
@@ -1335,21 +1393,29 @@ bool o_dump(int fd)
     dh.nobjects = baseplane.nobjects;
     dh.nfreeobjs = baseplane.nfreeobjs;
     dh.onamelen = 0;
-    for (i = baseplane.nobjects, o = otable; i > 0; --i, o++) {
+    for (i = 0; i < baseplane.nobjects; i++) {
+	o = OBJ(i);
 	if (o->chain.name != (char *) NULL) {
 	    dh.onamelen += strlen(o->chain.name) + 1;
 	}
     }
 
-    /* write header and objects */
-    if (P_write(fd, (char *) &dh, sizeof(dump_header)) < 0 ||
-	P_write(fd, (char *) otable, baseplane.nobjects * sizeof(object)) < 0) {
+    /* write header and objects, one table segment at a time */
+    if (P_write(fd, (char *) &dh, sizeof(dump_header)) < 0) {
 	return FALSE;
     }
+    for (i = 0; i < baseplane.nobjects; i += n) {
+	n = (baseplane.nobjects - i > OBJ_SEGSZ) ?
+	     OBJ_SEGSZ : baseplane.nobjects - i;
+	if (P_write(fd, (char *) OBJ(i), n * sizeof(object)) < 0) {
+	    return FALSE;
+	}
+    }
 
     /* write object names */
     buflen = 0;
-    for (i = baseplane.nobjects, o = otable; i > 0; --i, o++) {
+    for (i = 0; i < baseplane.nobjects; i++) {
+	o = OBJ(i);
 	if (o->chain.name != (char *) NULL) {
 	    len = strlen(o->chain.name) + 1;
 	    if (buflen + len > CHUNKSZ) {
@@ -1375,7 +1441,7 @@ bool o_dump(int fd)
  */
 void o_restore(int fd, unsigned int rlwobj)
 {
-    uindex i;
+    uindex i, n;
     object *o;
     Uint len, buflen;
     char *p;
@@ -1387,7 +1453,8 @@ void o_restore(int fd, unsigned int rlwobj)
     /*
      * Free object names of precompiled objects.
      */
-    for (i = baseplane.nobjects, o = otable; i > 0; --i, o++) {
+    for (i = 0; i < baseplane.nobjects; i++) {
+	o = OBJ(i);
 	*ht_lookup(baseplane.htab, o->chain.name, FALSE) = o->chain.next;
 	FREE(o->chain.name);
     }
@@ -1396,17 +1463,21 @@ void o_restore(int fd, unsigned int rlwobj)
     conf_dread(fd, (char *) &dh, dh_layout, (Uint) 1);
 
     if (dh.nobjects > otabsize) {
-	error("Too many objects in restore file (%u)", dh.nobjects);
+	o_grow((Uint) dh.nobjects);
     }
 
-    conf_dread(fd, (char *) otable, OBJ_LAYOUT, (Uint) dh.nobjects);
+    for (i = 0; i < dh.nobjects; i += n) {
+	n = (dh.nobjects - i > OBJ_SEGSZ) ? OBJ_SEGSZ : dh.nobjects - i;
+	conf_dread(fd, (char *) OBJ(i), OBJ_LAYOUT, (Uint) n);
+    }
     baseplane.free = dh.free;
     baseplane.nobjects = dh.nobjects;
     baseplane.nfreeobjs = dh.nfreeobjs;
 
     /* read object names */
     buflen = 0;
-    for (i = 0, o = otable; i < baseplane.nobjects; i++, o++) {
+    for (i = 0; i < baseplane.nobjects; i++) {
+	o = OBJ(i);
 	if (rlwobj != 0) {
 	    o->flags &= ~O_LWOBJ;
 	}
@@ -1438,8 +1509,7 @@ void o_restore(int fd, unsigned int rlwobj)
 
 		/* add name to lookup table */
 		h = ht_lookup(baseplane.htab, p, FALSE);
-		o->chain.next = *h;
-		*h = (hte *) o;
+		ht_insert(baseplane.htab, h, (hte *) o);
 
 		/* fix O_LWOBJ */
 		if (o->cref & rlwobj) {
@@ -1468,13 +1538,92 @@ void o_restore(int fd, unsigned int rlwobj)
     rotabsize = baseplane.nobjects;
 }
 
+/*
+ * NAME:	object->callouts()
+ * DESCRIPTION:	collect the objects with callouts, which are copied from
+ *		the dump before the others
+ */
+static void o_callouts()
+{
+    uindex i, n;
+
+    if (cobjs != (uindex *) NULL) {
+	FREE(cobjs);
+    }
+    m_static();
+    ncobjs = co_objects(&cobjs);
+    m_dynamic();
+    if (ncobjs > 1) {
+	qsort(cobjs, ncobjs, sizeof(uindex), uindex_compare);
+	for (i = n = 1; i < ncobjs; i++) {
+	    if (cobjs[i] != cobjs[n - 1]) {
+		cobjs[n++] = cobjs[i];
+	    }
+	}
+	ncobjs = n;
+    }
+    cobj = 0;
+}
+
+/*
+ * NAME:	object->next_copy()
+ * DESCRIPTION:	find the next object to copy from the dump, continuing at
+ *		*c in the list of objects with callouts, and at *o in the
+ *		object table
+ */
+static object *o_next_copy(uindex *c, uindex *o)
+{
+    object *obj;
+
+    while (*c < ncobjs) {
+	obj = OBJ(cobjs[*c]);
+	(*c)++;
+	if (BTST(omap, obj->index)) {
+	    return obj;
+	}
+    }
+    while (*o < uobjects) {
+	obj = OBJ(*o);
+	(*o)++;
+	if (BTST(omap, obj->index)) {
+	    return obj;
+	}
+    }
+    return (object *) NULL;
+}
+
+/*
+ * NAME:	object->prefetch()
+ * DESCRIPTION:	skip the objects to be copied next, and read ahead the
+ *		count objects following them.  Return the number of objects
+ *		skipped and read ahead
+ */
+static uindex o_prefetch(uindex skip, uindex count)
+{
+    uindex c, o, n;
+    object *obj;
+
+    c = cobj;
+    o = dobject;
+    for (n = 0; n < skip + count; n++) {
+	obj = o_next_copy(&c, &o);
+	if (obj == (object *) NULL) {
+	    break;
+	}
+	if (n >= skip) {
+	    d_prefetch_obj(obj);
+	}
+    }
+    return n;
+}
+
 /*
  * NAME:	object->copy()
  * DESCRIPTION:	copy objects from dump to swap
  */
 bool o_copy(Uint time)
 {
-    uindex n;
+    uindex n, w;
     object *obj, *tmpl;
 
     if (dobjects != 0) {
@@ -1492,6 +1641,7 @@ bool o_copy(Uint time)
 			dchunksz = 1;
 		    }
 		}
+		o_callouts();
 	    }
 
 	    time -= dtime;
@@ -1505,19 +1655,34 @@ bool o_copy(Uint time)
 	    }
 	}
 
+	/*
+	 * keep a window of objects read ahead, so the OS can fetch them
+	 * from the dump while the current ones are restored
+	 */
+	w = (time == 0) ? SWAPCHUNKSZ : dchunksz;
 	while (dobjects > n) {
-	    for (obj = OBJ(dobject); !BTST(omap, obj->index); obj++) ;
-	    dobject = obj->index + 1;
+	    if (dahead <= w / 2) {
+		dahead = o_prefetch(dahead, w - dahead);
+	    }
+	    obj = o_next_copy(&cobj, &dobject);
 	    o_restore_obj(obj, FALSE, FALSE);
+	    if (dahead != 0) {
+		--dahead;
+	    }
 	    if (time == 0) {
 		d_swapout(1);
 	    }
 	}
+	if (dobjects != 0 && dahead < w) {
+	    /* read ahead the next chunk while idle */
+	    dahead = o_prefetch(dahead, w - dahead);
+	}
     }
     o_clean();
 
     if (dobjects == 0) {
-	for (n = uobjects, obj = otable; n > 0; --n, obj++) {
+	for (n = 0; n < uobjects; n++) {
+	    obj = OBJ(n);
 	    if (obj->count != 0 && (obj->flags & O_LWOBJ)) {
 		tmpl = obj;
 		while (tmpl->prev != OBJ_NONE && counttab[tmpl->prev] != 2) {
@@ -1532,6 +1697,11 @@ bool o_copy(Uint time)
 
 	d_converted();
 	dtime = 0;
+	if (cobjs != (uindex *) NULL) {
+	    FREE(cobjs);
+	    cobjs = (uindex *) NULL;
+	}
+	ncobjs = 0;
 	return FALSE;
     } else {
 	return TRUE;
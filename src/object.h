@@ -51,9 +51,12 @@ struct _object_ {
 
 # define OBJ_LAYOUT		"xceuuuiiippdd"
 
-# define OBJ(i)			(&otable[i])
-# define OBJR(i)		((BTST(ocmap, (i))) ? o_oread((i)) : &otable[i])
-# define OBJW(i)		((!obase) ? o_owrite((i)) : &otable[i])
+# define OBJ_SEGBITS		10
+# define OBJ_SEGSZ		(1 << OBJ_SEGBITS)	/* objects per table segment */
+
+# define OBJ(i)			(&otable[(i) >> OBJ_SEGBITS][(i) & (OBJ_SEGSZ - 1)])
+# define OBJR(i)		((BTST(ocmap, (i))) ? o_oread((i)) : OBJ(i))
+# define OBJW(i)		((!obase) ? o_owrite((i)) : OBJ(i))
 
 # define O_UPGRADING(o)		((o)->cref > (o)->u_ref)
 # define O_INHERITED(o)		((o)->u_ref - 1 != (o)->cref)
@@ -88,6 +91,7 @@ extern dataspace *o_dataspace		(object*);
 
 extern void	  o_clean		(void);
 extern uindex	  o_count		(void);
+extern uindex	  o_tabsize		(void);
 extern bool	  o_dump		(int);
 extern void	  o_restore		(int, unsigned int);
 extern bool	  o_copy		(Uint);
@@ -96,7 +100,7 @@ extern void	  swapout		(void);
 extern void	  dump_state		(void);
 extern void	  finish		(void);
 
-extern object    *otable;
+extern object   **otable;
 extern char	 *ocmap;
 extern bool	  obase, swap, dump, stop;
 extern Uint	  odcount;
@@ -213,8 +213,7 @@ static rgxposn *rp_alloc(hashtab *htab, char *posn, unsigned short size, rpchunk
 	x->chunksz = 0;
     }
     rp = &(*c)->rp[(*c)->chunksz++];
-    rp->chain.next = (hte *) *rrp;
-    *rrp = rp;
+    ht_insert(htab, (hte **) rrp, (hte *) rp);
     rp->chain.name = posn;
     rp->rgx = rgx;
     rp->size = size;
@@ -839,8 +839,7 @@ string *parse_grammar(string *gram)
 		rl = rl_new(&rlchunks, RULE_REGEXP);
 		str_ref(rl->symb = str_new(buffer, (long) buflen));
 		rl->chain.name = rl->symb->text;
-		rl->chain.next = (hte *) *r;
-		*r = rl;
+		ht_insert(ruletab, (hte **) r, (hte *) rl);
 		size += 4;
 		nrgx++;
 
@@ -926,8 +925,7 @@ string *parse_grammar(string *gram)
 		rl = rl_new(&rlchunks, RULE_PROD);
 		str_ref(rl->symb = str_new(buffer, (long) buflen));
 		rl->chain.name = rl->symb->text;
-		rl->chain.next = (hte *) *r;
-		*r = rl;
+		ht_insert(ruletab, (hte **) r, (hte *) rl);
 		size += 4;
 		nprod++;
 
@@ -951,8 +949,7 @@ string *parse_grammar(string *gram)
 			rl = rl_new(&rlchunks, RULE_UNKNOWN);
 			str_ref(rl->symb = str_new(buffer, (long) buflen));
 			rl->chain.name = rl->symb->text;
-			rl->chain.next = (hte *) *r;
-			*r = rl;
+			ht_insert(ruletab, (hte **) r, (hte *) rl);
 
 			rl->next = tmplist;
 			if (tmplist != (rule *) NULL) {
@@ -986,8 +983,7 @@ string *parse_grammar(string *gram)
 			rl = rl_new(&rlchunks, RULE_STRING);
 			str_ref(rl->symb = str_new(buffer, (long) buflen));
 			rl->chain.name = rl->symb->text;
-			rl->chain.next = (hte *) *r;
-			*r = rl;
+			ht_insert(strtab, (hte **) r, (hte *) rl);
 
 			if (token == TOK_STRING) {
 			    size += 4;
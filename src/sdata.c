@@ -173,6 +173,18 @@ typedef struct {
 
 static char sd_layout[] = "dssiiiiuu";
 
+typedef struct {
+    Uint varoffset;		/* offset of variables */
+    Uint arroffset;		/* offset of array table */
+    Uint eltoffset;		/* offset of array elements */
+    Uint stroffset;		/* offset of string table */
+    Uint txtoffset;		/* offset of string text */
+    Uint cooffset;		/* offset of callouts */
+    Uint size;			/* size including room to grow */
+} sdataoffsets;
+
+static char so_layout[] = "iiiiiii";
+
 struct _svalue_ {
     char type;			/* object, number, string, array */
     char pad;			/* 0 */
@@ -206,12 +218,20 @@ static char oosv_layout[] = "sui";
 typedef struct _sarray_ {
     Uint index;			/* index in array value table */
     char type;			/* array type */
-    unsigned short size;	/* size of array */
+    asizet size;		/* size of array */
     Uint ref;			/* refcount */
     Uint tag;			/* unique value for each array */
 } sarray;
 
-static char sa_layout[] = "icsii";
+static char sa_layout[] = "icaii";
+
+# define SA_PACKED	0x10	/* in sarray->type: elements are packed Ints */
+# define SA_PACKFLT	0x20	/* in sarray->type: elements are packed floats */
+# define SA_PKTYPE(sa)	(((sa)->type & SA_PACKED) ? T_INT :		\
+			 ((sa)->type & SA_PACKFLT) ? T_FLOAT : T_NIL)
+# define PACKSIZE(t, n)	((PKD_SIZE(t, n) + sizeof(svalue) - 1) / sizeof(svalue))
+# define SA_SLOTS(sa)	((SA_PKTYPE(sa) != T_NIL) ?			\
+			 PACKSIZE(SA_PKTYPE(sa), (sa)->size) : (Uint) (sa)->size)
 
 typedef struct {
     Uint index;			/* index in array value table */
@@ -293,6 +313,10 @@ typedef struct {
     char *stext;			/* save string elements */
     bool counting;			/* currently counting */
     array alist;			/* linked list sentinel */
+    string **slist;			/* strings in the order counted */
+    Uint slistsz;			/* size of string list */
+    Uint *amap;				/* stable array indices */
+    Uint *smap;				/* stable string indices */
 } savedata;
 
 static control *chead, *ctail;		/* list of control blocks */
@@ -308,14 +332,30 @@ static bool conv_inherit;		/* convert inherits? */
 static bool conv_time;			/* convert time? */
 static bool conv_vm;			/* convert VM? */
 static bool converted;			/* conversion complete? */
+static int cmptype;			/* compression for saved blocks */
+static Uint budget;			/* swapout memory budget, or 0 */
+static Uint swaptime;			/* # swapout rounds */
+static size_t nswapdata, nswapctrl;	/* # blocks swapped out */
+static size_t swapmem;			/* memory freed by swapping out */
+static unsigned int gcslice;		/* idle garbage collection slice */
+static sector gcleft;			/* # dataspaces left in cycle */
+static sector gcclean;			/* # clean dataspaces in a row */
+static size_t ngcdata, ngccycles;	/* garbage collection statistics */
 
 
 /*
  * NAME:	data->init()
  * DESCRIPTION:	initialize swapped data handling
  */
-void d_init()
+void d_init(int compression, Uint swapbudget, unsigned int slice)
 {
+    cmptype = compression;
+    budget = swapbudget;
+    swaptime = 0;
+    nswapdata = nswapctrl = swapmem = 0;
+    gcslice = slice;
+    gcleft = gcclean = 0;
+    ngcdata = ngccycles = 0;
     chead = ctail = (control *) NULL;
     dhead = dtail = (dataspace *) NULL;
     gcdata = (dataspace *) NULL;
@@ -363,6 +403,7 @@ control *d_new_control()
 	chead = ctail = ctrl;
     }
     ctrl->ndata = 0;
+    ctrl->access = swaptime;
     nctrl++;
 
     ctrl->flags = 0;
@@ -428,6 +469,7 @@ static dataspace *d_alloc_dataspace(object *obj)
 	data->gcprev = data->gcnext = data;
     }
     ndata++;
+    data->access = swaptime;
 
     data->iprev = (dataspace *) NULL;
     data->inext = (dataspace *) NULL;
@@ -439,6 +481,7 @@ static dataspace *d_alloc_dataspace(object *obj)
     /* sectors */
     data->nsectors = 0;
     data->sectors = (sector *) NULL;
+    data->datasize = 0;
 
     /* variables */
     data->nvariables = 0;
@@ -470,6 +513,8 @@ static dataspace *d_alloc_dataspace(object *obj)
     data->base.schange = 0;
     data->base.achange = 0;
     data->base.imports = 0;
+    data->base.strmem = 0;
+    data->base.arrmem = 0;
     data->base.alocal.arr = (array *) NULL;
     data->base.alocal.plane = &data->base;
     data->base.alocal.data = data;
@@ -670,30 +715,49 @@ static dataspace *load_dataspace(object *obj, void (*readv) (char*, sector*, Uin
     size += sizeof(sdataspace);
 
     data->flags = header.flags;
-
-    /* variables */
-    data->varoffset = size;
     data->nvariables = header.nvariables;
-    size += data->nvariables * (Uint) sizeof(svalue);
-
-    /* arrays */
-    data->arroffset = size;
     data->narrays = header.narrays;
     data->eltsize = header.eltsize;
-    size += header.narrays * (Uint) sizeof(sarray) +
-	    header.eltsize * sizeof(svalue);
-
-    /* strings */
-    data->stroffset = size;
     data->nstrings = header.nstrings;
     data->strsize = header.strsize;
-    size += header.nstrings * sizeof(sstring) + header.strsize;
-
-    /* callouts */
-    data->cooffset = size;
     data->ncallouts = header.ncallouts;
     data->fcallouts = header.fcallouts;
 
+    if (header.flags & DATA_STABLE) {
+	sdataoffsets offsets;
+
+	/* sections at explicit offsets */
+	(*readv)((char *) &offsets, data->sectors,
+		 (Uint) sizeof(sdataoffsets), size);
+	data->varoffset = offsets.varoffset;
+	data->arroffset = offsets.arroffset;
+	data->eltoffset = offsets.eltoffset;
+	data->stroffset = offsets.stroffset;
+	data->txtoffset = offsets.txtoffset;
+	data->cooffset = offsets.cooffset;
+	data->datasize = offsets.size;
+    } else {
+	/* variables */
+	data->varoffset = size;
+	size += data->nvariables * (Uint) sizeof(svalue);
+
+	/* arrays */
+	data->arroffset = size;
+	size += header.narrays * (Uint) sizeof(sarray);
+	data->eltoffset = size;
+	size += header.eltsize * sizeof(svalue);
+
+	/* strings */
+	data->stroffset = size;
+	size += header.nstrings * sizeof(sstring);
+	data->txtoffset = size;
+	size += header.strsize;
+
+	/* callouts */
+	data->cooffset = size;
+	data->datasize = size + header.ncallouts * (Uint) sizeof(scallout);
+    }
+
     return data;
 }
 
@@ -715,12 +779,30 @@ dataspace *d_load_dataspace(object *obj)
     return data;
 }
 
+/*
+ * NAME:	data->swapped_memory()
+ * DESCRIPTION:	return the memory used by the dataspace of an object that
+ *		is not in memory, from its header in swap
+ */
+void d_swapped_memory(object *obj, Uint *mem)
+{
+    sdataspace header;
+
+    sw_peek((char *) &header, obj->dfirst, (Uint) sizeof(sdataspace));
+    mem[0] = header.nstrings * (Uint) sizeof(string) + header.strsize;
+    mem[1] = header.narrays * (Uint) sizeof(array) +
+	     header.eltsize * (Uint) sizeof(value);
+    mem[2] = 0;
+    mem[3] = header.ncallouts * (Uint) sizeof(dcallout);
+}
+
 /*
  * NAME:	data->ref_control()
  * DESCRIPTION:	reference control block
  */
 void d_ref_control(control *ctrl)
 {
+    ctrl->access = swaptime;
     if (ctrl != chead) {
 	/* move to head of list */
 	ctrl->prev->next = ctrl->next;
@@ -742,6 +824,7 @@ void d_ref_control(control *ctrl)
  */
 void d_ref_dataspace(dataspace *data)
 {
+    data->access = swaptime;
     if (data != dhead) {
 	/* move to head of list */
 	data->prev->next = data->next;
@@ -759,10 +842,10 @@ void d_ref_dataspace(dataspace *data)
 
 
 /*
- * NAME:	compress()
- * DESCRIPTION:	compress data
+ * NAME:	pred_compress()
+ * DESCRIPTION:	compress data with the predictor
  */
-static Uint compress(char *data, char *text, Uint size)
+static Uint pred_compress(char *data, char *text, Uint size)
 {
     char htab[16384];
     unsigned short buf, bufsize, x;
@@ -829,10 +912,10 @@ static Uint compress(char *data, char *text, Uint size)
 }
 
 /*
- * NAME:	decompress()
- * DESCRIPTION:	read and decompress data from the swap file
+ * NAME:	pred_decompress()
+ * DESCRIPTION:	read and decompress predictor data from the swap file
  */
-static char *decompress(sector *sectors, void (*readv) (char*, sector*, Uint, Uint), Uint size, Uint offset, Uint *dsize)
+static char *pred_decompress(sector *sectors, void (*readv) (char*, sector*, Uint, Uint), Uint size, Uint offset, Uint *dsize)
 {
     char buffer[8192], htab[16384];
     unsigned short buf, bufsize, x;
@@ -900,6 +983,210 @@ static char *decompress(sector *sectors, void (*readv) (char*, sector*, Uint, Ui
 }
 
 
+# define LZ_HBITS	12			/* log2 of hash table size */
+# define LZ_MINMATCH	4			/* minimum match length */
+# define LZ_MAXOFFSET	0xffff			/* maximum match offset */
+# define LZ_HASH(p)	((((Uint) UCHAR((p)[0]) | (UCHAR((p)[1]) << 8) |     \
+			   (UCHAR((p)[2]) << 16) |			      \
+			   ((Uint) UCHAR((p)[3]) << 24)) * 2654435761U) >>    \
+			 (32 - LZ_HBITS))
+
+/*
+ * NAME:	lz_length()
+ * DESCRIPTION:	store the part of a length that does not fit in a token
+ */
+static char *lz_length(char *q, Uint len)
+{
+    while (len >= 255) {
+	*q++ = (char) 255;
+	len -= 255;
+    }
+    *q++ = len;
+    return q;
+}
+
+/*
+ * NAME:	lz_compress()
+ * DESCRIPTION:	compress data with LZ.  Each sequence starts with a token
+ *		holding the number of literal bytes and the match length,
+ *		followed by the literal bytes and a 2-byte match offset.
+ *		The last sequence has literals only
+ */
+static Uint lz_compress(char *data, char *text, Uint size)
+{
+    Uint htab[1 << LZ_HBITS];
+    char *p, *m, *lit, *end, *q, *qend, *token;
+    Uint h, len, litlen;
+
+    if (size <= 4 + LZ_MINMATCH) {
+	/* can't get smaller than this */
+	return 0;
+    }
+
+    /* clear the hash table */
+    memset(htab, '\0', sizeof(htab));
+
+    q = data;
+    *q++ = size >> 24;
+    *q++ = size >> 16;
+    *q++ = size >> 8;
+    *q++ = size;
+    qend = data + size;
+
+    p = lit = text;
+    end = text + size;
+    while (p <= end - LZ_MINMATCH) {
+	h = LZ_HASH(p);
+	len = htab[h];
+	htab[h] = p - text + 1;
+	if (len == 0 || p - (m = text + len - 1) > LZ_MAXOFFSET ||
+	    memcmp(m, p, LZ_MINMATCH) != 0) {
+	    p++;
+	    continue;
+	}
+
+	/* find the length of the match */
+	for (len = LZ_MINMATCH; p + len < end && m[len] == p[len]; len++) ;
+
+	/* emit literals and match */
+	litlen = p - lit;
+	if (q + 1 + litlen / 255 + 1 + litlen + 2 + len / 255 + 1 >= qend) {
+	    return 0;	/* out of space */
+	}
+	token = q++;
+	if (litlen >= 15) {
+	    *token = 15 << 4;
+	    q = lz_length(q, litlen - 15);
+	} else {
+	    *token = litlen << 4;
+	}
+	memcpy(q, lit, litlen);
+	q += litlen;
+	*q++ = p - m;
+	*q++ = (p - m) >> 8;
+	if (len - LZ_MINMATCH >= 15) {
+	    *token |= 15;
+	    q = lz_length(q, len - LZ_MINMATCH - 15);
+	} else {
+	    *token |= len - LZ_MINMATCH;
+	}
+	p = lit = p + len;
+    }
+
+    /* emit remaining literals */
+    litlen = end - lit;
+    if (q + 1 + litlen / 255 + 1 + litlen >= qend) {
+	return 0;	/* compression did not reduce size */
+    }
+    token = q++;
+    if (litlen >= 15) {
+	*token = 15 << 4;
+	q = lz_length(q, litlen - 15);
+    } else {
+	*token = litlen << 4;
+    }
+    memcpy(q, lit, litlen);
+    q += litlen;
+
+    return (intptr_t) q - (intptr_t) data;
+}
+
+/*
+ * NAME:	lz_decompress()
+ * DESCRIPTION:	read and decompress LZ data from the swap file
+ */
+static char *lz_decompress(sector *sectors, void (*readv) (char*, sector*, Uint, Uint), Uint size, Uint offset, Uint *dsize)
+{
+    char *buffer, *p, *end, *q, *m;
+    Uint len, c;
+    int token;
+
+    buffer = ALLOC(char, size);
+    (*readv)(buffer, sectors, size, offset);
+    *dsize = (UCHAR(buffer[0]) << 24) | (UCHAR(buffer[1]) << 16) |
+	     (UCHAR(buffer[2]) << 8) | UCHAR(buffer[3]);
+    q = ALLOC(char, *dsize);
+    p = buffer + 4;
+    end = buffer + size;
+
+    for (;;) {
+	/* literals */
+	token = UCHAR(*p++);
+	len = token >> 4;
+	if (len == 15) {
+	    do {
+		len += c = UCHAR(*p++);
+	    } while (c == 255);
+	}
+	memcpy(q, p, len);
+	q += len;
+	p += len;
+	if (p == end) {
+	    break;
+	}
+
+	/* match */
+	m = q - (UCHAR(p[0]) | (UCHAR(p[1]) << 8));
+	p += 2;
+	len = token & 15;
+	if (len == 15) {
+	    do {
+		len += c = UCHAR(*p++);
+	    } while (c == 255);
+	}
+	len += LZ_MINMATCH;
+	if ((Uint) (q - m) >= len) {
+	    memcpy(q, m, len);
+	    q += len;
+	} else {
+	    do {
+		*q++ = *m++;	/* overlapping */
+	    } while (--len != 0);
+	}
+    }
+
+    FREE(buffer);
+    return q - *dsize;
+}
+
+/*
+ * NAME:	compress()
+ * DESCRIPTION:	compress data with the configured method.  Return the size
+ *		of the compressed data, or 0 if it could not be compressed
+ */
+static Uint compress(char *data, char *text, Uint size)
+{
+    switch (cmptype) {
+    case CMP_PRED:
+	return pred_compress(data, text, size);
+
+    case CMP_LZ:
+	return lz_compress(data, text, size);
+
+    default:
+	return 0;
+    }
+}
+
+/*
+ * NAME:	decompress()
+ * DESCRIPTION:	read and decompress data from the swap file
+ */
+static char *decompress(sector *sectors, void (*readv) (char*, sector*, Uint, Uint), int type, Uint size, Uint offset, Uint *dsize)
+{
+    switch (type) {
+    case CMP_PRED:
+	return pred_decompress(sectors, readv, size, offset, dsize);
+
+    case CMP_LZ:
+	return lz_decompress(sectors, readv, size, offset, dsize);
+
+    default:
+	fatal("unknown compression");
+	return (char *) NULL;
+    }
+}
+
 /*
  * NAME:	get_prog()
  * DESCRIPTION:	get the program
@@ -908,7 +1195,8 @@ static void get_prog(control *ctrl, void (*readv) (char*, sector*, Uint, Uint))
 {
     if (ctrl->progsize != 0) {
 	if (ctrl->flags & CTRL_PROGCMP) {
-	    ctrl->prog = decompress(ctrl->sectors, readv, ctrl->progsize,
+	    ctrl->prog = decompress(ctrl->sectors, readv,
+				    ctrl->flags & CTRL_PROGCMP, ctrl->progsize,
 				    ctrl->progoffset, &ctrl->progsize);
 	} else {
 	    ctrl->prog = ALLOC(char, ctrl->progsize);
@@ -939,6 +1227,7 @@ static void get_stext(control *ctrl, void (*readv) (char*, sector*, Uint, Uint))
     /* load strings text */
     if (ctrl->flags & CTRL_STRCMP) {
 	ctrl->stext = decompress(ctrl->sectors, readv,
+				 (ctrl->flags & CTRL_STRCMP) >> 2,
 				 ctrl->strsize,
 				 ctrl->stroffset +
 				 ctrl->nstrings * sizeof(dstrconst),
@@ -1190,14 +1479,14 @@ static void get_strings(dataspace *data, void (*readv) (char*, sector*, Uint, Ui
 	if (data->strsize > 0) {
 	    /* load strings text */
 	    if (data->flags & DATA_STRCMP) {
-		data->stext = decompress(data->sectors, readv, data->strsize,
-					 data->stroffset +
-					       data->nstrings * sizeof(sstring),
+		data->stext = decompress(data->sectors, readv,
+					 data->flags & DATA_STRCMP,
+					 data->strsize, data->txtoffset,
 					 &data->strsize);
 	    } else {
 		data->stext = ALLOC(char, data->strsize);
 		(*readv)(data->stext, data->sectors, data->strsize,
-			 data->stroffset + data->nstrings * sizeof(sstring));
+			 data->txtoffset);
 	    }
 	}
     }
@@ -1425,9 +1714,34 @@ static void get_elts(dataspace *data, void (*readv) (char*, sector*, Uint, Uint)
 	/* load array elements */
 	data->selts = (svalue *) ALLOC(svalue, data->eltsize);
 	(*readv)((char *) data->selts, data->sectors,
-		 data->eltsize * sizeof(svalue),
-		 data->arroffset + data->narrays * sizeof(sarray));
+		 data->eltsize * sizeof(svalue), data->eltoffset);
+    }
+}
+
+/*
+ * NAME:	data->get_packed()
+ * DESCRIPTION:	get the packed elements of an array, if it has them
+ */
+char *d_get_packed(array *arr)
+{
+    if (arr->packed == (char *) NULL && arr->elts == (value *) NULL &&
+	arr->size != 0) {
+	dataspace *data;
+	sarray *sa;
+
+	data = arr->primary->data;
+	sa = &data->sarrays[arr->primary - data->plane->arrays];
+	if (SA_PKTYPE(sa) != T_NIL) {
+	    if (data->selts == (svalue *) NULL) {
+		get_elts(data, sw_readv);
+	    }
+	    arr->ptype = SA_PKTYPE(sa);
+	    memcpy(arr->packed = ALLOC(char, PKD_SIZE(arr->ptype, arr->size)),
+		   &data->selts[sa->index], PKD_SIZE(arr->ptype, arr->size));
+	}
     }
+
+    return arr->packed;
 }
 
 /*
@@ -1441,15 +1755,20 @@ value *d_get_elts(array *arr)
     v = arr->elts;
     if (v == (value *) NULL && arr->size != 0) {
 	dataspace *data;
-	Uint idx;
+	sarray *sa;
+
+	if (d_get_packed(arr) != (char *) NULL) {
+	    arr_unpack(arr);
+	    return arr->elts;
+	}
 
 	data = arr->primary->data;
 	if (data->selts == (svalue *) NULL) {
 	    get_elts(data, sw_readv);
 	}
 	v = arr->elts = ALLOC(value, arr->size);
-	idx = data->sarrays[arr->primary - data->plane->arrays].index;
-	d_get_values(data, &data->selts[idx], v, arr->size);
+	sa = &data->sarrays[arr->primary - data->plane->arrays];
+	d_get_values(data, &data->selts[sa->index], v, arr->size);
     }
 
     return v;
@@ -1576,7 +1895,7 @@ static void d_save_control(control *ctrl)
 	    prog = ALLOC(char, header.progsize);
 	    size = compress(prog, ctrl->prog, header.progsize);
 	    if (size != 0) {
-		header.flags |= CMP_PRED;
+		header.flags |= cmptype;
 		header.progsize = size;
 	    } else {
 		FREE(prog);
@@ -1614,7 +1933,7 @@ static void d_save_control(control *ctrl)
 	    text = ALLOC(char, header.strsize);
 	    size = compress(text, stext, header.strsize);
 	    if (size != 0) {
-		header.flags |= CMP_PRED << 2;
+		header.flags |= cmptype << 2;
 		header.strsize = size;
 	    } else {
 		FREE(text);
@@ -1755,6 +2074,48 @@ static void d_save_control(control *ctrl)
 
 static void d_count (savedata*, value*, unsigned int);
 
+/*
+ * NAME:	data->packtype()
+ * DESCRIPTION:	return the type in which array elements can be saved packed,
+ *		or T_NIL
+ */
+static int d_packtype(array *arr)
+{
+    value *v;
+    asizet n;
+    int type;
+
+    if (arr->packed != (char *) NULL) {
+	return arr->ptype;
+    }
+    if (arr->size < 2) {
+	return T_NIL;
+    }
+    type = arr->elts->type;
+    if (type != T_INT && type != T_FLOAT) {
+	return T_NIL;
+    }
+    for (n = arr->size, v = arr->elts; n > 0; --n, v++) {
+	if (v->type != type) {
+	    return T_NIL;
+	}
+    }
+    return type;
+}
+
+/*
+ * NAME:	data->slots()
+ * DESCRIPTION:	return the number of svalues taken by the elements of an
+ *		array
+ */
+static Uint d_slots(array *arr)
+{
+    int type;
+
+    type = d_packtype(arr);
+    return (type != T_NIL) ? PACKSIZE(type, arr->size) : arr->size;
+}
+
 /*
  * NAME:	data->arrcount()
  * DESCRIPTION:	count the number of arrays and strings in an array
@@ -1772,8 +2133,14 @@ static void d_arrcount(savedata *save, array *arr)
     if (!save->counting) {
 	save->counting = TRUE;
 	do {
-	    save->arrsize += arr->size;
-	    d_count(save, d_get_elts(arr), arr->size);
+	    if (d_get_packed(arr) != (char *) NULL) {
+		/* no strings or arrays to count */
+		save->arrsize += d_slots(arr);
+	    } else {
+		d_get_elts(arr);
+		save->arrsize += d_slots(arr);
+		d_count(save, arr->elts, arr->size);
+	    }
 	    arr = arr->prev;
 	} while (arr != &save->alist);
 	save->counting = FALSE;
@@ -1794,6 +2161,15 @@ static void d_count(savedata *save, value *v, Uint n)
 	switch (v->type) {
 	case T_STRING:
 	    if (str_put(v->u.string, save->nstr) == save->nstr) {
+		if (save->slist != (string **) NULL) {
+		    if (save->nstr == save->slistsz) {
+			save->slist = REALLOC(save->slist, string*,
+					      save->slistsz,
+					      save->slistsz * 2);
+			save->slistsz *= 2;
+		    }
+		    save->slist[save->nstr] = v->u.string;
+		}
 		save->nstr++;
 		save->strsize += v->u.string->len;
 	    }
@@ -1847,7 +2223,7 @@ static void d_count(savedata *save, value *v, Uint n)
  * NAME:	data->save()
  * DESCRIPTION:	save the values in an object
  */
-static void d_save(savedata *save, svalue *sv, value *v, unsigned short n)
+static void d_save(savedata *save, svalue *sv, value *v, asizet n)
 {
     Uint i;
 
@@ -1866,9 +2242,11 @@ static void d_save(savedata *save, svalue *sv, value *v, unsigned short n)
 
 	case T_STRING:
 	    i = str_put(v->u.string, save->nstr);
-	    sv->oindex = 0;
-	    sv->u.string = i;
-	    if (save->sstrings[i].ref++ == 0) {
+	    if (save->smap != (Uint *) NULL) {
+		/* text already in place */
+		i = save->smap[i];
+		save->sstrings[i].ref++;
+	    } else if (save->sstrings[i].ref++ == 0) {
 		/* new string value */
 		save->sstrings[i].index = save->strsize;
 		save->sstrings[i].len = v->u.string->len;
@@ -1876,6 +2254,8 @@ static void d_save(savedata *save, svalue *sv, value *v, unsigned short n)
 		       v->u.string->len);
 		save->strsize += v->u.string->len;
 	    }
+	    sv->oindex = 0;
+	    sv->u.string = i;
 	    break;
 
 	case T_FLOAT:
@@ -1888,11 +2268,14 @@ static void d_save(savedata *save, svalue *sv, value *v, unsigned short n)
 	case T_MAPPING:
 	case T_LWOBJECT:
 	    i = arr_put(v->u.array, save->narr);
+	    if (save->amap != (Uint *) NULL) {
+		i = save->amap[i];
+	    }
 	    sv->oindex = 0;
 	    sv->u.array = i;
 	    if (save->sarrays[i].ref++ == 0) {
 		/* new array value */
-		save->sarrays[i].type = sv->type;
+		save->sarrays[i].type |= sv->type;
 	    }
 	    break;
 	}
@@ -1906,7 +2289,7 @@ static void d_save(savedata *save, svalue *sv, value *v, unsigned short n)
  * NAME:	data->put_values()
  * DESCRIPTION:	save modified values as svalues
  */
-static void d_put_values(dataspace *data, svalue *sv, value *v, unsigned short n)
+static void d_put_values(dataspace *data, svalue *sv, value *v, asizet n)
 {
     while (n > 0) {
 	if (v->modified) {
@@ -1948,6 +2331,60 @@ static void d_put_values(dataspace *data, svalue *sv, value *v, unsigned short n
     }
 }
 
+/*
+ * NAME:	data->put_packed()
+ * DESCRIPTION:	save the elements of an array as packed Ints or floats
+ */
+static void d_put_packed(svalue *sv, array *arr, int type)
+{
+    value *v;
+    asizet n;
+    Int *p;
+    Uint *low;
+    unsigned short *high;
+
+    memset(sv, '\0', PACKSIZE(type, arr->size) * sizeof(svalue));
+    if (arr->packed != (char *) NULL) {
+	memcpy(sv, arr->packed, PKD_SIZE(type, arr->size));
+    } else if (type == T_INT) {
+	for (n = arr->size, v = arr->elts, p = (Int *) sv; n > 0; --n, v++) {
+	    *p++ = v->u.number;
+	    v->modified = FALSE;
+	}
+    } else {
+	low = (Uint *) sv;
+	high = (unsigned short *) (low + arr->size);
+	for (n = arr->size, v = arr->elts; n > 0; --n, v++) {
+	    *low++ = v->u.objcnt;
+	    *high++ = v->oindex;
+	    v->modified = FALSE;
+	}
+    }
+}
+
+/*
+ * NAME:	data->packfit()
+ * DESCRIPTION:	check whether changed arrays with packed elements can still
+ *		be saved in place
+ */
+static bool d_packfit(dataspace *data)
+{
+    arrref *a;
+    Uint n;
+
+    if (data->base.flags & MOD_ARRAY) {
+	for (a = data->base.arrays, n = 0; n < data->narrays; a++, n++) {
+	    if (a->arr != (array *) NULL && (a->ref & ARR_MOD) &&
+		SA_PKTYPE(&data->sarrays[n]) != d_packtype(a->arr) &&
+		(SA_PKTYPE(&data->sarrays[n]) != T_NIL ||
+		 a->arr->packed != (char *) NULL)) {
+		return FALSE;
+	    }
+	}
+    }
+    return TRUE;
+}
+
 /*
  * NAME:	data->free_values()
  * DESCRIPTION:	free values in a dataspace block
@@ -2035,6 +2472,399 @@ static void d_free_values(dataspace *data)
     }
 }
 
+/*
+ * NAME:	uint_compare
+ * DESCRIPTION:	used by qsort to compare offsets
+ */
+static int uint_compare(const void *pa, const void *pb)
+{
+    Uint a = *(Uint *) pa;
+    Uint b = *(Uint *) pb;
+
+    if (a > b) {
+	return 1;
+    } else if (a < b) {
+	return -1;
+    } else {
+	return 0;
+    }
+}
+
+/*
+ * NAME:	data->stable_index()
+ * DESCRIPTION:	assign indices to the arrays and strings to be saved, such
+ *		that those already in swap stay where they are
+ */
+static bool d_stable_index(dataspace *data, savedata *save,
+			   sdataspace *header)
+{
+    array *arr;
+    arrref *a;
+    string *str;
+    strref *s;
+    sarray *sa, *osa;
+    sstring *ss;
+    char *used;
+    Uint *starts;
+    Uint i, j, n, size, live, end, nstarts, lo, hi, mid, slots;
+
+    save->sarrays = (sarray *) NULL;
+    save->selts = (svalue *) NULL;
+    save->sstrings = (sstring *) NULL;
+    save->stext = (char *) NULL;
+
+    /*
+     * arrays: surviving arrays keep their index, and their elements stay
+     * in place unless they no longer fit
+     */
+    n = data->narrays;
+    size = (n > save->narr) ? n : save->narr;
+    live = 0;
+    end = data->eltsize;
+    if (save->narr != 0) {
+	save->amap = ALLOC(Uint, save->narr);
+	sa = save->sarrays = ALLOC(sarray, size);
+	memset(sa, '\0', size * sizeof(sarray));
+	used = ALLOC(char, size);
+	memset(used, '\0', size);
+	starts = ALLOC(Uint, save->narr);
+	nstarts = 0;
+
+	for (arr = save->alist.prev, i = 0; arr != &save->alist;
+	     arr = arr->prev, i++) {
+	    a = arr->primary;
+	    if (data->base.arrays != (arrref *) NULL && a >= data->base.arrays &&
+		a < data->base.arrays + n && a->arr == arr) {
+		j = save->amap[i] = a - data->base.arrays;
+		used[j] = TRUE;
+		if (data->sarrays[j].size != 0) {
+		    starts[nstarts++] = data->sarrays[j].index;
+		}
+	    } else {
+		save->amap[i] = size;	/* new array */
+	    }
+	    live += d_slots(arr);
+	}
+	qsort(starts, nstarts, sizeof(Uint), uint_compare);
+
+	for (arr = save->alist.prev, i = 0; arr != &save->alist;
+	     arr = arr->prev, i++) {
+	    j = save->amap[i];
+	    if (j != size) {
+		osa = &data->sarrays[j];
+		sa[j].index = osa->index;
+		sa[j].size = arr->size;
+		slots = d_slots(arr);
+		if (slots > SA_SLOTS(osa)) {
+		    /* find the next surviving array */
+		    lo = 0;
+		    hi = nstarts;
+		    while (lo < hi) {
+			mid = (lo + hi) >> 1;
+			if (starts[mid] <= osa->index) {
+			    lo = mid + 1;
+			} else {
+			    hi = mid;
+			}
+		    }
+		    if (osa->size == 0) {
+			used[j] = 2;	/* relocate */
+		    } else if (lo == nstarts) {
+			/* last in the element table: grow in place */
+			if (osa->index + slots > end) {
+			    end = osa->index + slots + slots / 8;
+			}
+		    } else if (osa->index + slots > starts[lo]) {
+			used[j] = 2;	/* relocate */
+		    }
+		}
+	    }
+	}
+	FREE(starts);
+
+	for (arr = save->alist.prev, i = 0, j = 0; arr != &save->alist;
+	     arr = arr->prev, i++) {
+	    if (save->amap[i] == size) {
+		/* reuse a free index */
+		while (used[j]) {
+		    j++;
+		}
+		used[j] = TRUE;
+		save->amap[i] = j;
+	    } else if (used[save->amap[i]] != 2) {
+		continue;
+	    }
+	    /* append, with room to grow */
+	    sa[save->amap[i]].index = end;
+	    sa[save->amap[i]].size = arr->size;
+	    slots = d_slots(arr);
+	    end += slots + slots / 8;
+	}
+	FREE(used);
+
+	if (size - save->narr > save->narr || end - live > live) {
+	    /* too much garbage */
+	    return FALSE;
+	}
+
+	if (end != 0) {
+	    save->selts = ALLOC(svalue, end);
+	    if (data->selts != (svalue *) NULL) {
+		memcpy(save->selts, data->selts, data->eltsize * sizeof(svalue));
+	    } else {
+		memset(save->selts, '\0', data->eltsize * sizeof(svalue));
+	    }
+	}
+    } else if (n != 0 || end != 0) {
+	return FALSE;
+    }
+    header->narrays = size;
+    header->eltsize = end;
+
+    /*
+     * strings: surviving strings keep their index and text, new text is
+     * appended
+     */
+    n = data->nstrings;
+    size = (n > save->nstr) ? n : save->nstr;
+    live = 0;
+    end = data->strsize;
+    if (save->nstr != 0) {
+	save->smap = ALLOC(Uint, save->nstr);
+	ss = save->sstrings = ALLOC(sstring, size);
+	memset(ss, '\0', size * sizeof(sstring));
+	used = ALLOC(char, size);
+	memset(used, '\0', size);
+
+	for (i = 0; i < save->nstr; i++) {
+	    str = save->slist[i];
+	    s = str->primary;
+	    if (data->base.strings != (strref *) NULL &&
+		s >= data->base.strings && s < data->base.strings + n &&
+		s->str == str) {
+		j = save->smap[i] = s - data->base.strings;
+		used[j] = TRUE;
+		ss[j].index = data->sstrings[j].index;
+		ss[j].len = str->len;
+	    } else {
+		save->smap[i] = size;	/* new string */
+	    }
+	    live += str->len;
+	}
+
+	for (i = 0, j = 0; i < save->nstr; i++) {
+	    if (save->smap[i] == size) {
+		while (used[j]) {
+		    j++;
+		}
+		used[j] = TRUE;
+		save->smap[i] = j;
+		ss[j].index = end;
+		ss[j].len = save->slist[i]->len;
+		end += save->slist[i]->len;
+	    }
+	}
+	FREE(used);
+
+	if (size - save->nstr > save->nstr || end - live > live) {
+	    /* too much garbage */
+	    return FALSE;
+	}
+
+	if (end != 0) {
+	    save->stext = ALLOC(char, end);
+	    if (data->stext != (char *) NULL) {
+		memcpy(save->stext, data->stext, data->strsize);
+	    } else {
+		memset(save->stext, '\0', data->strsize);
+	    }
+	    for (i = 0; i < save->nstr; i++) {
+		ss = &save->sstrings[save->smap[i]];
+		if (ss->index >= data->strsize) {
+		    memcpy(save->stext + ss->index, save->slist[i]->text,
+			   ss->len);
+		}
+	    }
+	}
+    } else if (n != 0 || end != 0) {
+	return FALSE;
+    }
+    header->nstrings = size;
+    header->strsize = end;
+
+    return TRUE;
+}
+
+# define DIFFCHUNK	256		/* unit of comparison for changes */
+
+/*
+ * NAME:	data->write_changes()
+ * DESCRIPTION:	write the parts of a block that differ from the old version
+ */
+static void d_write_changes(dataspace *data, char *m, char *old, Uint size,
+			    Uint offset)
+{
+    Uint start, n;
+
+    start = 0;
+    while (start < size) {
+	n = (size - start > DIFFCHUNK) ? DIFFCHUNK : size - start;
+	if (memcmp(m + start, old + start, n) == 0) {
+	    start += n;
+	} else {
+	    /* write a run of changed chunks */
+	    for (n += start; n < size; n += DIFFCHUNK) {
+		if (memcmp(m + n, old + n,
+			   (size - n > DIFFCHUNK) ? DIFFCHUNK : size - n) == 0)
+		{
+		    break;
+		}
+	    }
+	    if (n > size) {
+		n = size;
+	    }
+	    sw_writev(m + start, data->sectors, n - start, offset + start);
+	    start = n;
+	}
+    }
+}
+
+/*
+ * NAME:	data->save_stable()
+ * DESCRIPTION:	save a dataspace in place, writing only what changed; if
+ *		there are no old versions to compare with, lay it out anew
+ */
+static void d_save_stable(dataspace *data, sdataspace *header, char **obuf)
+{
+    sdataoffsets offsets;
+    char *buf[6];
+    Uint size[6], osize[6], offset[6], ooffset[7];
+    Uint head, end, live, next, n;
+    sector nsectors;
+    bool fresh;
+    int i, j;
+
+    buf[0] = (char *) data->svariables;
+    size[0] = header->nvariables * (Uint) sizeof(svalue);
+    osize[0] = data->nvariables * (Uint) sizeof(svalue);
+    ooffset[0] = data->varoffset;
+    buf[1] = (char *) data->sarrays;
+    size[1] = header->narrays * (Uint) sizeof(sarray);
+    osize[1] = data->narrays * (Uint) sizeof(sarray);
+    ooffset[1] = data->arroffset;
+    buf[2] = (char *) data->selts;
+    size[2] = header->eltsize * (Uint) sizeof(svalue);
+    osize[2] = data->eltsize * (Uint) sizeof(svalue);
+    ooffset[2] = data->eltoffset;
+    buf[3] = (char *) data->sstrings;
+    size[3] = header->nstrings * (Uint) sizeof(sstring);
+    osize[3] = data->nstrings * (Uint) sizeof(sstring);
+    ooffset[3] = data->stroffset;
+    buf[4] = data->stext;
+    size[4] = header->strsize;
+    osize[4] = (data->flags & DATA_STRCMP) ? 0 : data->strsize;
+    ooffset[4] = data->txtoffset;
+    buf[5] = (char *) data->scallouts;
+    size[5] = header->ncallouts * (Uint) sizeof(scallout);
+    osize[5] = 0;
+    ooffset[5] = data->cooffset;
+    ooffset[6] = data->datasize;
+
+    /*
+     * Sections keep their place for as long as they fit.  A section that
+     * has outgrown its place is moved to the end, with some room to grow.
+     * If too much space is left unused, all sections are laid out anew.
+     */
+    fresh = (obuf == (char **) NULL || !(data->flags & DATA_STABLE));
+    nsectors = (fresh) ? 0 : data->nsectors;
+    for (;;) {
+	head = sizeof(sdataspace) + nsectors * (Uint) sizeof(sector) +
+	       sizeof(sdataoffsets);
+	if (fresh) {
+	    /* leave room for the sector map to grow */
+	    end = head + (nsectors / 2 + 16) * (Uint) sizeof(sector);
+	} else {
+	    end = ooffset[6];
+	}
+	live = head;
+	for (i = 0; i < 6; i++) {
+	    live += size[i];
+	    if (!fresh && ooffset[i] >= head) {
+		/* find the next section */
+		next = ooffset[6];
+		for (j = 0; j < 6; j++) {
+		    if (ooffset[j] > ooffset[i] && ooffset[j] < next) {
+			next = ooffset[j];
+		    }
+		}
+		if (size[i] <= next - ooffset[i]) {
+		    offset[i] = ooffset[i];
+		    continue;
+		}
+	    }
+	    offset[i] = end;
+	    end += size[i] + size[i] / 8 + 1;
+	}
+	if (!fresh && end > live + live / 2) {
+	    fresh = TRUE;
+	    nsectors = 0;
+	    continue;
+	}
+
+	n = sw_mapsize(end - nsectors * (Uint) sizeof(sector));
+	if (n <= nsectors) {
+	    break;
+	}
+	nsectors = n;
+    }
+
+    /* resize sector space, keeping what is already there */
+    if (fresh && data->nsectors != 0) {
+	sw_wipev(data->sectors, data->nsectors);
+    }
+    if (nsectors < data->nsectors) {
+	sw_delv(data->sectors + nsectors, data->nsectors - nsectors);
+    }
+    data->sectors = REALLOC(data->sectors, sector, data->nsectors, nsectors);
+    if (nsectors > data->nsectors) {
+	sw_newv(data->sectors + data->nsectors, nsectors - data->nsectors);
+    }
+    header->nsectors = data->nsectors = nsectors;
+    OBJ(data->oindex)->dfirst = data->sectors[0];
+
+    /* save header */
+    n = sizeof(sdataspace);
+    sw_writev((char *) header, data->sectors, n, (Uint) 0);
+    sw_writev((char *) data->sectors, data->sectors,
+	      nsectors * (Uint) sizeof(sector), n);
+    n += nsectors * (Uint) sizeof(sector);
+    offsets.varoffset = data->varoffset = offset[0];
+    offsets.arroffset = data->arroffset = offset[1];
+    offsets.eltoffset = data->eltoffset = offset[2];
+    offsets.stroffset = data->stroffset = offset[3];
+    offsets.txtoffset = data->txtoffset = offset[4];
+    offsets.cooffset = data->cooffset = offset[5];
+    offsets.size = data->datasize = end;
+    sw_writev((char *) &offsets, data->sectors, (Uint) sizeof(sdataoffsets),
+	      n);
+
+    /* save sections */
+    for (i = 0; i < 6; i++) {
+	if (size[i] != 0) {
+	    n = 0;
+	    if (!fresh && offset[i] == ooffset[i] && obuf[i] != (char *) NULL)
+	    {
+		n = (size[i] < osize[i]) ? size[i] : osize[i];
+		d_write_changes(data, buf[i], obuf[i], n, offset[i]);
+	    }
+	    if (size[i] > n) {
+		sw_writev(buf[i] + n, data->sectors, size[i] - n,
+			  offset[i] + n);
+	    }
+	}
+    }
+}
+
 /*
  * NAME:	data->save_dataspace()
  * DESCRIPTION:	save all values in a dataspace block
@@ -2055,7 +2885,8 @@ static bool d_save_dataspace(dataspace *data, bool swap)
     }
 
     if (data->svariables != (svalue *) NULL && data->base.achange == 0 &&
-	data->base.schange == 0 && !(data->base.flags & MOD_NEWCALLOUT)) {
+	data->base.schange == 0 && !(data->base.flags & MOD_NEWCALLOUT) &&
+	d_packfit(data)) {
 	bool mod;
 
 	/*
@@ -2100,7 +2931,7 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 	}
 	if (data->base.flags & MOD_ARRAY) {
 	    arrref *a;
-	    Uint idx;
+	    sarray *sa;
 
 	    /*
 	     * array elements changed
@@ -2109,15 +2940,20 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 	    for (n = 0; n < data->narrays; n++) {
 		if (a->arr != (array *) NULL && (a->ref & ARR_MOD)) {
 		    a->ref &= ~ARR_MOD;
-		    idx = data->sarrays[n].index;
-		    d_put_values(data, &data->selts[idx], a->arr->elts,
-				 a->arr->size);
+		    sa = &data->sarrays[n];
+		    if (SA_PKTYPE(sa) != T_NIL) {
+			d_put_packed(&data->selts[sa->index], a->arr,
+				     SA_PKTYPE(sa));
+		    } else {
+			d_put_values(data, &data->selts[sa->index],
+				     a->arr->elts, a->arr->size);
+		    }
 		    if (swap) {
-			sw_writev((char *) &data->selts[idx], data->sectors,
-				  a->arr->size * (Uint) sizeof(svalue),
-				  data->arroffset +
-					      data->narrays * sizeof(sarray) +
-					      idx * sizeof(svalue));
+			sw_writev((char *) &data->selts[sa->index],
+				  data->sectors,
+				  SA_SLOTS(sa) * (Uint) sizeof(svalue),
+				  data->eltoffset +
+				  sa->index * (Uint) sizeof(svalue));
 		    }
 		}
 		a++;
@@ -2186,10 +3022,20 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 	}
     } else {
 	savedata save;
-	char *text;
+	char *text, *obuf[6];
 	Uint size;
 	array *arr;
 	sarray *sarr;
+	bool stable;
+	int type;
+
+	/*
+	 * A large dataspace that is unchanged in swap since it was last saved
+	 * is saved in place, keeping surviving arrays and strings where they
+	 * are.
+	 */
+	stable = (swap && !(data->base.flags & MOD_SAVE) &&
+		  data->datasize >= DSLIMIT);
 
 	/*
 	 * count the number and sizes of strings and arrays
@@ -2202,6 +3048,11 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 	save.strsize = 0;
 	save.counting = FALSE;
 	save.alist.prev = save.alist.next = &save.alist;
+	save.slist = (string **) NULL;
+	save.amap = save.smap = (Uint *) NULL;
+	if (stable) {
+	    save.slist = ALLOC(string*, save.slistsz = 64);
+	}
 
 	d_get_variable(data, 0);
 	if (data->svariables == (svalue *) NULL) {
@@ -2258,25 +3109,80 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 	header.ncallouts = data->ncallouts;
 	header.fcallouts = data->fcallouts;
 
+	if (stable) {
+	    stable = d_stable_index(data, &save, &header);
+	    FREE(save.slist);
+	    if (!stable) {
+		/* fall back to a compact save */
+		if (save.amap != (Uint *) NULL) {
+		    FREE(save.amap);
+		    save.amap = (Uint *) NULL;
+		}
+		if (save.smap != (Uint *) NULL) {
+		    FREE(save.smap);
+		    save.smap = (Uint *) NULL;
+		}
+		if (save.sarrays != (sarray *) NULL) {
+		    FREE(save.sarrays);
+		}
+		if (save.selts != (svalue *) NULL) {
+		    FREE(save.selts);
+		}
+		if (save.sstrings != (sstring *) NULL) {
+		    FREE(save.sstrings);
+		}
+		if (save.stext != (char *) NULL) {
+		    FREE(save.stext);
+		}
+		header.narrays = save.narr;
+		header.eltsize = save.arrsize;
+		header.nstrings = save.nstr;
+		header.strsize = save.strsize;
+	    }
+	}
+
 	/*
 	 * put everything in a saveable form
 	 */
-	save.sstrings = data->sstrings =
-			REALLOC(data->sstrings, sstring, 0, header.nstrings);
-	memset(save.sstrings, '\0', save.nstr * sizeof(sstring));
-	save.stext = data->stext =
-		     REALLOC(data->stext, char, 0, header.strsize);
-	save.sarrays = data->sarrays =
-		       REALLOC(data->sarrays, sarray, 0, header.narrays);
-	memset(save.sarrays, '\0', save.narr * sizeof(sarray));
-	save.selts = data->selts =
-		     REALLOC(data->selts, svalue, 0, header.eltsize);
+	if (stable) {
+	    /* keep the old versions to compare with */
+	    obuf[0] = (char *) data->svariables;
+	    obuf[1] = (char *) data->sarrays;
+	    obuf[2] = (char *) data->selts;
+	    obuf[3] = (char *) data->sstrings;
+	    obuf[4] = data->stext;
+	    obuf[5] = (char *) data->scallouts;
+	    header.flags = DATA_STABLE;
+	    data->svariables = (header.nvariables != 0) ?
+				ALLOC(svalue, header.nvariables) :
+				(svalue *) NULL;
+	    data->sarrays = save.sarrays;
+	    data->selts = save.selts;
+	    data->sstrings = save.sstrings;
+	    data->stext = save.stext;
+	    data->scallouts = (header.ncallouts != 0) ?
+			       ALLOC(scallout, header.ncallouts) :
+			       (scallout *) NULL;
+	    save.strsize = header.strsize;
+	} else {
+	    save.sstrings = data->sstrings =
+			    REALLOC(data->sstrings, sstring, 0,
+				    header.nstrings);
+	    memset(save.sstrings, '\0', save.nstr * sizeof(sstring));
+	    save.stext = data->stext =
+			 REALLOC(data->stext, char, 0, header.strsize);
+	    save.sarrays = data->sarrays =
+			   REALLOC(data->sarrays, sarray, 0, header.narrays);
+	    memset(save.sarrays, '\0', save.narr * sizeof(sarray));
+	    save.selts = data->selts =
+			 REALLOC(data->selts, svalue, 0, header.eltsize);
+	    save.strsize = 0;
+	    data->scallouts = REALLOC(data->scallouts, scallout, 0,
+				      header.ncallouts);
+	}
 	save.narr = 0;
 	save.nstr = 0;
 	save.arrsize = 0;
-	save.strsize = 0;
-	data->scallouts = REALLOC(data->scallouts, scallout, 0,
-				  header.ncallouts);
 
 	d_save(&save, data->svariables, data->variables, data->nvariables);
 	if (header.ncallouts > 0) {
@@ -2300,13 +3206,25 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 		co++;
 	    }
 	}
-	for (arr = save.alist.prev, sarr = save.sarrays; arr != &save.alist;
-	     arr = arr->prev, sarr++) {
-	    sarr->index = save.arrsize;
-	    sarr->size = arr->size;
+	for (arr = save.alist.prev, n = 0; arr != &save.alist;
+	     arr = arr->prev, n++) {
+	    if (stable) {
+		/* elements already placed */
+		sarr = &save.sarrays[save.amap[n]];
+	    } else {
+		sarr = &save.sarrays[n];
+		sarr->index = save.arrsize;
+		sarr->size = arr->size;
+		save.arrsize += d_slots(arr);
+	    }
 	    sarr->tag = arr->tag;
-	    d_save(&save, save.selts + save.arrsize, arr->elts, arr->size);
-	    save.arrsize += arr->size;
+	    type = d_packtype(arr);
+	    if (type != T_NIL) {
+		sarr->type |= (type == T_INT) ? SA_PACKED : SA_PACKFLT;
+		d_put_packed(save.selts + sarr->index, arr, type);
+	    } else {
+		d_save(&save, save.selts + sarr->index, arr->elts, arr->size);
+	    }
 	}
 	if (arr->next != &save.alist) {
 	    data->alist.next->prev = arr->prev;
@@ -2319,13 +3237,36 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 	arr_clear();
 	str_clear();
 
-	if (swap) {
+	size = sizeof(sdataspace) +
+	       (header.nvariables + header.eltsize) * sizeof(svalue) +
+	       header.narrays * sizeof(sarray) +
+	       header.nstrings * sizeof(sstring) +
+	       header.strsize +
+	       header.ncallouts * (Uint) sizeof(scallout);
+	if (stable) {
+	    d_save_stable(data, &header, obuf);
+	    for (n = 0; n < 6; n++) {
+		if (obuf[n] != (char *) NULL) {
+		    FREE(obuf[n]);
+		}
+	    }
+	    if (save.amap != (Uint *) NULL) {
+		FREE(save.amap);
+	    }
+	    if (save.smap != (Uint *) NULL) {
+		FREE(save.smap);
+	    }
+	} else if (swap && size >= DSLIMIT) {
+	    /* uncompressed, to be saved in place later on */
+	    header.flags = DATA_STABLE;
+	    d_save_stable(data, &header, (char **) NULL);
+	} else if (swap) {
 	    text = save.stext;
 	    if (header.strsize >= CMPLIMIT) {
 		text = ALLOC(char, header.strsize);
 		size = compress(text, save.stext, header.strsize);
 		if (size != 0) {
-		    header.flags |= CMP_PRED;
+		    header.flags |= cmptype;
 		    header.strsize = size;
 		} else {
 		    FREE(text);
@@ -2363,11 +3304,12 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 		sw_writev((char *) save.sarrays, data->sectors,
 			  header.narrays * sizeof(sarray), size);
 		size += header.narrays * sizeof(sarray);
-		if (header.eltsize > 0) {
-		    sw_writev((char *) save.selts, data->sectors,
-			      header.eltsize * sizeof(svalue), size);
-		    size += header.eltsize * sizeof(svalue);
-		}
+	    }
+	    data->eltoffset = size;
+	    if (header.eltsize > 0) {
+		sw_writev((char *) save.selts, data->sectors,
+			  header.eltsize * sizeof(svalue), size);
+		size += header.eltsize * sizeof(svalue);
 	    }
 
 	    /* save strings */
@@ -2376,12 +3318,13 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 		sw_writev((char *) save.sstrings, data->sectors,
 			  header.nstrings * sizeof(sstring), size);
 		size += header.nstrings * sizeof(sstring);
-		if (header.strsize > 0) {
-		    sw_writev(text, data->sectors, header.strsize, size);
-		    size += header.strsize;
-		    if (text != save.stext) {
-			FREE(text);
-		    }
+	    }
+	    data->txtoffset = size;
+	    if (header.strsize > 0) {
+		sw_writev(text, data->sectors, header.strsize, size);
+		size += header.strsize;
+		if (text != save.stext) {
+		    FREE(text);
 		}
 	    }
 
@@ -2390,7 +3333,11 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 	    if (header.ncallouts > 0) {
 		sw_writev((char *) data->scallouts, data->sectors,
 			  header.ncallouts * (Uint) sizeof(scallout), size);
+		size += header.ncallouts * (Uint) sizeof(scallout);
 	    }
+	    data->datasize = size;
+	} else {
+	    data->datasize = 0;
 	}
 
 	d_free_values(data);
@@ -2404,6 +3351,8 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 	data->base.schange = 0;
 	data->base.achange = 0;
     }
+    data->base.strmem = 0;
+    data->base.arrmem = 0;
 
     if (swap) {
 	data->base.flags = 0;
@@ -2414,6 +3363,201 @@ static bool d_save_dataspace(dataspace *data, bool swap)
 }
 
 
+/*
+ * NAME:	data->gc()
+ * DESCRIPTION:	garbage collect the next dataspace in the cycle
+ */
+static bool d_gc(bool swap)
+{
+    bool saved;
+
+    if (gcleft == 0 || gcleft > ndata) {
+	gcleft = ndata;		/* start a new cycle */
+    }
+
+    saved = d_save_dataspace(gcdata, swap);
+    if (saved) {
+	ngcdata++;
+	gcclean = 0;
+    } else {
+	gcclean++;
+    }
+    gcdata = gcdata->gcnext;
+
+    if (--gcleft == 0) {
+	ngccycles++;
+    }
+    return saved;
+}
+
+/*
+ * NAME:	data->memused()
+ * DESCRIPTION:	return the amount of memory in use
+ */
+static size_t d_memused()
+{
+    allocinfo *mem;
+
+    mem = m_info();
+    return mem->smemused + mem->dmemused;
+}
+
+/*
+ * NAME:	data->swapout_dataspace()
+ * DESCRIPTION:	save a dataspace block and remove it from memory
+ */
+static bool d_swapout_dataspace(dataspace *data)
+{
+    size_t mem;
+    bool saved;
+
+    mem = d_memused();
+    saved = d_save_dataspace(data, TRUE);
+    OBJ(data->oindex)->data = (dataspace *) NULL;
+    d_free_dataspace(data);
+    nswapdata++;
+    if (d_memused() < mem) {
+	swapmem += mem - d_memused();
+    }
+    return saved;
+}
+
+/*
+ * NAME:	data->swapout_control()
+ * DESCRIPTION:	save an unused control block and remove it from memory
+ */
+static void d_swapout_control(control *ctrl)
+{
+    size_t mem;
+
+    mem = d_memused();
+    if ((ctrl->sectors == (sector *) NULL &&
+	 !(ctrl->flags & CTRL_COMPILED)) || (ctrl->flags & CTRL_VARMAP)) {
+	d_save_control(ctrl);
+    }
+    OBJ(ctrl->oindex)->ctrl = (control *) NULL;
+    d_free_control(ctrl);
+    nswapctrl++;
+    if (d_memused() < mem) {
+	swapmem += mem - d_memused();
+    }
+}
+
+/*
+ * NAME:	data->data_size()
+ * DESCRIPTION:	estimate the memory used by a dataspace block
+ */
+static Uint d_data_size(dataspace *data)
+{
+    return sizeof(dataspace) + data->nvariables * sizeof(value) +
+	   data->narrays * (sizeof(array) + sizeof(sarray)) +
+	   data->eltsize * sizeof(value) +
+	   data->nstrings * (sizeof(string) + sizeof(sstring)) +
+	   2 * data->strsize + data->ncallouts * sizeof(dcallout) +
+	   data->nsectors * sizeof(sector);
+}
+
+/*
+ * NAME:	data->ctrl_size()
+ * DESCRIPTION:	estimate the memory used by a control block
+ */
+static Uint d_ctrl_size(control *ctrl)
+{
+    return sizeof(control) + ctrl->ninherits * sizeof(dinherit) +
+	   ctrl->imapsz + ctrl->progsize +
+	   ctrl->nstrings * (sizeof(string) + sizeof(dstrconst)) +
+	   ctrl->strsize + ctrl->nfuncdefs * sizeof(dfuncdef) +
+	   ctrl->nvardefs * sizeof(dvardef) + ctrl->nfuncalls * 2L +
+	   ctrl->nsymbols * sizeof(dsymbol) + ctrl->nvariables +
+	   ctrl->nsectors * sizeof(sector);
+}
+
+/*
+ * NAME:	data->score()
+ * DESCRIPTION:	rate a swapout candidate by size, idle time and reload cost
+ */
+static Uint d_score(Uint size, Uint access, Uint cost)
+{
+    size >>= 6;
+    if (size > 0xfffe) {
+	size = 0xfffe;
+    }
+    access = swaptime - access;
+    if (access > 0xfffe) {
+	access = 0xfffe;
+    }
+    return (size + 1) * (access + 1) / cost;
+}
+
+/*
+ * NAME:	data->swapout_budget()
+ * DESCRIPTION:	swap out the least valuable blocks until memory usage is
+ *		within budget, or the per-round limit has been reached
+ */
+static sector d_swapout_budget(unsigned int frag)
+{
+    sector n, i, count;
+    dataspace *data, *dbest;
+    control *ctrl, *cbest;
+    Uint score, dscore, cscore, cost;
+
+    count = 0;
+    for (n = (ndata + nctrl) / frag + 1; n > 0 && d_memused() > budget; --n)
+    {
+	/* best dataspace candidate near the end of the LRU list */
+	dbest = (dataspace *) NULL;
+	dscore = 0;
+	for (data = dtail, i = SWAPWINDOW;
+	     data != (dataspace *) NULL && i > 0; data = data->prev, --i) {
+	    if (data == dhead) {
+		break;	/* leave the most recently used one */
+	    }
+	    cost = 1;
+	    if (data->parser != (struct _parser_ *) NULL) {
+		cost += 2;
+	    }
+	    if (data->ncallouts != 0) {
+		cost++;
+	    }
+	    if (data->base.flags & MOD_ALL) {
+		cost++;
+	    }
+	    score = d_score(d_data_size(data), data->access, cost);
+	    if (score > dscore) {
+		dbest = data;
+		dscore = score;
+	    }
+	}
+
+	/* best unused control block candidate */
+	cbest = (control *) NULL;
+	cscore = 0;
+	for (ctrl = ctail, i = SWAPWINDOW;
+	     ctrl != (control *) NULL && i > 0; ctrl = ctrl->prev, --i) {
+	    if (ctrl->ndata == 0) {
+		score = d_score(d_ctrl_size(ctrl), ctrl->access,
+				(ctrl->flags & CTRL_COMPILED) ? 1 : 2);
+		if (score > cscore) {
+		    cbest = ctrl;
+		    cscore = score;
+		}
+	    }
+	}
+
+	if (dbest != (dataspace *) NULL && dscore >= cscore) {
+	    if (d_swapout_dataspace(dbest)) {
+		count++;
+	    }
+	} else if (cbest != (control *) NULL) {
+	    d_swapout_control(cbest);
+	} else {
+	    break;	/* nothing left to swap out */
+	}
+    }
+
+    return count;
+}
+
 /*
  * NAME:	data->swapout()
  * DESCRIPTION:	Swap out a portion of the control and dataspace blocks in
@@ -2426,52 +3570,97 @@ sector d_swapout(unsigned int frag)
     control *ctrl;
 
     count = 0;
+    swaptime++;
+    gcclean = 0;
 
     if (frag != 0) {
-	/* swap out dataspace blocks */
-	data = dtail;
-	for (n = ndata / frag, n -= (n > 0 && frag != 1); n > 0; --n) {
-	    dataspace *prev;
-
-	    prev = data->prev;
-	    if (d_save_dataspace(data, TRUE)) {
-		count++;
+	if (budget != 0 && frag != 1) {
+	    /* swap out by memory budget */
+	    count = d_swapout_budget(frag);
+	} else {
+	    /* swap out dataspace blocks */
+	    data = dtail;
+	    for (n = ndata / frag, n -= (n > 0 && frag != 1); n > 0; --n) {
+		dataspace *prev;
+
+		prev = data->prev;
+		if (d_swapout_dataspace(data)) {
+		    count++;
+		}
+		data = prev;
 	    }
-	    OBJ(data->oindex)->data = (dataspace *) NULL;
-	    d_free_dataspace(data);
-	    data = prev;
-	}
 
-	/* swap out control blocks */
-	ctrl = ctail;
-	for (n = nctrl / frag; n > 0; --n) {
-	    control *prev;
+	    /* swap out control blocks */
+	    ctrl = ctail;
+	    for (n = nctrl / frag; n > 0; --n) {
+		control *prev;
 
-	    prev = ctrl->prev;
-	    if (ctrl->ndata == 0) {
-		if ((ctrl->sectors == (sector *) NULL &&
-		     !(ctrl->flags & CTRL_COMPILED)) ||
-		    (ctrl->flags & CTRL_VARMAP)) {
-		    d_save_control(ctrl);
+		prev = ctrl->prev;
+		if (ctrl->ndata == 0) {
+		    d_swapout_control(ctrl);
 		}
-		OBJ(ctrl->oindex)->ctrl = (control *) NULL;
-		d_free_control(ctrl);
+		ctrl = prev;
 	    }
-	    ctrl = prev;
 	}
     }
 
     /* perform garbage collection for one dataspace */
-    if (gcdata != (dataspace *) NULL) {
-	if (d_save_dataspace(gcdata, (frag != 0)) && frag != 0) {
-	    count++;
-	}
-	gcdata = gcdata->gcnext;
+    if (gcdata != (dataspace *) NULL && d_gc(frag != 0) && frag != 0) {
+	count++;
     }
 
     return count;
 }
 
+/*
+ * NAME:	data->collect()
+ * DESCRIPTION:	garbage collect dataspaces while idle, for at most one
+ *		time slice.  Return TRUE if there may be more to collect.
+ */
+bool d_collect(unsigned int frag)
+{
+    Uint start, t;
+    unsigned short mstart, m;
+
+    if (gcslice == 0) {
+	return FALSE;
+    }
+
+    start = P_mtime(&mstart);
+    while (gcclean < ndata) {
+	d_gc(frag != 0);
+
+	t = P_mtime(&m);
+	if ((t - start) * 1000L + m - mstart >= gcslice) {
+	    break;
+	}
+    }
+
+    return (gcclean < ndata);
+}
+
+/*
+ * NAME:	data->gcstat()
+ * DESCRIPTION:	return garbage collection statistics
+ */
+void d_gcstat(size_t *stat)
+{
+    stat[0] = ngcdata;
+    stat[1] = ngccycles;
+    stat[2] = (gcleft < ndata) ? gcleft : ndata;
+}
+
+/*
+ * NAME:	data->swapstat()
+ * DESCRIPTION:	return swapout statistics
+ */
+void d_swapstat(size_t *stat)
+{
+    stat[0] = nswapdata;
+    stat[1] = nswapctrl;
+    stat[2] = swapmem;
+}
+
 /*
  * NAME:	data->upgrade_mem()
  * DESCRIPTION:	upgrade all obj and all objects cloned from obj that have
@@ -2749,8 +3938,10 @@ static control *d_conv_control(object *obj)
 	if (header.progsize != 0) {
 	    /* program */
 	    if (header.flags & CMP_TYPE) {
-		ctrl->prog = decompress(ctrl->sectors, sw_conv, header.progsize,
-					size, &ctrl->progsize);
+		ctrl->prog = decompress(ctrl->sectors, sw_conv,
+					header.flags & CMP_TYPE,
+					header.progsize, size,
+					&ctrl->progsize);
 	    } else {
 		ctrl->prog = ALLOC(char, header.progsize);
 		sw_conv(ctrl->prog, ctrl->sectors, header.progsize, size);
@@ -2766,6 +3957,7 @@ static control *d_conv_control(object *obj)
 	    if (header.strsize != 0) {
 		if (header.flags & (CMP_TYPE << 2)) {
 		    ctrl->stext = decompress(ctrl->sectors, sw_conv,
+					     (header.flags >> 2) & CMP_TYPE,
 					     header.strsize, size,
 					     &ctrl->strsize);
 		} else {
@@ -3007,10 +4199,16 @@ static void d_fixobjs(svalue *v, Uint n, Uint *ctab, uindex nobjects)
 static void d_fixdata(dataspace *data, object *obj, Uint *counttab, uindex nobjects)
 {
     scallout *sco;
+    sarray *sa;
     unsigned int n;
 
     d_fixobjs(data->svariables, (Uint) data->nvariables, counttab, nobjects);
-    d_fixobjs(data->selts, data->eltsize, counttab, nobjects);
+    for (n = data->narrays, sa = data->sarrays; n > 0; --n, sa++) {
+	if (SA_PKTYPE(sa) == T_NIL) {
+	    d_fixobjs(data->selts + sa->index, (Uint) sa->size, counttab,
+		      nobjects);
+	}
+    }
     for (n = data->ncallouts, sco = data->scallouts; n > 0; --n, sco++) {
 	if (sco->val[0].type == T_STRING) {
 	    if (sco->nargs > 3) {
@@ -3025,6 +4223,7 @@ static void d_fixdata(dataspace *data, object *obj, Uint *counttab, uindex nobje
 	/* handle object upgrading right away */
 	d_upgrade_clone(data);
     }
+    data->datasize = 0;		/* saved values no longer match swap */
     data->base.flags |= MOD_ALL;
 }
 
@@ -3035,6 +4234,7 @@ static void d_fixdata(dataspace *data, object *obj, Uint *counttab, uindex nobje
 static dataspace *d_conv_dataspace(object *obj, Uint *counttab)
 {
     sdataspace header;
+    sdataoffsets offsets;
     dataspace *data;
     Uint size;
     unsigned int n;
@@ -3063,6 +4263,10 @@ static dataspace *d_conv_dataspace(object *obj, Uint *counttab)
 	size += d_conv((char *) (data->sectors + n), data->sectors, "d",
 		       (Uint) 1, size);
     }
+    if (header.flags & DATA_STABLE) {
+	d_conv((char *) &offsets, data->sectors, so_layout, (Uint) 1, size);
+	size = offsets.varoffset;
+    }
 
     /* variables */
     data->svariables = ALLOC(svalue, header.nvariables);
@@ -3079,6 +4283,9 @@ static dataspace *d_conv_dataspace(object *obj, Uint *counttab)
 
     if (header.narrays != 0) {
 	/* arrays */
+	if (header.flags & DATA_STABLE) {
+	    size = offsets.arroffset;
+	}
 	data->sarrays = ALLOC(sarray, header.narrays);
 	if (conv_type) {
 	    size += d_conv_osarrays(data->sarrays, data->sectors,
@@ -3088,6 +4295,9 @@ static dataspace *d_conv_dataspace(object *obj, Uint *counttab)
 			   header.narrays, size);
 	}
 	if (header.eltsize != 0) {
+	    if (header.flags & DATA_STABLE) {
+		size = offsets.eltoffset;
+	    }
 	    data->selts = ALLOC(svalue, header.eltsize);
 	    if (conv_data) {
 		size += d_conv_oosvalues(data->selts, data->sectors,
@@ -3096,21 +4306,54 @@ static dataspace *d_conv_dataspace(object *obj, Uint *counttab)
 		size += d_conv_osvalues(data->selts, data->sectors,
 					header.eltsize, size);
 	    } else {
-		size += d_conv((char *) data->selts, data->sectors, sv_layout,
-			       header.eltsize, size);
+		sarray *sa;
+		Uint svsize;
+		char *buf;
+
+		svsize = conf_dsize(sv_layout) & 0xff;
+		buf = ALLOC(char, header.eltsize * svsize);
+		sw_conv(buf, data->sectors, header.eltsize * svsize, size);
+		conf_dconv((char *) data->selts, buf, sv_layout, header.eltsize);
+		for (n = header.narrays, sa = data->sarrays; n > 0; --n, sa++) {
+		    if (sa->type & SA_PACKED) {
+			/* packed Ints */
+			conf_dconv((char *) (data->selts + sa->index),
+				   buf + sa->index * svsize, "i",
+				   (Uint) sa->size);
+		    } else if (sa->type & SA_PACKFLT) {
+			/* packed floats: low longwords, then high words */
+			conf_dconv((char *) (data->selts + sa->index),
+				   buf + sa->index * svsize, "i",
+				   (Uint) sa->size);
+			conf_dconv((char *) (data->selts + sa->index) +
+						    sa->size * sizeof(Uint),
+				   buf + sa->index * svsize +
+						    sa->size * sizeof(Uint),
+				   "s", (Uint) sa->size);
+		    }
+		}
+		FREE(buf);
+		size += header.eltsize * svsize;
 	    }
 	}
     }
 
     if (header.nstrings != 0) {
 	/* strings */
+	if (header.flags & DATA_STABLE) {
+	    size = offsets.stroffset;
+	}
 	data->sstrings = ALLOC(sstring, header.nstrings);
 	size += d_conv((char *) data->sstrings, data->sectors, ss_layout,
 		       header.nstrings, size);
 	if (header.strsize != 0) {
+	    if (header.flags & DATA_STABLE) {
+		size = offsets.txtoffset;
+	    }
 	    if (header.flags & CMP_TYPE) {
-		data->stext = decompress(data->sectors, sw_conv, header.strsize,
-					 size, &data->strsize);
+		data->stext = decompress(data->sectors, sw_conv,
+					 header.flags & CMP_TYPE,
+					 header.strsize, size, &data->strsize);
 	    } else {
 		data->stext = ALLOC(char, header.strsize);
 		sw_conv(data->stext, data->sectors, header.strsize, size);
@@ -3124,6 +4367,9 @@ static dataspace *d_conv_dataspace(object *obj, Uint *counttab)
 	unsigned short dummy;
 
 	/* callouts */
+	if (header.flags & DATA_STABLE) {
+	    size = offsets.cooffset;
+	}
 	co_time(&dummy);
 	sco = data->scallouts = ALLOC(scallout, header.ncallouts);
 	if (conv_co1) {
@@ -3251,6 +4497,20 @@ static dataspace *d_conv_dataspace(object *obj, Uint *counttab)
     return data;
 }
 
+/*
+ * NAME:	data->prefetch_obj()
+ * DESCRIPTION:	an object will be restored soon; start reading it ahead
+ */
+void d_prefetch_obj(object *obj)
+{
+    if (obj->ctrl == (control *) NULL) {
+	sw_prefetch(obj->cfirst);
+    }
+    if (obj->data == (dataspace *) NULL) {
+	sw_prefetch(obj->dfirst);
+    }
+}
+
 /*
  * NAME:	data->restore_obj()
  * DESCRIPTION:	restore an object
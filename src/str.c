@@ -25,6 +25,8 @@
 # include "data.h"
 
 # define STR_CHUNK	128
+# define STR_VIEW	64	/* shortest substring view */
+# define STR_TEXT(s)	((char *) ((s) + 1))
 
 typedef struct _strh_ {
     hte chain;			/* hash table chain */
@@ -50,16 +52,17 @@ static int strhchunksz;		/* size of current strh chunk */
 string *str_alloc(char *text, long len)
 {
     string *s;
-    string dummy;
 
     /* allocate string struct & text in one block */
-    s = (string *) ALLOC(char, dummy.text - (char *) &dummy + 1 + len);
+    s = (string *) ALLOC(char, sizeof(string) + 1 + len);
+    s->text = STR_TEXT(s);
     if (text != (char *) NULL && len > 0) {
 	memcpy(s->text, text, (unsigned int) len);
     }
     s->text[s->len = len] = '\0';
     s->ref = 0;
     s->primary = (strref *) NULL;
+    s->parent = (string *) NULL;
 
     return s;
 }
@@ -84,6 +87,9 @@ string *str_new(char *text, long len)
 void str_del(string *s)
 {
     if (--(s->ref) == 0) {
+	if (s->parent != (string *) NULL) {
+	    str_del(s->parent);
+	}
 	FREE(s);
     }
 }
@@ -106,7 +112,7 @@ Uint str_put(string *str, Uint n)
 {
     strh **h;
 
-    h = (strh **) ht_lookup(sht, str->text, FALSE);
+    h = (strh **) ht_lookup(sht, str->text, TRUE);
     for (;;) {
 	/*
 	 * The hasher doesn't handle \0 in strings, and so may not have
@@ -127,8 +133,8 @@ Uint str_put(string *str, Uint n)
 		shlist = l;
 		strhchunksz = 0;
 	    }
-	    s = *h = &shlist->sh[strhchunksz++];
-	    s->chain.next = (hte *) NULL;
+	    s = &shlist->sh[strhchunksz++];
+	    ht_insert(sht, (hte **) h, (hte *) s);
 	    s->chain.name = str->text;
 	    s->str = str;
 	    s->index = n;
@@ -214,6 +220,64 @@ string *str_add(string *s1, string *s2)
     return s;
 }
 
+/*
+ * NAME:	string->extend()
+ * DESCRIPTION:	extend s, which must not be shared, to the given length.  s is
+ *		reallocated with room to spare, so that repeated extensions take
+ *		linear time
+ */
+string *str_extend(string *s, long len)
+{
+    string *t;
+    size_t size, step;
+
+    if (len > (unsigned long) MAX_STRLEN) {
+	error("String too long");
+    }
+
+    /* round up to a multiple of 1/8th to 1/4th of the new size */
+    size = sizeof(string) + 1 + len;
+    for (step = STRAPPENDSTEP; step << 3 <= size; step <<= 1) ;
+    size = (size + step - 1) & ~(step - 1);
+
+    if (s->parent != (string *) NULL) {
+	/* a view: give it text of its own */
+	t = (string *) ALLOC(char, size);
+	memcpy(STR_TEXT(t), s->text, s->len);
+	t->primary = s->primary;
+	t->ref = s->ref;
+	t->len = s->len;
+	t->parent = (string *) NULL;
+	str_del(s->parent);
+	FREE(s);
+	s = t;
+    } else {
+	s = (string *) REALLOC(s, char, sizeof(string) + 1 + s->len, size);
+    }
+    s->text = STR_TEXT(s);
+    s->text[s->len = len] = '\0';
+
+    return s;
+}
+
+/*
+ * NAME:	string->append()
+ * DESCRIPTION:	append s2 to s1, which must not be shared
+ */
+string *str_append(string *s1, string *s2)
+{
+    ssizet len;
+
+    if (s1 == s2) {
+	return str_add(s1, s2);
+    }
+    len = s1->len;
+    s1 = str_extend(s1, (long) len + s2->len);
+    memcpy(s1->text + len, s2->text, s2->len);
+
+    return s1;
+}
+
 /*
  * NAME:	string->index()
  * DESCRIPTION:	index a string
@@ -240,13 +304,32 @@ void str_ckrange(string *s, long l1, long l2)
 
 /*
  * NAME:	string->range()
- * DESCRIPTION:	return a subrange of a string
+ * DESCRIPTION:	return a subrange of a string.  A long final part of a string
+ *		is returned as a view that shares the text of the original,
+ *		unless that would keep more than twice its size in memory
  */
 string *str_range(string *s, long l1, long l2)
 {
+    string *v, *p;
+    long len;
+
     if (l1 < 0 || l1 > l2 + 1 || l2 >= (long) s->len) {
 	error("Invalid string range");
     }
 
-    return str_new(s->text + l1, l2 - l1 + 1);
+    len = l2 - l1 + 1;
+    if (l2 == (long) s->len - 1 && len >= STR_VIEW) {
+	/* the final part of the text is still '\0'-terminated */
+	p = (s->parent != (string *) NULL) ? s->parent : s;
+	if (len << 1 >= (long) p->len) {
+	    v = ALLOC(string, 1);
+	    v->primary = (strref *) NULL;
+	    v->ref = 0;
+	    v->len = len;
+	    v->text = s->text + l1;
+	    str_ref(v->parent = p);
+	    return v;
+	}
+    }
+    return str_new(s->text + l1, len);
 }
@@ -21,7 +21,8 @@ struct _string_ {
     struct _strref_ *primary;	/* primary reference */
     Uint ref;			/* number of references + const bit */
     ssizet len;			/* string length */
-    char text[1];		/* actual characters following this struct */
+    char *text;			/* actual characters */
+    struct _string_ *parent;	/* string viewed, or NULL */
 };
 
 extern string	       *str_alloc	(char*, long);
@@ -35,6 +36,8 @@ extern void		str_clear	(void);
 
 extern int		str_cmp		(string*, string*);
 extern string	       *str_add		(string*, string*);
+extern string	       *str_extend	(string*, long);
+extern string	       *str_append	(string*, string*);
 extern ssizet		str_index	(string*, long);
 extern void		str_ckrange	(string*, long, long);
 extern string	       *str_range	(string*, long, long);
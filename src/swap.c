@@ -21,23 +21,67 @@
 # include "dgd.h"
 # include "swap.h"
 
+typedef struct _slotlist_ {
+    struct _header_ *first;	/* first swap slot */
+    struct _header_ *last;	/* last swap slot */
+    sector n;			/* # swap slots in list */
+} slotlist;
+
 typedef struct _header_ {	/* swap slot header */
     struct _header_ *prev;	/* previous in swap slot list */
     struct _header_ *next;	/* next in swap slot list */
+    slotlist *list;		/* swap slot list this slot is in */
     sector sec;			/* the sector that uses this slot */
     sector swap;		/* the swap sector (if any) */
     bool dirty;			/* has the swap slot been written to? */
 } header;
 
+# define SWP_LRU	0	/* least recently used */
+# define SWP_2Q		1	/* 2Q: FIFO for new sectors, LRU for reused */
+
+# define SW_RUN		64	/* max # sectors in one vectored read/write */
+# define SW_WBSIZE	32	/* max # sectors being written behind */
+# define SW_GROW	64	/* # sectors to extend a mapped swap file by */
+# define SW_CHAIN	16	/* max # snapshots in a chain */
+# define SW_AHEAD	8	/* # sectors to read ahead from a snapshot */
+
+typedef struct {
+    char *buf;			/* copy of the sector */
+    sector swap;		/* swap file sector written to, or SW_UNUSED */
+    Uint seq;			/* sequence number of the write */
+} wbslot;
+
 static char *swapfile;			/* swap file name */
 static int swap;			/* swap file descriptor */
-static int dump;			/* dump file descriptor */
+static int dfd[SW_CHAIN];		/* snapshot file descriptors */
+static char dname[SW_CHAIN][STRINGSZ];	/* snapshot file names */
+static int nchain;			/* # snapshots in chain */
+static int chainsize;			/* max # incremental snapshots */
+static char *dumpname;			/* dump file name */
+static int dsrc;			/* image still to be copied to dump file */
+static off_t dsize;			/* size of image */
+static bool dfull;			/* next snapshot must be a full one */
 static char *mem;			/* swap slots in memory */
 static sector *map, *smap;		/* sector map, swap free map */
+static sector *dmap;			/* sectors in snapshot files */
+static char *dchain;			/* snapshot that a sector is in */
+static char *smem;			/* mapped swap file */
+static bool swmap;			/* map the swap file? */
+static sector sfile;			/* # sectors in mapped swap file */
 static sector mfree, sfree;		/* free sector lists */
 static char *cbuf;			/* sector buffer */
 static sector cached;			/* sector currently cached in cbuf */
-static header *first, *last;		/* first and last swap slot */
+static slotlist lru;			/* LRU list of swap slots */
+static slotlist fifo;			/* FIFO of newly loaded swap slots */
+static int policy;			/* cache replacement policy */
+static sector kin;			/* target size of FIFO */
+static sector *ghost;			/* recently evicted from FIFO */
+static sector *ghosts;			/* ring buffer of evicted sectors */
+static sector kout, gnext;		/* size of ring buffer, next in ring */
+static Uint nhits, nmisses, nevicts;	/* cache statistics */
+static bool wbehind;			/* write behind evicted sectors? */
+static wbslot *wb;			/* ring of sectors being written */
+static int wbnext;			/* next in write-behind ring */
 static header *lfree;			/* free swap slot list */
 static long slotsize;			/* sizeof(header) + size of sector */
 static unsigned int sectorsize;		/* size of sector */
@@ -51,7 +95,7 @@ static sector ssectors;			/* sectors actually in swap file */
  * NAME:	swap->init()
  * DESCRIPTION:	initialize the swap device
  */
-bool sw_init(char *file, unsigned int total, unsigned int cache, unsigned int secsize)
+bool sw_init(char *file, unsigned int total, unsigned int cache, unsigned int secsize, int pol, bool mapped, unsigned int chain)
 {
     header *h;
     sector i;
@@ -69,9 +113,10 @@ bool sw_init(char *file, unsigned int total, unsigned int cache, unsigned int se
 	return 0;
     }
 
-    mem = ALLOC(char, slotsize * cache);
     map = ALLOC(sector, total);
     smap = ALLOC(sector, total);
+    dmap = ALLOC(sector, total);
+    dchain = ALLOC(char, total);
     cbuf = ALLOC(char, secsize);
     cached = SW_UNUSED;
 
@@ -83,6 +128,26 @@ bool sw_init(char *file, unsigned int total, unsigned int cache, unsigned int se
     /* init free sector maps */
     mfree = SW_UNUSED;
     sfree = SW_UNUSED;
+    nhits = nmisses = nevicts = 0;
+    swap = dsrc = -1;
+    nchain = 0;
+    dfull = FALSE;
+    chainsize = chain;
+
+    swmap = mapped;
+    if (swmap) {
+	/*
+	 * The swap file is mapped into memory when created, and sectors
+	 * are accessed in place.  There is no swap cache: caching is left
+	 * to the OS.
+	 */
+	smem = (char *) NULL;
+	policy = SWP_LRU;
+	wbehind = FALSE;
+	return 1;
+    }
+
+    mem = ALLOC(char, slotsize * cache);
     lfree = h = (header *) mem;
     for (i = cache - 1; i > 0; --i) {
 	h->sec = SW_UNUSED;
@@ -93,27 +158,85 @@ bool sw_init(char *file, unsigned int total, unsigned int cache, unsigned int se
     h->next = (header *) NULL;
 
     /* no swap slots in use yet */
-    first = (header *) NULL;
-    last = (header *) NULL;
+    lru.first = lru.last = fifo.first = fifo.last = (header *) NULL;
+    lru.n = fifo.n = 0;
+
+    /* cache replacement policy */
+    policy = pol;
+    if (policy == SWP_2Q) {
+	kin = (cache + 3) / 4;
+	kout = (cache + 1) / 2;
+	ghost = ALLOC(sector, total);
+	for (i = 0; i < total; i++) {
+	    ghost[i] = SW_UNUSED;
+	}
+	ghosts = ALLOC(sector, kout);
+	for (i = 0; i < kout; i++) {
+	    ghosts[i] = SW_UNUSED;
+	}
+	gnext = 0;
+    }
+
+    /* write-behind ring */
+    wbehind = P_wbstart();
+    if (wbehind) {
+	wb = ALLOC(wbslot, SW_WBSIZE);
+	wb[0].buf = ALLOC(char, SW_WBSIZE * secsize);
+	for (i = 0; i < SW_WBSIZE; i++) {
+	    wb[i].buf = wb[0].buf + i * secsize;
+	    wb[i].swap = SW_UNUSED;
+	}
+	wbnext = 0;
+    }
 
-    swap = dump = -1;
     return 1;
 }
 
+/*
+ * NAME:	swap->sync()
+ * DESCRIPTION:	wait until all sectors written behind are in the swap file
+ */
+static bool sw_sync()
+{
+    int i;
+    bool ok;
+
+    ok = TRUE;
+    if (wbehind) {
+	i = ((wbnext == 0) ? SW_WBSIZE : wbnext) - 1;
+	if (wb[i].swap != SW_UNUSED) {
+	    /* the most recent write, which completes after all others */
+	    ok = P_wbwait(wb[i].seq);
+	}
+	for (i = 0; i < SW_WBSIZE; i++) {
+	    wb[i].swap = SW_UNUSED;
+	}
+	wbnext = 0;
+    }
+    return ok;
+}
+
 /*
  * NAME:	swap->finish()
  * DESCRIPTION:	clean up swapfile
  */
 void sw_finish()
 {
+    int i;
+
     if (swap >= 0) {
 	char buf[STRINGSZ];
 
+	if (swmap) {
+	    P_unmapfile(smem, (size_t) (swapsize + 1) * sectorsize);
+	} else {
+	    sw_sync();
+	}
 	P_close(swap);
 	P_unlink(path_native(buf, swapfile));
     }
-    if (dump >= 0) {
-	P_close(dump);
+    for (i = 0; i < nchain; i++) {
+	P_close(dfd[i]);
     }
 }
 
@@ -132,6 +255,146 @@ static void sw_create()
     if (swap < 0 || P_write(swap, cbuf, sectorsize) < 0) {
 	fatal("cannot create swap file \"%s\"", swapfile);
     }
+    if (swmap) {
+	/*
+	 * map room for all sectors; the file itself grows as needed
+	 */
+	smem = P_mapfile(swap, (size_t) (swapsize + 1) * sectorsize);
+	if (smem == (char *) NULL) {
+	    fatal("cannot map swap file \"%s\"", swapfile);
+	}
+	sfile = 0;
+    }
+}
+
+/*
+ * NAME:	swap->write()
+ * DESCRIPTION:	write a swap slot to a sector in the swap file.  With
+ *		write-behind, the sector is copied into the ring and written
+ *		by the I/O thread, and the slot can be reused at once
+ */
+static void sw_write(header *h, sector save)
+{
+    wbslot *w;
+
+    if (wbehind) {
+	w = &wb[wbnext];
+	if (w->swap != SW_UNUSED && !P_wbwait(w->seq)) {
+	    fatal("cannot write swap file");
+	}
+	memcpy(w->buf, h + 1, sectorsize);
+	w->swap = save;
+	w->seq = P_wbwrite(swap, w->buf, sectorsize,
+			   (off_t) (save + 1L) * sectorsize);
+	if (++wbnext == SW_WBSIZE) {
+	    wbnext = 0;
+	}
+    } else {
+	P_lseek(swap, (off_t) (save + 1L) * sectorsize, SEEK_SET);
+	if (P_write(swap, (char *) (h + 1), sectorsize) < 0) {
+	    fatal("cannot write swap file");
+	}
+    }
+}
+
+/*
+ * NAME:	swap->pending()
+ * DESCRIPTION:	return the most recent copy in the write-behind ring of a
+ *		sector in the swap file, if any
+ */
+static char *sw_pending(sector save)
+{
+    int i, n;
+
+    if (wbehind) {
+	for (i = wbnext, n = SW_WBSIZE; n > 0; --n) {
+	    if (i == 0) {
+		i = SW_WBSIZE;
+	    }
+	    if (wb[--i].swap == save) {
+		return wb[i].buf;
+	    }
+	}
+    }
+    return (char *) NULL;
+}
+
+/*
+ * NAME:	swap->unlink()
+ * DESCRIPTION:	remove a swap slot from its list
+ */
+static void sw_unlink(header *h)
+{
+    slotlist *l;
+
+    l = h->list;
+    if (h != l->first) {
+	h->prev->next = h->next;
+    } else {
+	l->first = h->next;
+	if (l->first != (header *) NULL) {
+	    l->first->prev = (header *) NULL;
+	}
+    }
+    if (h != l->last) {
+	h->next->prev = h->prev;
+    } else {
+	l->last = h->prev;
+	if (l->last != (header *) NULL) {
+	    l->last->next = (header *) NULL;
+	}
+    }
+    --l->n;
+}
+
+/*
+ * NAME:	swap->link()
+ * DESCRIPTION:	put a swap slot at the head of a list
+ */
+static void sw_link(header *h, slotlist *l)
+{
+    h->list = l;
+    h->prev = (header *) NULL;
+    h->next = l->first;
+    if (l->first != (header *) NULL) {
+	l->first->prev = h;
+    } else {
+	l->last = h;	/* last was NULL too */
+    }
+    l->first = h;
+    l->n++;
+}
+
+/*
+ * NAME:	swap->position()
+ * DESCRIPTION:	allocate a new sector in the swap file
+ */
+static sector sw_position()
+{
+    sector save;
+
+    if (sfree == SW_UNUSED) {
+	if (swmap && ssectors == sfile) {
+	    /*
+	     * extend the mapped swap file, so that new sectors can be
+	     * accessed through the mapping
+	     */
+	    if (swap < 0) {
+		sw_create();
+	    }
+	    sfile = (swapsize - ssectors > SW_GROW) ?
+		     ssectors + SW_GROW : swapsize;
+	    memset(cbuf, '\0', sectorsize);
+	    P_lseek(swap, (off_t) sfile * sectorsize, SEEK_SET);
+	    if (P_write(swap, cbuf, sectorsize) < 0) {
+		fatal("cannot write swap file");
+	    }
+	}
+	return ssectors++;
+    }
+    save = sfree;
+    sfree = smap[save];
+    return save;
 }
 
 /*
@@ -146,6 +409,7 @@ void sw_newv(sector *vec, unsigned int size)
 	    return;
 	}
 	mfree = map[*vec = mfree];
+	dmap[*vec] = SW_UNUSED;
 	map[*vec++] = SW_UNUSED;
 	--nfree;
 	--size;
@@ -156,6 +420,7 @@ void sw_newv(sector *vec, unsigned int size)
 	if (nsectors == swapsize) {
 	    fatal("out of sectors");
 	}
+	dmap[nsectors] = SW_UNUSED;
 	map[*vec++ = nsectors++] = SW_UNUSED;
 	--size;
     }
@@ -174,7 +439,17 @@ void sw_wipev(sector *vec, unsigned int size)
     while (size > 0) {
 	sec = *--vec;
 	i = map[sec];
-	if (i < cachesize && (h=(header *) (mem + i * slotsize))->sec == sec) {
+	if (swmap || chainsize == 0) {
+	    /*
+	     * also forget about the sector in the snapshot; when keeping
+	     * a chain of snapshots, it may yet be rewritten unchanged
+	     */
+	    dmap[sec] = SW_UNUSED;
+	}
+	if (swmap) {
+	    map[sec] = SW_UNUSED;
+	} else if (i < cachesize &&
+		   (h=(header *) (mem + i * slotsize))->sec == sec) {
 	    i = h->swap;
 	    h->swap = SW_UNUSED;
 	} else {
@@ -207,26 +482,12 @@ void sw_delv(sector *vec, unsigned int size)
     while (size > 0) {
 	sec = *--vec;
 	i = map[sec];
-	if (i < cachesize && (h=(header *) (mem + i * slotsize))->sec == sec) {
+	if (!swmap && i < cachesize &&
+	    (h=(header *) (mem + i * slotsize))->sec == sec) {
 	    /*
-	     * remove the swap slot from the first-last list
+	     * remove the swap slot from its list
 	     */
-	    if (h != first) {
-		h->prev->next = h->next;
-	    } else {
-		first = h->next;
-		if (first != (header *) NULL) {
-		    first->prev = (header *) NULL;
-		}
-	    }
-	    if (h != last) {
-		h->next->prev = h->prev;
-	    } else {
-		last = h->prev;
-		if (last != (header *) NULL) {
-		    last->next = (header *) NULL;
-		}
-	    }
+	    sw_unlink(h);
 	    /*
 	     * put the cache slot in the free cache slot list
 	     */
@@ -235,6 +496,11 @@ void sw_delv(sector *vec, unsigned int size)
 	    lfree = h;
 	}
 
+	if (policy == SWP_2Q) {
+	    ghost[sec] = SW_UNUSED;
+	}
+	dmap[sec] = SW_UNUSED;
+
 	/*
 	 * put sec in free sector list
 	 */
@@ -246,15 +512,48 @@ void sw_delv(sector *vec, unsigned int size)
     }
 }
 
+/*
+ * NAME:	swap->evict()
+ * DESCRIPTION:	select a swap slot to reuse.  With the 2Q policy, sectors
+ *		are evicted from the FIFO of new sectors while it is larger
+ *		than its target size; they are remembered for a while, so
+ *		that they can go straight into the LRU list when needed again
+ */
+static header *sw_evict()
+{
+    header *h;
+
+    if (policy == SWP_2Q && fifo.last != (header *) NULL &&
+	(fifo.n > kin || lru.last == (header *) NULL)) {
+	h = fifo.last;
+	if (ghosts[gnext] != SW_UNUSED && ghost[ghosts[gnext]] == gnext) {
+	    ghost[ghosts[gnext]] = SW_UNUSED;
+	}
+	ghost[ghosts[gnext] = h->sec] = gnext;
+	if (++gnext == kout) {
+	    gnext = 0;
+	}
+    } else {
+	h = lru.last;
+    }
+    sw_unlink(h);
+    nevicts++;
+
+    return h;
+}
+
 /*
  * NAME:	swap->load()
  * DESCRIPTION:	reserve a swap slot for sector sec. If fill == TRUE, load it
- *		from the swap file if appropriate.
+ *		from the swap file or snapshot if appropriate.
  */
-static header *sw_load(sector sec, bool restore, bool fill)
+static header *sw_load(sector sec, bool fill)
 {
     header *h;
+    char *p;
     sector load, save;
+    slotlist *l;
+    int fd;
 
     load = map[sec];
     if (load >= cachesize ||
@@ -262,6 +561,7 @@ static header *sw_load(sector sec, bool restore, bool fill)
 	/*
 	 * the sector is either unused or in the swap file
 	 */
+	nmisses++;
 	if (lfree != (header *) NULL) {
 	    /*
 	     * get swap slot from the free swap slot list
@@ -270,16 +570,10 @@ static header *sw_load(sector sec, bool restore, bool fill)
 	    lfree = h->next;
 	} else {
 	    /*
-	     * No free slot available, use the last one in the swap slot list
+	     * No free slot available, evict one from the swap slot lists
 	     * instead.
 	     */
-	    h = last;
-	    last = h->prev;
-	    if (last != (header *) NULL) {
-		last->next = (header *) NULL;
-	    } else {
-		first = (header *) NULL;
-	    }
+	    h = sw_evict();
 	    save = h->swap;
 	    if (h->dirty) {
 		/*
@@ -290,21 +584,13 @@ static header *sw_load(sector sec, bool restore, bool fill)
 		    /*
 		     * allocate new sector in swap file
 		     */
-		    if (sfree == SW_UNUSED) {
-			save = ssectors++;
-		    } else {
-			save = sfree;
-			sfree = smap[save];
-		    }
+		    save = sw_position();
 		}
 
 		if (swap < 0) {
 		    sw_create();
 		}
-		P_lseek(swap, (off_t) (save + 1L) * sectorsize, SEEK_SET);
-		if (P_write(swap, (char *) (h + 1), sectorsize) < 0) {
-		    fatal("cannot write swap file");
-		}
+		sw_write(h, save);
 	    }
 	    map[h->sec] = save;
 	}
@@ -316,16 +602,15 @@ static header *sw_load(sector sec, bool restore, bool fill)
 	 */
 	map[sec] = ((intptr_t) h - (intptr_t) mem) / slotsize;
 
-	if (load != SW_UNUSED) {
-	    if (restore) {
+	if (!fill) {
+	    /* the caller will fill the slot */
+	} else if (load != SW_UNUSED) {
+	    if ((p=sw_pending(load)) != (char *) NULL) {
 		/*
-		 * load the sector from the dump file
+		 * the sector is still being written to the swap file
 		 */
-		P_lseek(dump, (off_t) (load + 1L) * sectorsize, SEEK_SET);
-		if (P_read(dump, (char *) (h + 1), sectorsize) <= 0) {
-		    fatal("cannot read dump file");
-		}
-	    } else if (fill) {
+		memcpy(h + 1, p, sectorsize);
+	    } else {
 		/*
 		 * load the sector from the swap file
 		 */
@@ -334,56 +619,187 @@ static header *sw_load(sector sec, bool restore, bool fill)
 		    fatal("cannot read swap file");
 		}
 	    }
-	} else if (fill) {
+	} else if (dmap[sec] != SW_UNUSED) {
+	    /*
+	     * load the sector from the snapshot it is in
+	     */
+	    fd = dfd[UCHAR(dchain[sec])];
+	    P_lseek(fd, (off_t) (dmap[sec] + 1L) * sectorsize, SEEK_SET);
+	    if (P_read(fd, (char *) (h + 1), sectorsize) <= 0) {
+		fatal("cannot read dump file");
+	    }
+	} else {
 	    /* zero-fill new sector */
 	    memset(h + 1, '\0', sectorsize);
 	}
+
+	if (policy == SWP_2Q && ghost[sec] == SW_UNUSED) {
+	    l = &fifo;		/* new sector */
+	} else {
+	    l = &lru;
+	    if (policy == SWP_2Q) {
+		ghost[sec] = SW_UNUSED;
+	    }
+	}
     } else {
 	/*
-	 * The sector already had a slot. Remove it from the first-last list.
+	 * The sector already had a slot.
 	 */
-	if (h != first) {
-	    h->prev->next = h->next;
-	} else {
-	    first = h->next;
-	}
-	if (h != last) {
-	    h->next->prev = h->prev;
-	} else {
-	    last = h->prev;
-	    if (last != (header *) NULL) {
-		last->next = (header *) NULL;
-	    }
+	nhits++;
+	l = h->list;
+	if (l == &fifo) {
+	    return h;	/* stays in the FIFO */
 	}
+	sw_unlink(h);
     }
     /*
-     * put the sector at the head of the first-last list
+     * put the sector at the head of its list
      */
-    h->prev = (header *) NULL;
-    h->next = first;
-    if (first != (header *) NULL) {
-	first->prev = h;
-    } else {
-	last = h;	/* last was NULL too */
-    }
-    first = h;
+    sw_link(h, l);
 
     return h;
 }
 
+# ifdef P_preadv
+/*
+ * NAME:	swap->fetch()
+ * DESCRIPTION:	if the next sector of a vector is not in the cache, reserve
+ *		swap slots for it and for the uncached sectors following it
+ *		that are consecutive in the swap file or in a snapshot, and
+ *		read the whole run with a single call
+ */
+static void sw_fetch(sector *vec, sector *end)
+{
+    struct iovec iov[SW_RUN];
+    header *h;
+    sector sec, load, first;
+    unsigned int i, n;
+    int fd, f;
+
+    n = (end > vec) ? end - vec : 0;
+    if (n > cachesize / 8) {
+	n = cachesize / 8;
+    }
+    if (n > SW_RUN) {
+	n = SW_RUN;
+    }
+    if (n < 2) {
+	return;
+    }
+
+    first = SW_UNUSED;
+    fd = -1;
+    for (i = 0; i < n; i++) {
+	sec = *vec++;
+	load = map[sec];
+	if (load == SW_UNUSED) {
+	    load = dmap[sec];
+	    if (load == SW_UNUSED) {
+		break;	/* not in a file */
+	    }
+	    f = dfd[UCHAR(dchain[sec])];
+	} else if (load < cachesize &&
+		   ((header *) (mem + load * slotsize))->sec == sec) {
+	    break;	/* already cached */
+	} else if (sw_pending(load) != (char *) NULL) {
+	    break;	/* still being written */
+	} else {
+	    f = swap;
+	}
+	if (i == 0) {
+	    first = load;
+	    fd = f;
+	} else if (f != fd || load != first + i) {
+	    break;
+	}
+	h = sw_load(sec, FALSE);
+	iov[i].iov_base = (char *) (h + 1);
+	iov[i].iov_len = sectorsize;
+    }
+
+    if (i != 0 &&
+	P_preadv(fd, iov, i, (off_t) (first + 1L) * sectorsize) !=
+						    (ssize_t) i * sectorsize) {
+	fatal((fd == swap) ? "cannot read swap file" : "cannot read dump file");
+    }
+}
+# else
+# define sw_fetch(vec, end)
+# endif
+
+/*
+ * NAME:	swap->sector()
+ * DESCRIPTION:	return a sector in the mapped swap file, allocating it if
+ *		necessary.  A sector still in a snapshot is copied from there
+ */
+static char *sw_sector(sector sec)
+{
+    sector load;
+    char *p;
+    int fd;
+
+    load = map[sec];
+    if (load == SW_UNUSED) {
+	map[sec] = load = sw_position();
+	p = smem + (load + 1L) * sectorsize;
+	if (dmap[sec] != SW_UNUSED) {
+	    /*
+	     * copy the sector from the snapshot
+	     */
+	    fd = dfd[UCHAR(dchain[sec])];
+	    P_lseek(fd, (off_t) (dmap[sec] + 1L) * sectorsize, SEEK_SET);
+	    if (P_read(fd, p, sectorsize) <= 0) {
+		fatal("cannot read dump file");
+	    }
+	    dmap[sec] = SW_UNUSED;
+	} else {
+	    /* zero-fill new sector */
+	    memset(p, '\0', sectorsize);
+	}
+	return p;
+    }
+    return smem + (load + 1L) * sectorsize;
+}
+
+/*
+ * NAME:	swap->end()
+ * DESCRIPTION:	return the end of the sectors to be read into m from a
+ *		vector, or the start if the vector is itself being read
+ */
+static sector *sw_end(char *m, sector *vec, Uint size, Uint idx)
+{
+    sector *end;
+
+    end = vec + (idx + size + sectorsize - 1) / sectorsize;
+    if (m < (char *) end && (char *) vec < m + size) {
+	/* later sectors are not known yet */
+	return vec;
+    }
+    return end;
+}
+
 /*
  * NAME:	swap->readv()
  * DESCRIPTION:	read bytes from a vector of sectors
  */
 void sw_readv(char *m, sector *vec, Uint size, Uint idx)
 {
+    sector *end;
     unsigned int len;
+    char *p;
 
     vec += idx / sectorsize;
     idx %= sectorsize;
+    end = sw_end(m, vec, size, idx);
     do {
 	len = (size > sectorsize - idx) ? sectorsize - idx : size;
-	memcpy(m, (char *) (sw_load(*vec++, FALSE, TRUE) + 1) + idx, len);
+	if (swmap) {
+	    p = sw_sector(*vec++);
+	} else {
+	    sw_fetch(vec, end);
+	    p = (char *) (sw_load(*vec++, TRUE) + 1);
+	}
+	memcpy(m, p + idx, len);
 	idx = 0;
 	m += len;
     } while ((size -= len) > 0);
@@ -396,15 +812,40 @@ void sw_readv(char *m, sector *vec, Uint size, Uint idx)
 void sw_writev(char *m, sector *vec, Uint size, Uint idx)
 {
     header *h;
+    sector sec;
     unsigned int len;
+    char *p;
 
     vec += idx / sectorsize;
     idx %= sectorsize;
     do {
 	len = (size > sectorsize - idx) ? sectorsize - idx : size;
-	h = sw_load(*vec++, FALSE, (len != sectorsize));
-	h->dirty = TRUE;
-	memcpy((char *) (h + 1) + idx, m, len);
+	sec = *vec++;
+	if (swmap) {
+	    p = sw_sector(sec);
+	} else {
+	    h = sw_load(sec, (len != sectorsize ||
+			      (chainsize != 0 && dmap[sec] != SW_UNUSED)));
+	    p = (char *) (h + 1);
+	    if (dmap[sec] != SW_UNUSED &&
+		(chainsize == 0 || memcmp(p + idx, m, len) != 0)) {
+		/* no longer the same as in the snapshot */
+		dmap[sec] = SW_UNUSED;
+	    }
+	    if (dmap[sec] == SW_UNUSED) {
+		h->dirty = TRUE;
+		if (h->swap == SW_UNUSED) {
+		    /*
+		     * allocate a sector in the swap file now, so that the
+		     * sectors of a vector end up in the swap file in the
+		     * order in which they are written, rather than in the
+		     * order of eviction
+		     */
+		    h->swap = sw_position();
+		}
+	    }
+	}
+	memcpy(p + idx, m, len);
 	idx = 0;
 	m += len;
     } while ((size -= len) > 0);
@@ -412,21 +853,35 @@ void sw_writev(char *m, sector *vec, Uint size, Uint idx)
 
 /*
  * NAME:	swap->creadv()
- * DESCRIPTION:	restore ctrl bytes from a vector of sectors in dump file
+ * DESCRIPTION:	restore ctrl bytes from a vector of sectors in dump file.
+ *		Unless a chain of snapshots is kept, the sectors are copied
+ *		to the swap file, as ctrl blocks are not rewritten
  */
 void sw_creadv(char *m, sector *vec, Uint size, Uint idx)
 {
     header *h;
+    sector *end, sec;
     unsigned int len;
+    char *p;
 
     vec += idx / sectorsize;
     idx %= sectorsize;
+    end = sw_end(m, vec, size, idx);
     do {
 	len = (size > sectorsize - idx) ? sectorsize - idx : size;
-	h = sw_load(*vec++, TRUE, FALSE);
-	h->swap = SW_UNUSED;
-	h->dirty = TRUE;
-	memcpy(m, (char *) (h + 1) + idx, len);
+	if (swmap) {
+	    p = sw_sector(*vec++);
+	} else {
+	    sw_fetch(vec, end);
+	    sec = *vec++;
+	    h = sw_load(sec, TRUE);
+	    if (chainsize == 0 && dmap[sec] != SW_UNUSED) {
+		dmap[sec] = SW_UNUSED;
+		h->dirty = TRUE;
+	    }
+	    p = (char *) (h + 1);
+	}
+	memcpy(m, p + idx, len);
 	idx = 0;
 	m += len;
     } while ((size -= len) > 0);
@@ -438,19 +893,10 @@ void sw_creadv(char *m, sector *vec, Uint size, Uint idx)
  */
 void sw_dreadv(char *m, sector *vec, Uint size, Uint idx)
 {
-    header *h;
-    unsigned int len;
-
-    vec += idx / sectorsize;
-    idx %= sectorsize;
-    do {
-	len = (size > sectorsize - idx) ? sectorsize - idx : size;
-	h = sw_load(*vec++, TRUE, FALSE);
-	h->swap = SW_UNUSED;
-	memcpy(m, (char *) (h + 1) + idx, len);
-	idx = 0;
-	m += len;
-    } while ((size -= len) > 0);
+    /*
+     * the sectors stay in the snapshot until the dataspace is rewritten
+     */
+    sw_readv(m, vec, size, idx);
 }
 
 /*
@@ -460,17 +906,19 @@ void sw_dreadv(char *m, sector *vec, Uint size, Uint idx)
 void sw_conv(char *m, sector *vec, Uint size, Uint idx)
 {
     unsigned int len;
+    int fd;
 
     vec += idx / restoresecsize;
     idx %= restoresecsize;
     do {
 	len = (size > restoresecsize - idx) ? restoresecsize - idx : size;
 	if (*vec != cached) {
-	    P_lseek(dump, (off_t) (map[*vec] + 1L) * restoresecsize, SEEK_SET);
-	    if (P_read(dump, cbuf, restoresecsize) <= 0) {
+	    fd = dfd[UCHAR(dchain[*vec])];
+	    P_lseek(fd, (off_t) (dmap[*vec] + 1L) * restoresecsize, SEEK_SET);
+	    if (P_read(fd, cbuf, restoresecsize) <= 0) {
 		fatal("cannot read dump file");
 	    }
-	    map[cached = *vec] = SW_UNUSED;
+	    dmap[cached = *vec] = SW_UNUSED;
 	}
 	vec++;
 	memcpy(m, cbuf + idx, len);
@@ -479,6 +927,81 @@ void sw_conv(char *m, sector *vec, Uint size, Uint idx)
     } while ((size -= len) > 0);
 }
 
+/*
+ * NAME:	swap->prefetch()
+ * DESCRIPTION:	a vector of sectors starting with sec will be read soon;
+ *		if it is still in a snapshot, have the OS start reading it
+ */
+void sw_prefetch(sector sec)
+{
+    sector load;
+
+    if (sec == SW_UNUSED || dmap[sec] == SW_UNUSED) {
+	return;
+    }
+    load = map[sec];
+    if (load < cachesize && ((header *) (mem + load * slotsize))->sec == sec) {
+	return;	/* already cached */
+    }
+    P_readahead(dfd[UCHAR(dchain[sec])], (off_t) (dmap[sec] + 1L) * sectorsize,
+		(size_t) SW_AHEAD * sectorsize);
+}
+
+/*
+ * NAME:	swap->peek()
+ * DESCRIPTION:	read the start of a sector, without loading it into the
+ *		swap cache or changing its position there
+ */
+void sw_peek(char *m, sector sec, Uint size)
+{
+    header *h;
+    sector load;
+    char *p;
+    int fd;
+
+    load = map[sec];
+    if (load != SW_UNUSED) {
+	if (swmap) {
+	    memcpy(m, smem + (load + 1L) * sectorsize, size);
+	    return;
+	}
+	if (load < cachesize &&
+	    (h=(header *) (mem + load * slotsize))->sec == sec) {
+	    /* cached */
+	    memcpy(m, (char *) (h + 1), size);
+	    return;
+	}
+	if ((p=sw_pending(load)) != (char *) NULL) {
+	    /* still being written to the swap file */
+	    memcpy(m, p, size);
+	    return;
+	}
+	P_lseek(swap, (off_t) (load + 1L) * sectorsize, SEEK_SET);
+	if (P_read(swap, m, size) <= 0) {
+	    fatal("cannot read swap file");
+	}
+    } else if (dmap[sec] != SW_UNUSED) {
+	fd = dfd[UCHAR(dchain[sec])];
+	P_lseek(fd, (off_t) (dmap[sec] + 1L) * sectorsize, SEEK_SET);
+	if (P_read(fd, m, size) <= 0) {
+	    fatal("cannot read dump file");
+	}
+    } else {
+	memset(m, '\0', size);
+    }
+}
+
+/*
+ * NAME:	swap->cachestat()
+ * DESCRIPTION:	return swap cache hits, misses and evictions
+ */
+void sw_cachestat(Uint *stat)
+{
+    stat[0] = nhits;
+    stat[1] = nmisses;
+    stat[2] = nevicts;
+}
+
 /*
  * NAME:	swap->mapsize()
  * DESCRIPTION:	count the number of sectors required for size bytes + a map
@@ -509,6 +1032,7 @@ sector sw_count()
 
 
 typedef struct {
+    Uint chain;			/* # previous snapshots in chain */
     Uint secsize;		/* size of swap sector */
     sector nsectors;		/* # sectors */
     sector ssectors;		/* # swap sectors */
@@ -516,7 +1040,7 @@ typedef struct {
     sector mfree;		/* free sector list */
 } dump_header;
 
-static char dh_layout[] = "idddd";
+static char dh_layout[] = "iidddd";
 
 /*
  * NAME:	sector_compare
@@ -589,77 +1113,278 @@ void sw_trim()
 }
 
 /*
- * NAME:	swap->dump()
- * DESCRIPTION:	dump swap file
+ * NAME:	slot_compare
+ * DESCRIPTION: used by qsort to order swap slots by swap file sector
  */
-int sw_dump(char *dumpfile)
+static int slot_compare(const void *pa, const void *pb)
 {
+    sector a = (*(header **) pa)->swap;
+    sector b = (*(header **) pb)->swap;
+
+    if (a > b) {
+	return 1;
+    } else if (a < b) {
+	return -1;
+    } else {
+	return 0;
+    }
+}
+
+/*
+ * NAME:	swap->flush()
+ * DESCRIPTION:	write dirty swap slots to the swap file, writing each run of
+ *		consecutive swap file sectors with a single call
+ */
+static void sw_flush(header **slots, sector n)
+{
+# ifdef P_pwritev
+    struct iovec iov[SW_RUN];
+    sector first, i;
+
+    qsort(slots, n, sizeof(header *), slot_compare);
+    while (n != 0) {
+	first = slots[0]->swap;
+	i = 0;
+	do {
+	    iov[i].iov_base = (char *) (slots[i] + 1);
+	    iov[i].iov_len = sectorsize;
+	} while (++i < n && i < SW_RUN && slots[i]->swap == first + i);
+	if (P_pwritev(swap, iov, i, (off_t) (first + 1L) * sectorsize) !=
+							(ssize_t) i * sectorsize) {
+	    fatal("cannot write swap file");
+	}
+	slots += i;
+	n -= i;
+    }
+# else
     header *h;
-    sector sec;
+
+    while (n != 0) {
+	h = *slots++;
+	P_lseek(swap, (off_t) (h->swap + 1L) * sectorsize, SEEK_SET);
+	if (P_write(swap, (char *) (h + 1), sectorsize) < 0) {
+	    fatal("cannot write swap file");
+	}
+	--n;
+    }
+# endif
+}
+
+/*
+ * NAME:	swap->dmap()
+ * DESCRIPTION:	move the sector map to the snapshot map, leaving only the
+ *		free sector list and the swap slots
+ */
+static void sw_dmap()
+{
+    header *h;
+    sector sec, next, n;
+
+    memcpy(dmap, map, nsectors * sizeof(sector));
+    for (sec = 0; sec < nsectors; sec++) {
+	map[sec] = SW_UNUSED;
+    }
+    for (sec = mfree; sec != SW_UNUSED; sec = next) {
+	next = dmap[sec];
+	map[sec] = next;
+	dmap[sec] = SW_UNUSED;
+    }
+
+    if (!swmap) {
+	/* cached sectors are now the same as in the snapshot */
+	for (h = (header *) mem, n = cachesize; n > 0;
+	     h = (header *) ((char *) h + slotsize), --n) {
+	    if (h->sec != SW_UNUSED) {
+		map[h->sec] = ((intptr_t) h - (intptr_t) mem) / slotsize;
+		h->swap = SW_UNUSED;
+		h->dirty = FALSE;
+	    }
+	}
+    }
+}
+
+/*
+ * NAME:	swap->compact()
+ * DESCRIPTION:	copy the sectors that are still in snapshots to the swap
+ *		file, so that the next snapshot does not depend on them
+ */
+static void sw_compact()
+{
+    header *h;
+    sector sec, load, save;
+    int fd;
+
+    for (sec = 0; sec < nsectors; sec++) {
+	if (dmap[sec] == SW_UNUSED) {
+	    continue;
+	}
+	if (swmap) {
+	    (void) sw_sector(sec);
+	} else {
+	    load = map[sec];
+	    if (load < cachesize &&
+		(h=(header *) (mem + load * slotsize))->sec == sec) {
+		/* write out the cached copy */
+		h->swap = sw_position();
+		h->dirty = TRUE;
+	    } else {
+		fd = dfd[UCHAR(dchain[sec])];
+		P_lseek(fd, (off_t) (dmap[sec] + 1L) * sectorsize, SEEK_SET);
+		if (P_read(fd, cbuf, sectorsize) <= 0) {
+		    fatal("cannot read dump file");
+		}
+		map[sec] = save = sw_position();
+		P_lseek(swap, (off_t) (save + 1L) * sectorsize, SEEK_SET);
+		if (P_write(swap, cbuf, sectorsize) < 0) {
+		    fatal("cannot write swap file");
+		}
+	    }
+	    dmap[sec] = SW_UNUSED;
+	}
+    }
+    cached = SW_UNUSED;
+}
+
+/*
+ * NAME:	swap->dump()
+ * DESCRIPTION:	dump swap file.  A full snapshot contains all sectors; an
+ *		incremental one only those changed since the previous
+ *		snapshot, which is kept as part of a chain.  If the swap file
+ *		cannot be renamed to the dump file and bg is TRUE, copying it
+ *		is left to sw_dumpfd() in the background
+ */
+int sw_dump(char *dumpfile, bool bg)
+{
+    header *h, **dirty;
     char buffer[STRINGSZ + 4], buf1[STRINGSZ], buf2[STRINGSZ], *p, *q;
-    sector n;
+    sector n, ndirty, sec;
     dump_header dh;
+    bool full;
+    int fd, i;
 
-    if (dump >= 0) {
-	P_close(dump);
-    }
-    p = path_native(buf1, dumpfile);
-    sprintf(buffer, "%s.old", dumpfile);
-    q = path_native(buf2, buffer);
-    P_unlink(q);
-    P_rename(p, q);
     if (swap < 0) {
 	sw_create();
+    } else if (!sw_sync()) {
+	fatal("cannot write swap file");
     }
 
-    /* flush the cache and adjust sector map */
-    for (h = last; h != (header *) NULL; h = h->prev) {
-	sec = h->swap;
-	if (h->dirty) {
-	    /*
-	     * Dump the sector to swap file
-	     */
-	    if (sec == SW_UNUSED) {
-		/*
-		 * allocate new sector in swap file
-		 */
-		if (sfree == SW_UNUSED) {
-		    sec = ssectors++;
-		} else {
-		    sec = sfree;
-		    sfree = smap[sec];
-		}
-		h->swap = sec;
+    p = path_native(buf1, dumpfile);
+    full = TRUE;
+    if (nchain != 0 && nchain <= chainsize && !dfull) {
+	/*
+	 * keep the previous snapshot under a new name
+	 */
+	sprintf(dname[nchain - 1], "%s.%d", dumpfile, nchain - 1);
+	q = path_native(buf2, dname[nchain - 1]);
+	P_unlink(q);
+	full = (P_rename(p, q) < 0);
+    }
+    if (full) {
+	/*
+	 * compact the chain, and keep the previous snapshot as the old
+	 * dump file
+	 */
+	if (nchain != 0) {
+	    sw_compact();
+	}
+	for (i = 0; i < nchain; i++) {
+	    P_close(dfd[i]);
+	    if (i < nchain - 1) {
+		/* no longer part of a chain */
+		P_unlink(path_native(buf2, dname[i]));
 	    }
-	    P_lseek(swap, (off_t) (sec + 1L) * sectorsize, SEEK_SET);
-	    if (P_write(swap, (char *) (h + 1), sectorsize) < 0) {
-		fatal("cannot write swap file");
+	}
+	nchain = 0;
+	dfull = FALSE;
+	sprintf(buffer, "%s.old", dumpfile);
+	q = path_native(buf2, buffer);
+	P_unlink(q);
+	P_rename(p, q);
+    }
+
+    if (swmap) {
+	/*
+	 * the sector map is up to date; write out the mapped swap file,
+	 * including the unused sectors at its end
+	 */
+	P_msync(smem, (size_t) (sfile + 1) * sectorsize);
+	P_unmapfile(smem, (size_t) (swapsize + 1) * sectorsize);
+	smem = (char *) NULL;
+	ssectors = sfile;
+	sfile = 0;
+    } else {
+	/* flush the cache and adjust sector map */
+	dirty = ALLOC(header*, cachesize);
+	ndirty = 0;
+	for (h = (header *) mem, n = cachesize; n > 0;
+	     h = (header *) ((char *) h + slotsize), --n) {
+	    if (h->sec == SW_UNUSED) {
+		continue;	/* free slot */
+	    }
+	    if (h->dirty) {
+		if (h->swap == SW_UNUSED) {
+		    /*
+		     * allocate new sector in swap file
+		     */
+		    h->swap = sw_position();
+		}
+		dirty[ndirty++] = h;
 	    }
+	    map[h->sec] = h->swap;
 	}
-	map[h->sec] = sec;
+	sw_flush(dirty, ndirty);
+	FREE(dirty);
     }
 
     sw_trim();
 
+    /* sectors that are unchanged remain in the previous snapshots */
+    for (sec = 0; sec < nsectors; sec++) {
+	if (dmap[sec] != SW_UNUSED) {
+	    map[sec] = dmap[sec];
+	} else {
+	    dchain[sec] = nchain;
+	}
+    }
+
     /* move to dumpfile */
     P_close(swap);
     q = path_native(buf2, swapfile);
-    if (P_rename(q, p) < 0) {
+    dumpname = dumpfile;
+    if (P_rename(q, p) >= 0) {
+	/*
+	 * The rename succeeded; reopen the new dumpfile.
+	 */
+	fd = P_open(p, O_RDWR | O_BINARY, 0);
+	if (fd < 0) {
+	    fatal("cannot reopen dump file");
+	}
+    } else if (bg) {
+	/*
+	 * The rename failed.  Use the image where it is, until it has
+	 * been copied to the dumpfile.
+	 */
+	fd = P_open(q, O_RDWR | O_BINARY, 0);
+	dsrc = P_open(q, O_RDONLY | O_BINARY, 0);
+	if (fd < 0 || dsrc < 0) {
+	    fatal("cannot reopen swap file");
+	}
+    } else {
 	/*
 	 * The rename failed.  Attempt to copy the dumpfile instead.
 	 * This will take a long, long while, so keep the swapfile and
 	 * dumpfile on the same file system if at all possible.
 	 */
 	swap = P_open(q, O_RDWR | O_BINARY, 0);
-	dump = P_open(p, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0600);
-	if (swap < 0 || dump < 0) {
+	fd = P_open(p, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0600);
+	if (swap < 0 || fd < 0) {
 	    fatal("cannot move swap file");
 	}
 	/* copy initial sector */
 	if (P_read(swap, cbuf, sectorsize) <= 0) {
 	    fatal("cannot read swap file");
 	}
-	if (P_write(dump, cbuf, sectorsize) < 0) {
+	if (P_write(fd, cbuf, sectorsize) < 0) {
 	    fatal("cannot write dump file");
 	}
 	/* copy swap sectors */
@@ -667,69 +1392,153 @@ int sw_dump(char *dumpfile)
 	    if (P_read(swap, cbuf, sectorsize) <= 0) {
 		fatal("cannot read swap file");
 	    }
-	    if (P_write(dump, cbuf, sectorsize) < 0) {
+	    if (P_write(fd, cbuf, sectorsize) < 0) {
 		fatal("cannot write dump file");
 	    }
 	}
 	P_close(swap);
-    } else {
-	/*
-	 * The rename succeeded; reopen the new dumpfile.
-	 */
-	dump = P_open(p, O_RDWR | O_BINARY, 0);
-	if (dump < 0) {
-	    fatal("cannot reopen dump file");
-	}
     }
     swap = -1;
 
     /* write header */
+    dh.chain = nchain;
     dh.secsize = sectorsize;
     dh.nsectors = nsectors;
     dh.ssectors = ssectors;
     dh.nfree = nfree;
     dh.mfree = mfree;
-    P_lseek(dump, sectorsize - (off_t) sizeof(dump_header), SEEK_SET);
-    if (P_write(dump, (char *) &dh, sizeof(dump_header)) < 0) {
+    P_lseek(fd, sectorsize - (off_t) sizeof(dump_header), SEEK_SET);
+    if (P_write(fd, (char *) &dh, sizeof(dump_header)) < 0) {
 	fatal("cannot write swap header to dump file");
     }
 
     /* write map */
-    P_lseek(dump, (off_t) (ssectors + 1L) * sectorsize, SEEK_SET);
-    if (P_write(dump, (char *) map, nsectors * sizeof(sector)) < 0) {
+    P_lseek(fd, (off_t) (ssectors + 1L) * sectorsize, SEEK_SET);
+    if (P_write(fd, (char *) map, nsectors * sizeof(sector)) < 0) {
 	fatal("cannot write sector map to dump file");
     }
+    if (nchain != 0) {
+	/* write chain */
+	if (P_write(fd, dchain, nsectors) < 0 ||
+	    P_write(fd, dname[0], nchain * STRINGSZ) < 0) {
+	    fatal("cannot write snapshot chain to dump file");
+	}
+    }
+
+    dsize = P_lseek(fd, (off_t) 0, SEEK_CUR);
 
     /* fix the sector map */
-    for (h = last; h != (header *) NULL; h = h->prev) {
-	map[h->sec] = ((intptr_t) h - (intptr_t) mem) / slotsize;
-	h->dirty = FALSE;
-    }
+    sw_dmap();
+    dfd[nchain++] = fd;
 
     ssectors = 0;
     sfree = SW_UNUSED;
     cached = SW_UNUSED;
 
-    return dump;
+    return fd;
+}
+
+/*
+ * NAME:	swap->dumpfd()
+ * DESCRIPTION:	return a new descriptor for the dump file just created by
+ *		sw_dump(), positioned for the rest of the snapshot, after
+ *		copying the image to the dumpfile if needed
+ */
+int sw_dumpfd()
+{
+    char buf[STRINGSZ];
+    off_t size;
+    unsigned int n;
+    int fd;
+
+    if (dsrc < 0) {
+	fd = P_open(path_native(buf, dumpname), O_RDWR | O_BINARY, 0);
+	if (fd < 0) {
+	    fatal("cannot reopen dump file");
+	}
+	P_lseek(fd, dsize, SEEK_SET);
+    } else {
+	/*
+	 * copy the image to the dumpfile
+	 */
+	fd = P_open(path_native(buf, dumpname),
+		    O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0600);
+	if (fd < 0) {
+	    fatal("cannot move swap file");
+	}
+	P_lseek(dsrc, (off_t) 0, SEEK_SET);
+	for (size = dsize; size != 0; size -= n) {
+	    n = (size > sectorsize) ? sectorsize : size;
+	    if (P_read(dsrc, cbuf, n) != (int) n) {
+		fatal("cannot read swap file");
+	    }
+	    if (P_write(fd, cbuf, n) != (int) n) {
+		fatal("cannot write dump file");
+	    }
+	}
+    }
+
+    return fd;
+}
+
+/*
+ * NAME:	swap->dumped()
+ * DESCRIPTION:	the snapshot has been written.  If the image had to be
+ *		copied, use the dumpfile from now on.  If writing the
+ *		snapshot failed, do not build on it
+ */
+void sw_dumped(bool ok)
+{
+    char buf[STRINGSZ];
+    int fd;
+
+    if (!ok) {
+	dfull = TRUE;
+    } else if (dsrc >= 0) {
+	fd = P_open(path_native(buf, dumpname), O_RDONLY | O_BINARY, 0);
+	if (fd < 0) {
+	    fatal("cannot reopen dump file");
+	}
+	P_close(dfd[nchain - 1]);
+	dfd[nchain - 1] = fd;
+    }
+    if (dsrc >= 0) {
+	P_close(dsrc);
+	dsrc = -1;
+    }
 }
 
 /*
  * NAME:	swap->restore()
- * DESCRIPTION:	restore dump file
+ * DESCRIPTION:	restore dump file, and the snapshots it depends on
  */
-void sw_restore(int fd, unsigned int secsize)
+void sw_restore(int fd, unsigned int secsize, int conv)
 {
     dump_header dh;
+    char buf[STRINGSZ];
+    int i;
 
     /* restore swap header */
-    P_lseek(fd, (off_t) secsize - (conf_dsize(dh_layout) & 0xff), SEEK_SET);
-    conf_dread(fd, (char *) &dh, dh_layout, (Uint) 1);
+    if (conv) {
+	/* older header without a chain */
+	P_lseek(fd, (off_t) secsize - (conf_dsize(dh_layout + 1) & 0xff),
+		SEEK_SET);
+	conf_dread(fd, (char *) &dh.secsize, dh_layout + 1, (Uint) 1);
+	dh.chain = 0;
+    } else {
+	P_lseek(fd, (off_t) secsize - (conf_dsize(dh_layout) & 0xff),
+		SEEK_SET);
+	conf_dread(fd, (char *) &dh, dh_layout, (Uint) 1);
+    }
     if (dh.secsize != secsize) {
 	error("Wrong sector size (%d)", dh.secsize);
     }
     if (dh.nsectors > swapsize) {
 	error("Too many sectors in restore file (%d)", dh.nsectors);
     }
+    if (dh.chain >= SW_CHAIN) {
+	error("Too many snapshots in chain (%d)", dh.chain);
+    }
     restoresecsize = secsize;
     if (secsize > sectorsize) {
 	cbuf = REALLOC(cbuf, char, 0, secsize);
@@ -744,5 +1553,24 @@ void sw_restore(int fd, unsigned int secsize)
     mfree = dh.mfree;
     nfree = dh.nfree;
 
-    dump = fd;
+    if (dh.chain != 0) {
+	/* restore chain */
+	if (P_read(fd, dchain, nsectors) != nsectors ||
+	    P_read(fd, dname[0], dh.chain * STRINGSZ) != dh.chain * STRINGSZ) {
+	    error("Cannot restore snapshot chain");
+	}
+	for (i = 0; i < dh.chain; i++) {
+	    dname[i][STRINGSZ - 1] = '\0';
+	    dfd[i] = P_open(path_native(buf, dname[i]), O_RDONLY | O_BINARY,
+			    0);
+	    if (dfd[i] < 0) {
+		error("Cannot open snapshot \"%s\"", dname[i]);
+	    }
+	    nchain++;
+	}
+    } else {
+	memset(dchain, '\0', nsectors);
+    }
+    dfd[nchain++] = fd;
+    sw_dmap();
 }
@@ -18,7 +18,7 @@
  */
 
 extern bool	sw_init		(char*, unsigned int, unsigned int,
-				   unsigned int);
+				   unsigned int, int, bool, unsigned int);
 extern void	sw_finish	(void);
 extern void	sw_newv		(sector*, unsigned int);
 extern void	sw_wipev	(sector*, unsigned int);
@@ -28,8 +28,13 @@ extern void	sw_writev	(char*, sector*, Uint, Uint);
 extern void	sw_creadv	(char*, sector*, Uint, Uint);
 extern void	sw_dreadv	(char*, sector*, Uint, Uint);
 extern void	sw_conv		(char*, sector*, Uint, Uint);
+extern void	sw_prefetch	(sector);
+extern void	sw_peek		(char*, sector, Uint);
 extern sector	sw_mapsize	(unsigned int);
 extern sector	sw_count	(void);
+extern void	sw_cachestat	(Uint*);
 extern bool	sw_copy		(Uint);
-extern int	sw_dump		(char*);
-extern void	sw_restore	(int, unsigned int);
+extern int	sw_dump		(char*, bool);
+extern int	sw_dumpfd	(void);
+extern void	sw_dumped	(bool);
+extern void	sw_restore	(int, unsigned int, int);